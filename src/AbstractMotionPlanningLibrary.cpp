@@ -4,9 +4,14 @@ namespace motion_planning_libraries
 {
 
 // PUBLIC
-AbstractMotionPlanningLibrary::AbstractMotionPlanningLibrary(Config config) : 
+AbstractMotionPlanningLibrary::AbstractMotionPlanningLibrary(Config const& config) : 
         mConfig(config),
-        mPathCost(nan(""))
+        mPathCost(nan("")),
+        mImprovedSolutionCallback(),
+        mProgressCallback(),
+        mpPreprocessedMap(),
+        mCancelMutex(),
+        mCancelRequested(false)
 {
 }
 
@@ -1,6 +1,10 @@
 #ifndef _ABSTRACT_MOTION_PLANNING_LIBRARY_HPP_
 #define _ABSTRACT_MOTION_PLANNING_LIBRARY_HPP_
 
+#include <boost/function.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include <base/samples/RigidBodyState.hpp>
 #include <base/Waypoint.hpp>
 #include <base/Trajectory.hpp>
@@ -9,6 +13,7 @@
 #include <envire/maps/TraversabilityGrid.hpp>
 
 #include "Config.hpp"
+#include "PreprocessedMap.hpp"
 #include "State.hpp"
 
 namespace motion_planning_libraries
@@ -31,6 +36,18 @@ struct CellUpdate {
     }
 };
 
+/**
+ * Called by the planning library during solve() each time an improved
+ * solution is available, see AbstractMotionPlanningLibrary::setImprovedSolutionCallback().
+ */
+typedef boost::function<void ()> ImprovedSolutionCallback;
+
+/**
+ * Called by the planning library during solve() after each part of the search
+ * (e.g. each time slice of SBPL), see AbstractMotionPlanningLibrary::setProgressCallback().
+ */
+typedef boost::function<void ()> ProgressCallback;
+
 /**
  * Base class for a motion planning library.
  */
@@ -39,9 +56,18 @@ class AbstractMotionPlanningLibrary
  protected: 
     Config mConfig;
     double mPathCost;
+    ImprovedSolutionCallback mImprovedSolutionCallback;
+    ProgressCallback mProgressCallback;
+    // Shared map data, see setPreprocessedMap().
+    boost::shared_ptr<const PreprocessedMap> mpPreprocessedMap;
+    
+ private:
+    // Set by cancel() from another thread, see isCancelRequested().
+    boost::mutex mCancelMutex;
+    bool mCancelRequested;
         
  public: 
-    AbstractMotionPlanningLibrary(Config config = Config());
+    AbstractMotionPlanningLibrary(Config const& config = Config());
     virtual ~AbstractMotionPlanningLibrary();
                 
     /**
@@ -52,6 +78,15 @@ class AbstractMotionPlanningLibrary
     virtual bool initialize(envire::TraversabilityGrid* trav_grid,
             boost::shared_ptr<TravData> grid_data);
             
+    /**
+     * Attaches the map data which is shared with other planners, has to be
+     * called before initialize(). The libraries use its derived data 
+     * (see getPreprocessedMap()) instead of creating their own.
+     */
+    void setPreprocessedMap(boost::shared_ptr<const PreprocessedMap> preprocessed_map) {
+        mpPreprocessedMap = preprocessed_map;
+    }
+    
     /**
      * Contains a partial map update to avoid a full reinitialisation. 
      * This method will be called instead of 'initialize' 
@@ -73,7 +108,7 @@ class AbstractMotionPlanningLibrary
      * This method is only called if a new pose has been received 
      * (REPLANNING_XXXX_THRESHOLDs are used).
      */
-    virtual bool setStartGoal(struct State start_state, struct State goal_state) = 0;
+    virtual bool setStartGoal(struct State const& start_state, struct State const& goal_state) = 0;
     
     /**
      * Tries to find a solution (if the environment has just been initialized) 
@@ -122,6 +157,136 @@ class AbstractMotionPlanningLibrary
     virtual bool foundFinalSolution() {
         return true;
     }
+    
+    /**
+     * Returns the number of state expansions of the last solve() call
+     * which can be used to compare search efforts. 
+     * By default -1 is returned (not available).
+     */
+    virtual int getNumExpansions() {
+        return -1;
+    }
+    
+    /**
+     * Returns the suboptimality bound of the current solution 
+     * (e.g. epsilon of the SBPL anytime planners).
+     * By default nan is returned (not available).
+     */
+    virtual double getEpsilon() {
+        return nan("");
+    }
+    
+    /**
+     * Can be implemented by libraries which support searching from the goal 
+     * to the start (see Sbpl::setForwardSearch()). 
+     * \return false if the direction could not be changed.
+     */
+    virtual bool setForwardSearch(bool forward) {
+        return false;
+    }
+    
+    /**
+     * Current search direction, libraries without backward search
+     * always search forward.
+     */
+    virtual bool isForwardSearch() {
+        return true;
+    }
+    
+    /**
+     * Can be implemented by multi-query planners to store their roadmap
+     * (see Ompl::saveRoadmap()).
+     * \return false if the roadmap could not be stored or it is not supported.
+     */
+    virtual bool saveRoadmap(std::string filename) {
+        return false;
+    }
+    
+    /**
+     * Number of vertices of the roadmap of a multi-query planner,
+     * 0 if not supported.
+     */
+    virtual unsigned int getNumRoadmapVertices() {
+        return 0;
+    }
+    
+    /**
+     * Registers a callback which is called within solve() for each improved 
+     * solution (anytime planners). Within the callback fillPath() and getCost() 
+     * already return the improved solution. Pass an empty function to remove 
+     * the callback.
+     */
+    void setImprovedSolutionCallback(ImprovedSolutionCallback callback) {
+        mImprovedSolutionCallback = callback;
+    }
+    
+    /**
+     * Registers a callback which is called within solve() whenever the search
+     * effort (getNumExpansions()) has been updated, independent of a new solution.
+     * Only SBPL reports its progress (after each SBPL_TIME_SLICE), OMPL
+     * does not provide intermediate search statistics.
+     * Pass an empty function to remove the callback.
+     */
+    void setProgressCallback(ProgressCallback callback) {
+        mProgressCallback = callback;
+    }
+    
+    /**
+     * Can be called from another thread to stop a running solve() as soon 
+     * as possible. solve() keeps the best solution found so far. The request 
+     * stays active until resetCancel() is called, so it also stops a 
+     * solve() which has not been started yet.
+     */
+    void cancel() {
+        boost::lock_guard<boost::mutex> lock(mCancelMutex);
+        mCancelRequested = true;
+    }
+    
+    void resetCancel() {
+        boost::lock_guard<boost::mutex> lock(mCancelMutex);
+        mCancelRequested = false;
+    }
+    
+    /**
+     * Has to be polled by the planning libraries during solve().
+     */
+    bool isCancelRequested() {
+        boost::lock_guard<boost::mutex> lock(mCancelMutex);
+        return mCancelRequested;
+    }
+    
+ protected:
+    /**
+     * Has to be called by the planning libraries if an improved solution
+     * is available, the internal path and mPathCost have to be updated before.
+     */
+    void notifyImprovedSolution() {
+        if(mImprovedSolutionCallback) {
+            mImprovedSolutionCallback();
+        }
+    }
+    
+    /**
+     * Has to be called by the planning libraries after getNumExpansions() 
+     * has been updated during solve().
+     */
+    void notifyProgress() {
+        if(mProgressCallback) {
+            mProgressCallback();
+        }
+    }
+    
+    /**
+     * Returns the attached preprocessed map if the passed grid data belongs
+     * to it, otherwise an empty pointer.
+     */
+    boost::shared_ptr<const PreprocessedMap> getPreprocessedMap(
+            boost::shared_ptr<TravData> grid_data) {
+        if(mpPreprocessedMap && mpPreprocessedMap->getTravData() == grid_data) {
+            return mpPreprocessedMap;
+        }
+        return boost::shared_ptr<const PreprocessedMap>();
+    }
 };
 
 } // end namespace motion_planning_libraries
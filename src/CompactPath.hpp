@@ -0,0 +1,191 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_COMPACT_PATH_HPP_
+#define _MOTION_PLANNING_LIBRARIES_COMPACT_PATH_HPP_
+
+#include <vector>
+
+#include <base/Waypoint.hpp>
+
+#include "State.hpp"
+
+namespace motion_planning_libraries
+{
+
+/**
+ * Planned path as structure of arrays. Only contains what the planners
+ * actually produce (x, y, z, theta, speed, prim id, movement type, footprint
+ * radius or the joint angles), so a path does not carry a complete
+ * RigidBodyState per state. Used within MotionPlanningLibraries and returned
+ * by reference, the conversion to State or base::Waypoint is only done
+ * on request.
+ * All states of a path have the same type.
+ */
+struct CompactPath {
+ public:
+    enum StateType mStateType;
+    std::vector<double> mX;
+    std::vector<double> mY;
+    std::vector<double> mZ;
+    std::vector<double> mTheta;
+    std::vector<double> mSpeed;
+    std::vector<int> mSBPLPrimId;
+    std::vector<enum MovementType> mMovType;
+    std::vector<double> mFootprintRadius;
+    // STATE_ARM: mNumJoints angles per state, stored state by state.
+    unsigned int mNumJoints;
+    std::vector<double> mJointAngles;
+
+    CompactPath() : mStateType(STATE_EMPTY),
+            mX(), mY(), mZ(), mTheta(),
+            mSpeed(),
+            mSBPLPrimId(),
+            mMovType(),
+            mFootprintRadius(),
+            mNumJoints(0),
+            mJointAngles() {
+    }
+
+    inline size_t size() const {
+        return mSpeed.size();
+    }
+
+    inline bool empty() const {
+        return mSpeed.empty();
+    }
+
+    /**
+     * Keeps the allocated memory.
+     */
+    void clear() {
+        mStateType = STATE_EMPTY;
+        mX.clear(); mY.clear(); mZ.clear(); mTheta.clear();
+        mSpeed.clear();
+        mSBPLPrimId.clear();
+        mMovType.clear();
+        mFootprintRadius.clear();
+        mNumJoints = 0;
+        mJointAngles.clear();
+    }
+
+    void reserve(size_t num_states) {
+        mX.reserve(num_states); mY.reserve(num_states);
+        mZ.reserve(num_states); mTheta.reserve(num_states);
+        mSpeed.reserve(num_states);
+        mSBPLPrimId.reserve(num_states);
+        mMovType.reserve(num_states);
+        mFootprintRadius.reserve(num_states);
+    }
+
+    /**
+     * Appends a pose or arm state, a state of another type than the
+     * already contained ones is ignored.
+     */
+    void push_back(State& state) {
+        if(mStateType == STATE_EMPTY) {
+            mStateType = state.getStateType();
+            mNumJoints = state.getNumJoints();
+        }
+        if(state.getStateType() != mStateType || mStateType == STATE_EMPTY) {
+            LOG_WARN("State of type %d cannot be added to a path of type %d",
+                    state.getStateType(), mStateType);
+            return;
+        }
+        if(mStateType == STATE_POSE) {
+            mX.push_back(state.mPose.position.x());
+            mY.push_back(state.mPose.position.y());
+            mZ.push_back(state.mPose.position.z());
+            mTheta.push_back(state.mPose.getYaw());
+        } else {
+            mJointAngles.insert(mJointAngles.end(),
+                    state.mJointAngles.begin(), state.mJointAngles.end());
+        }
+        pushBackProperties(state);
+    }
+
+    /**
+     * Appends the pose, the other properties are taken from the state.
+     */
+    void push_back(double x, double y, double z, double theta, State& state) {
+        mStateType = STATE_POSE;
+        mX.push_back(x);
+        mY.push_back(y);
+        mZ.push_back(z);
+        mTheta.push_back(theta);
+        pushBackProperties(state);
+    }
+
+    void append(const CompactPath& path) {
+        if(path.empty()) {
+            return;
+        }
+        if(empty()) {
+            *this = path;
+            return;
+        }
+        mX.insert(mX.end(), path.mX.begin(), path.mX.end());
+        mY.insert(mY.end(), path.mY.begin(), path.mY.end());
+        mZ.insert(mZ.end(), path.mZ.begin(), path.mZ.end());
+        mTheta.insert(mTheta.end(), path.mTheta.begin(), path.mTheta.end());
+        mSpeed.insert(mSpeed.end(), path.mSpeed.begin(), path.mSpeed.end());
+        mSBPLPrimId.insert(mSBPLPrimId.end(), path.mSBPLPrimId.begin(), path.mSBPLPrimId.end());
+        mMovType.insert(mMovType.end(), path.mMovType.begin(), path.mMovType.end());
+        mFootprintRadius.insert(mFootprintRadius.end(),
+                path.mFootprintRadius.begin(), path.mFootprintRadius.end());
+        mJointAngles.insert(mJointAngles.end(), path.mJointAngles.begin(), path.mJointAngles.end());
+    }
+
+    inline base::Position getPosition(size_t i) const {
+        return base::Position(mX[i], mY[i], mZ[i]);
+    }
+
+    inline base::Orientation getOrientation(size_t i) const {
+        return base::Orientation(Eigen::AngleAxisd(mTheta[i], Eigen::Vector3d::UnitZ()));
+    }
+
+    State getState(size_t i) const {
+        State state;
+        if(mStateType == STATE_POSE) {
+            base::samples::RigidBodyState rbs;
+            rbs.position = getPosition(i);
+            rbs.orientation = getOrientation(i);
+            state.setPose(rbs);
+        } else if(mStateType == STATE_ARM) {
+            std::vector<double> joint_angles(mJointAngles.begin() + i * mNumJoints,
+                    mJointAngles.begin() + (i+1) * mNumJoints);
+            state.setJointAngles(joint_angles);
+        }
+        state.mSpeed = mSpeed[i];
+        state.mSBPLPrimId = mSBPLPrimId[i];
+        state.mMovType = mMovType[i];
+        state.mFootprintRadius = mFootprintRadius[i];
+        return state;
+    }
+
+    void getStates(std::vector<State>& states) const {
+        states.clear();
+        states.reserve(size());
+        for(size_t i=0; i<size(); ++i) {
+            states.push_back(getState(i));
+        }
+    }
+
+    base::Waypoint getWaypoint(size_t i) const {
+        base::Waypoint waypoint;
+        if(mStateType == STATE_POSE) {
+            waypoint.position = getPosition(i);
+            waypoint.heading = mTheta[i];
+        }
+        return waypoint;
+    }
+
+ private:
+    void pushBackProperties(State& state) {
+        mSpeed.push_back(state.mSpeed);
+        mSBPLPrimId.push_back(state.mSBPLPrimId);
+        mMovType.push_back(state.mMovType);
+        mFootprintRadius.push_back(state.mFootprintRadius);
+    }
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_COMPACT_PATH_HPP_
@@ -23,6 +23,13 @@ enum EnvType {
     ENV_SHERPA
 };
 
+// Defines how OMPL connects the states of ENV_XYTHETA.
+enum OmplSteeringType {
+    STEERING_CONTROL, // Control planners, propagates the controls with an ODE.
+    STEERING_DUBINS, // Geometric planners, forward driving car (DubinsStateSpace).
+    STEERING_REEDS_SHEPP // Geometric planners, forward and backward driving car (ReedsSheppStateSpace).
+};
+
 enum MovementType {
     MOV_UNDEFINED,
     MOV_FORWARD,
@@ -37,12 +44,24 @@ enum MovementType {
 
 extern std::string MovementTypesString[];
 
-/// \todo "Add OMPL planners"
 enum Planners {
     UNDEFINED_PLANNER, // Let the environment decide.
+    // SBPL
     ANYTIME_DSTAR, // AD*
     ANYTIME_NONPARAMETRIC_ASTAR, // ANA*
-    ANYTIME_ASTAR // ARA*
+    ANYTIME_ASTAR, // ARA*
+    // OMPL geometric (ENV_XY, ENV_SHERPA, ENV_ARM)
+    RRT_CONNECT,
+    RRT_STAR,
+    INFORMED_RRT_STAR,
+    BIT_STAR,
+    RRT_SHARP, // RRT#
+    PRM_STAR,
+    LAZY_PRM_STAR,
+    // OMPL geometric and control (ENV_XYTHETA)
+    KPIECE,
+    // OMPL control (ENV_XYTHETA)
+    SST
 };
 
 enum MplErrors {
@@ -166,13 +185,21 @@ struct Replanning {
     // Especially for SBPL XYTHETA this parameter is meaningful by preventing unwanted 
     // circle paths.
     double mReplanMinDistStartGoal;
+    // If set to true a new map (mReplanOnNewMap) only initiates a replanning if
+    // the footprint along the current path collides with a changed cell or if
+    // the costs of the path increase by more than mReplanPathCostTolerance.
+    bool mReplanOnlyIfPathInvalid;
+    // Accepted relative cost increase of the current path, e.g. 0.1 for 10%.
+    double mReplanPathCostTolerance;
     
     Replanning() :
         mReplanDuringEachUpdate(false),
         mReplanOnNewStartPose(false),
         mReplanOnNewGoalPose(true),
         mReplanOnNewMap(true),
-        mReplanMinDistStartGoal(0.0) {
+        mReplanMinDistStartGoal(0.0),
+        mReplanOnlyIfPathInvalid(false),
+        mReplanPathCostTolerance(0.1) {
     }
 };
 
@@ -187,6 +214,8 @@ struct Config {
             mPlanner(UNDEFINED_PLANNER),
             mSearchUntilFirstSolution(false), // use to 'just provide ptimal trajectories'?
             mReplanning(),
+            mNumThreads(0),
+            mRecedingHorizon(0.0),
             mMobility(),
             mFootprintRadiusMinMax(0,0),  
             mFootprintLengthMinMax(0,0),
@@ -195,12 +224,28 @@ struct Config {
             mTimeToAdaptFootprint(40.0),
             mAdaptFootprintPenalty(20.0),
             mMaxAllowedSampleDist(-1),
+            mOmplGoalBias(-1),
+            mOmplNumParallelPlanners(1),
+            mOmplMultiQuery(false),
+            mOmplWarmStart(false),
+            mOmplSteering(STEERING_CONTROL),
+            mOmplSimplificationTime(0.0),
+            mOmplCostTolerance(0.0),
+            mOmplStagnationTime(0.0),
+            mOmplPooledStates(false),
+            mOmplGridNearestNeighbors(false),
+            mOmplFreeCellSampling(false),
+            mOmplRoadmapFile(),
             mSBPLEnvFile(),
             mSBPLMotionPrimitivesFile(), 
             mSBPLForwardSearch(true),
+            mSBPLAutoSearchDirection(false),
+            mGoalPosTolerance(0.0),
+            mGoalYawTolerance(0.0),
             mNumIntermediatePoints(0),
             mNumPrimPartition(2),
             mPrimAccuracy(0.25),
+            mNumAngles(16),
             mEscapeTrajRadiusFactor(1.0),
             mJointBorders() {
        if(mNumPrimPartition < 1) {
@@ -217,6 +262,16 @@ struct Config {
     // complete available time.
     bool mSearchUntilFirstSolution; 
     struct Replanning mReplanning;
+    // Number of threads used for parallelizable computations 
+    // (e.g. the SBPL primitive generation), 0 uses all available cores.
+    unsigned int mNumThreads;
+    // If > 0 (meter) and the goal lies further away, the planner only searches
+    // up to this distance along a coarse 2D cost-to-go path, which is used for
+    // the remaining way to the goal (receding horizon). The coarse path only 
+    // avoids obstacle cells and ignores the footprint, the detailed search replaces 
+    // it while the robot moves on. The horizon goal is kept until the robot has
+    // covered half of the horizon or map or goal change. Pose environments only.
+    double mRecedingHorizon;
     
     // NAVIGATION
     struct Mobility mMobility;
@@ -235,15 +290,71 @@ struct Config {
     double mAdaptFootprintPenalty;
     
     // OMPL
-    // If mSearchUntilFirstSolution is set to false this parameter can be used to 
-    // define the maximal allowed distance between two samples.
+    // Defines the maximal allowed distance between two samples, passed as 'range' 
+    // to all planners which support it.
     // If it is set to a negative value or nan it will be ignored.
     double mMaxAllowedSampleDist;
+    // Probability to sample the goal (0.0 to 1.0), passed as 'goal_bias' to 
+    // all planners which support it. Negative values keep the planner default.
+    double mOmplGoalBias;
+    // Geometric environments: Number of planner instances which are solving the 
+    // problem concurrently (one thread each). The best found solution is used.
+    unsigned int mOmplNumParallelPlanners;
+    // ENV_XY and ENV_SHERPA: Keeps the roadmap of PRM* (or LAZY_PRM_STAR if selected)
+    // between the queries on the same map, so new start/goal poses are mostly 
+    // answered by a graph search. Parallel planners are not used in this mode.
+    bool mOmplMultiQuery;
+    // Multi-query mode: If set, the roadmap is loaded from this file if it has been 
+    // created for the same map and stored by MotionPlanningLibraries::saveRoadmap(). 
+    // The map id is stored next to it in <mOmplRoadmapFile>.mapid.
+    std::string mOmplRoadmapFile;
+    // ENV_XY and ENV_SHERPA: RRT* starts each new search (new start, goal or map) 
+    // with the repaired last solution, so it begins with a finite cost bound.
+    bool mOmplWarmStart;
+    // ENV_XYTHETA: Dubins and Reeds-Shepp use closed-form curves with the radius
+    // mMobility.mMinTurningRadius and allow all geometric (optimizing) planners.
+    // The path states receive the movement type and speed of their curve segment,
+    // backward segments of Reeds-Shepp use -mMobility.mSpeed.
+    enum OmplSteeringType mOmplSteering;
+    // Geometric environments: If > 0 the found path is simplified (vertex reduction, 
+    // shortcutting and B-spline smoothing) within this additional time in seconds.
+    // Smoothing is skipped for parts where it would increase the number of states.
+    // The path is split into segments which are simplified in parallel (mNumThreads).
+    double mOmplSimplificationTime;
+    // If > 0 the optimizing planners stop as soon as the path cost lies within this 
+    // fraction (e.g. 0.1 = 10%) above an admissible lower bound (straight line 
+    // through the best driveable cells).
+    double mOmplCostTolerance;
+    // If > 0 the optimizing planners stop if the cost has not been improved 
+    // noticeably (1%) within this time in seconds.
+    double mOmplStagnationTime;
+    // The states (and their components) are placed within large preallocated 
+    // arenas instead of single heap allocations, each thread uses its own 
+    // sub-pool. Unused arenas are released if new start and goal states are set.
+    bool mOmplPooledStates;
+    // RRT* and RRTConnect find their neighbors within a grid of buckets instead
+    // of GNAT (ENV_XY, ENV_SHERPA and the Dubins / Reeds-Shepp steering of ENV_XYTHETA).
+    bool mOmplGridNearestNeighbors;
+    // The uniform samples are drawn from the valid cells of the map (weighted by
+    // their driveability) instead of the complete map, so no sample is rejected.
+    // ENV_SHERPA only samples the footprint classes which fit into the cell, 
+    // preferring the larger ones.
+    bool mOmplFreeCellSampling;
      
     // SBPL
     std::string mSBPLEnvFile;
     std::string mSBPLMotionPrimitivesFile;
     bool mSBPLForwardSearch;
+    // AD* only: Selects the search direction automatically. If the start pose changes 
+    // more often than the goal pose (moving robot) the search runs from the goal to
+    // the robot, so the search tree can be reused after each start update. 
+    // mSBPLForwardSearch is used as the initial direction.
+    bool mSBPLAutoSearchDirection;
+    // ENV_XYTHETA: The search ends as soon as a pose within this distance (m) and 
+    // heading difference (rad) to the goal has been reached. Saves the expansions 
+    // required to line up the exact goal heading. 0 requires the exact discrete goal.
+    double mGoalPosTolerance;
+    double mGoalYawTolerance;
     // Can be used to create and use intermediate points for each motion primitive.
     // E.g. if you want to get 10 points per primitive, you have
     // to set this variable to 8 (8 + start and end point).
@@ -252,6 +363,10 @@ struct Config {
     unsigned int mNumPrimPartition;
     // Max distance in grids from the reached end position to the next discrete one.
     double mPrimAccuracy;
+    // Number of discrete headings used to generate the motion primitives (8, 16, 32 or 64).
+    // Coarse lattices replan faster, fine lattices allow more precise (docking) maneuvers.
+    // Ignored if a motion primitive file is used, its 'numberofangles' is taken instead.
+    unsigned int mNumAngles;
     // Can be used to increase the radius of the robot when creating an escape trajectory.
     // Greater values (>1.0) will lead to a longer trajectory, smaller (<1.0) values to a short one.
     double mEscapeTrajRadiusFactor;
@@ -0,0 +1,145 @@
+#include "CostToGo.hpp"
+
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include <base/Time.hpp>
+#include <base-logging/Logging.hpp>
+
+namespace motion_planning_libraries
+{
+
+namespace {
+    const int NEIGHBORS_X[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+    const int NEIGHBORS_Y[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+}
+
+// PUBLIC
+CostToGo::CostToGo() : mpPreprocessedMap(),
+        mGoalX(-1),
+        mGoalY(-1),
+        mWidth(0),
+        mHeight(0),
+        mCosts() {
+}
+
+bool CostToGo::update(boost::shared_ptr<const PreprocessedMap> preprocessed_map, 
+        int goal_x, int goal_y) {
+    
+    if(!preprocessed_map) {
+        return false;
+    }
+    
+    // Same map and goal: The last field is still valid.
+    if(preprocessed_map == mpPreprocessedMap && goal_x == mGoalX && goal_y == mGoalY) {
+        return getCost(goal_x, goal_y) == 0.0;
+    }
+    
+    base::Time start_t = base::Time::now();
+    
+    mpPreprocessedMap = preprocessed_map;
+    mGoalX = goal_x;
+    mGoalY = goal_y;
+    mWidth = preprocessed_map->getCellSizeX();
+    mHeight = preprocessed_map->getCellSizeY();
+    const double inf = std::numeric_limits<double>::infinity();
+    mCosts.assign(mWidth * mHeight, inf);
+    
+    boost::shared_ptr<const std::vector<unsigned char> > cost_map = 
+            preprocessed_map->getCostMap(COARSE_MAX_COST);
+    const unsigned char obstacle_cost = COARSE_MAX_COST + 1;
+    if(!inside(goal_x, goal_y) || (*cost_map)[goal_y * mWidth + goal_x] >= obstacle_cost) {
+        LOG_WARN("Cost-to-go goal cell (%d,%d) is not valid", goal_x, goal_y);
+        return false;
+    }
+    
+    typedef std::pair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+    mCosts[goal_y * mWidth + goal_x] = 0.0;
+    queue.push(Entry(0.0, goal_y * mWidth + goal_x));
+    
+    while(!queue.empty()) {
+        Entry entry = queue.top();
+        queue.pop();
+        int idx = entry.second;
+        if(entry.first > mCosts[idx]) {
+            continue; // Outdated entry.
+        }
+        int x = idx % mWidth;
+        int y = idx / mWidth;
+        for(int i=0; i<8; ++i) {
+            int nx = x + NEIGHBORS_X[i];
+            int ny = y + NEIGHBORS_Y[i];
+            if(!inside(nx, ny)) {
+                continue;
+            }
+            int n_idx = ny * mWidth + nx;
+            unsigned char n_cost = (*cost_map)[n_idx];
+            if(n_cost >= obstacle_cost) {
+                continue;
+            }
+            double step = (i % 2) ? M_SQRT2 : 1.0;
+            double cost = entry.first + step * 0.5 * ((*cost_map)[idx] + n_cost);
+            if(cost < mCosts[n_idx]) {
+                mCosts[n_idx] = cost;
+                queue.push(Entry(cost, n_idx));
+            }
+        }
+    }
+    
+    LOG_INFO("Cost-to-go of %d x %d cells calculated within %4.4f sec", 
+            mWidth, mHeight, (base::Time::now() - start_t).toSeconds());
+    return true;
+}
+
+double CostToGo::getCost(int x, int y) const {
+    if(!inside(x, y)) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return mCosts[y * mWidth + x];
+}
+
+bool CostToGo::extractPath(int start_x, int start_y, 
+        std::vector<int>& path_x, std::vector<int>& path_y) const {
+    
+    path_x.clear();
+    path_y.clear();
+    double cost = getCost(start_x, start_y);
+    if(cost == std::numeric_limits<double>::infinity()) {
+        return false;
+    }
+    
+    int x = start_x, y = start_y;
+    path_x.push_back(x);
+    path_y.push_back(y);
+    // The costs strictly decrease along the descent, so it ends at the goal.
+    while(cost > 0.0) {
+        int best_x = x, best_y = y;
+        for(int i=0; i<8; ++i) {
+            double n_cost = getCost(x + NEIGHBORS_X[i], y + NEIGHBORS_Y[i]);
+            if(n_cost < cost) {
+                cost = n_cost;
+                best_x = x + NEIGHBORS_X[i];
+                best_y = y + NEIGHBORS_Y[i];
+            }
+        }
+        if(best_x == x && best_y == y) {
+            return false;
+        }
+        x = best_x;
+        y = best_y;
+        path_x.push_back(x);
+        path_y.push_back(y);
+    }
+    return true;
+}
+
+void CostToGo::clear() {
+    mpPreprocessedMap.reset();
+    mGoalX = mGoalY = -1;
+    mCosts.clear();
+}
+
+} // namespace motion_planning_libraries
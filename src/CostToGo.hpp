@@ -0,0 +1,68 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_COST_TO_GO_HPP_
+#define _MOTION_PLANNING_LIBRARIES_COST_TO_GO_HPP_
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "PreprocessedMap.hpp"
+
+namespace motion_planning_libraries
+{
+
+/**
+ * Coarse 2D cost-to-go of all cells to a goal cell (8-connected Dijkstra
+ * on the cost map of a PreprocessedMap). Used by the receding horizon mode:
+ * the detailed search only runs within the horizon, the remaining way to the
+ * goal follows the descent of this field. The field is kept as long as map and
+ * goal do not change, so the tail of the last plan is reused without any search.
+ */
+class CostToGo
+{
+ public:
+    // Driveability 0.0 to 1.0 is mapped to COARSE_MAX_COST + 1 to 1, like SBPL.
+    static const unsigned char COARSE_MAX_COST = 20;
+
+    CostToGo();
+
+    /**
+     * Recalculates the field if the map or the goal cell has changed.
+     * \return false if the goal cell lies outside of the map or on an obstacle.
+     */
+    bool update(boost::shared_ptr<const PreprocessedMap> preprocessed_map, 
+            int goal_x, int goal_y);
+
+    /**
+     * Cost-to-go of the cell, infinity if the goal cannot be reached.
+     */
+    double getCost(int x, int y) const;
+
+    /**
+     * Follows the steepest descent of the field from the start to the goal cell.
+     * \param path_x, path_y Cells from start to goal (both included).
+     * \return false if the goal cannot be reached from the start.
+     */
+    bool extractPath(int start_x, int start_y, 
+            std::vector<int>& path_x, std::vector<int>& path_y) const;
+
+    /**
+     * Forces the recalculation during the next update().
+     */
+    void clear();
+
+ private:
+    boost::shared_ptr<const PreprocessedMap> mpPreprocessedMap;
+    int mGoalX;
+    int mGoalY;
+    int mWidth;
+    int mHeight;
+    std::vector<double> mCosts;
+
+    bool inside(int x, int y) const {
+        return x >= 0 && x < mWidth && y >= 0 && y < mHeight;
+    }
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_COST_TO_GO_HPP_
@@ -1,6 +1,11 @@
 #ifndef _PLANNING_HELPERS_HPP_
 #define _PLANNING_HELPERS_HPP_
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 //#include <CGAL/Point_2.h>
 
@@ -55,7 +60,15 @@ class GridCalculations {
             throw std::runtime_error("Trav Grid not set");
         }
         
-        mFootprintLocal.clear();
+        mFootprintLocal = createFootprintCircle(radius_grid, filled);
+    }
+    
+    /**
+     * Creates the local footprint coordinates of a circle. Can be used
+     * to precalculate footprints which are passed to the const isValid().
+     */
+    static std::vector< base::Vector3d > createFootprintCircle(int radius_grid, bool filled=true) {
+        std::vector< base::Vector3d > footprint_local;
         
         if(filled) {
             base::Vector3d vec;
@@ -66,7 +79,7 @@ class GridCalculations {
                     vec[1] = y;
                     vec[2] = 0.0;
                     if(vec.squaredNorm() <= squared_radius) {
-                        mFootprintLocal.push_back(vec);
+                        footprint_local.push_back(vec);
                     }
                 }
             }
@@ -76,21 +89,30 @@ class GridCalculations {
             double rot = 2*M_PI/(double)num_vertices;
             base::Vector3d vec(radius_grid, 0.0, 0.0);
             // Add circle center
-            mFootprintLocal.push_back(base::Vector3d(0.0, 0.0, 0.0));
+            footprint_local.push_back(base::Vector3d(0.0, 0.0, 0.0));
             
             for(int i=0; i<num_vertices; ++i) {
-                mFootprintLocal.push_back(vec);
+                footprint_local.push_back(vec);
                 vec = Eigen::AngleAxisd(rot, Eigen::Vector3d::UnitZ()) * vec;
             }
         }
+        return footprint_local;
     }
     
     void setFootprintPoseInGrid(int footprint_x_grid, 
             int footprint_y_grid, 
             int footprint_theta_grid) {
-        mFootprint2Grid.setIdentity();
-        mFootprint2Grid.rotate(Eigen::AngleAxis<double>(footprint_theta_grid, base::Vector3d(0.0, 0.0, 1.0)));
-        mFootprint2Grid.translation() = base::Vector3d(footprint_x_grid, footprint_y_grid, 0.0);   
+        mFootprint2Grid = createFootprintPose(footprint_x_grid, footprint_y_grid, footprint_theta_grid);
+    }
+    
+    static Eigen::Affine3d createFootprintPose(int footprint_x_grid, 
+            int footprint_y_grid, 
+            int footprint_theta_grid) {
+        Eigen::Affine3d footprint2grid;
+        footprint2grid.setIdentity();
+        footprint2grid.rotate(Eigen::AngleAxis<double>(footprint_theta_grid, base::Vector3d(0.0, 0.0, 1.0)));
+        footprint2grid.translation() = base::Vector3d(footprint_x_grid, footprint_y_grid, 0.0);   
+        return footprint2grid;
     }
     
     /**
@@ -98,26 +120,34 @@ class GridCalculations {
      * may not be checked. Problem?
      */
     bool isValid() {
+        if(mFootprintLocal.empty()) {
+            throw std::runtime_error("No footprint has been set.");
+        }
+        return isValid(mFootprintLocal, mFootprint2Grid);
+    }
+    
+    /**
+     * Checks the passed footprint at the passed pose. Does not modify the object,
+     * so it can be called concurrently (e.g. by parallel planners).
+     */
+    bool isValid(const std::vector< base::Vector3d >& footprint_local, 
+            const Eigen::Affine3d& footprint2grid) const {
     
         if(mpTravGrid == NULL) {
             throw std::runtime_error("Trav Grid not set");
         }
         
-        if(mFootprintLocal.empty()) {
-            throw std::runtime_error("No footprint has been set.");
-        }
-        
         int fp_x = 0;
         int fp_y = 0;
         base::Vector3d result;
         uint8_t class_value = 0;
         double driveability = 0;
         
-        std::vector<base::Vector3d>::iterator it = mFootprintLocal.begin(); 
-        for(;it != mFootprintLocal.end(); ++it) {
+        std::vector<base::Vector3d>::const_iterator it = footprint_local.begin(); 
+        for(;it != footprint_local.end(); ++it) {
             
             // Transform to grid frame.
-            result = mFootprint2Grid * *it;
+            result = footprint2grid * *it;
             fp_x = result[0];
             fp_y = result[1];
              
@@ -125,7 +155,7 @@ class GridCalculations {
             if(     fp_x < 0 || fp_x >= (int)mpTravGrid->getCellSizeX() ||
                     fp_y < 0 || fp_y >= (int)mpTravGrid->getCellSizeY()) {
                 LOG_DEBUG("State (%d,%d) is invalid (footprint (%4.2f,%4.2f) not within the grid)", 
-                        mFootprint2Grid.translation()[0], mFootprint2Grid.translation()[1], fp_x, fp_y);
+                        footprint2grid.translation()[0], footprint2grid.translation()[1], fp_x, fp_y);
                 return false;
             } 
             
@@ -135,13 +165,78 @@ class GridCalculations {
         
             if(driveability == 0.0) {
                 LOG_DEBUG("State (%d,%d) is invalid (footprint (%4.2f,%4.2f) lies on an obstacle)", 
-                        mFootprint2Grid.translation()[0], mFootprint2Grid.translation()[1], fp_x, fp_y);
+                        footprint2grid.translation()[0], footprint2grid.translation()[1], fp_x, fp_y);
                 return false;
             }  
         }
         return true;
     }
     
+    /**
+     * Returns the euclidean distance (in cells) of each cell to the closest obstacle
+     * (driveability 0) or to the closest cell outside of the grid, stored row by row.
+     * Exact distance transform of Felzenszwalb and Huttenlocher, linear in the 
+     * number of cells.
+     */
+    static std::vector<float> createObstacleDistances(envire::TraversabilityGrid* trav_grid, 
+            boost::shared_ptr<TravData> trav_data) {
+        // Only the classes which are used by the cells.
+        std::vector<bool> used_classes(256, false);
+        const uint8_t* cells = trav_data->data();
+        for(size_t i=0; i<trav_data->num_elements(); ++i) {
+            used_classes[cells[i]] = true;
+        }
+        std::vector<double> driveabilities(256, 0.0);
+        for(unsigned int i=0; i<used_classes.size(); ++i) {
+            if(used_classes[i]) {
+                driveabilities[i] = trav_grid->getTraversabilityClass(i).getDrivability();
+            }
+        }
+        return createObstacleDistances(trav_grid->getCellSizeX(), trav_grid->getCellSizeY(), 
+                trav_data, driveabilities);
+    }
+    
+    /**
+     * Same as above without accessing the grid, \a driveabilities contains
+     * the driveability of each of the 256 traversability classes.
+     */
+    static std::vector<float> createObstacleDistances(int width, int height,
+            boost::shared_ptr<TravData> trav_data, std::vector<double> const& driveabilities) {
+        const float inf = std::numeric_limits<float>::infinity();
+        
+        std::vector<float> sq_dists(width * height, inf);
+        for(int y=0; y<height; ++y) {
+            for(int x=0; x<width; ++x) {
+                if(driveabilities[(*trav_data)[y][x]] == 0.0) {
+                    sq_dists[y * width + x] = 0;
+                }
+            }
+        }
+        
+        // Squared distances along the columns, then along the rows.
+        std::vector<float> line(std::max(width, height));
+        std::vector<float> result(line.size());
+        for(int x=0; x<width; ++x) {
+            for(int y=0; y<height; ++y) {
+                line[y] = sq_dists[y * width + x];
+            }
+            squaredDistanceTransform(line, height, result);
+            for(int y=0; y<height; ++y) {
+                sq_dists[y * width + x] = result[y];
+            }
+        }
+        for(int y=0; y<height; ++y) {
+            std::copy(sq_dists.begin() + y * width, sq_dists.begin() + (y+1) * width, line.begin());
+            squaredDistanceTransform(line, width, result);
+            for(int x=0; x<width; ++x) {
+                // The cells outside of the grid are obstacles as well.
+                float border_dist = std::min(std::min(x + 1, width - x), std::min(y + 1, height - y));
+                sq_dists[y * width + x] = std::min((float)std::sqrt(result[x]), border_dist);
+            }
+        }
+        return sq_dists;
+    }
+    
     /**
      * Sets the current footprint to the passed trav-class. Uses x,y+=0.5
      * to be sure to set every pixel.
@@ -178,6 +273,47 @@ class GridCalculations {
             mpTravGrid->setProbability(1.0, fp_x, fp_y);
         }
     }
+    
+ private:
+    /**
+     * One dimensional squared distance transform of the first n values of f
+     * (0 for obstacles, infinity otherwise).
+     */
+    static void squaredDistanceTransform(const std::vector<float>& f, int n, 
+            std::vector<float>& d) {
+        const float inf = std::numeric_limits<float>::infinity();
+        std::vector<int> v(n); // Locations of the parabolas of the lower envelope.
+        std::vector<float> z(n + 1); // Borders between the parabolas.
+        int k = -1;
+        for(int q=0; q<n; ++q) {
+            if(f[q] == inf) {
+                continue;
+            }
+            float s = -inf;
+            while(k >= 0) {
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+                if(s > z[k]) {
+                    break;
+                }
+                k--;
+            }
+            k++;
+            v[k] = q;
+            z[k] = k == 0 ? -inf : s;
+            z[k+1] = inf;
+        }
+        if(k < 0) { // No obstacle within this line.
+            std::fill(d.begin(), d.begin() + n, inf);
+            return;
+        }
+        int j = 0;
+        for(int q=0; q<n; ++q) {
+            while(z[j+1] < q) {
+                j++;
+            }
+            d[q] = (q - v[j]) * (q - v[j]) + f[v[j]];
+        }
+    }
 };
 
 } // end namespace motion_planning_libraries
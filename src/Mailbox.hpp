@@ -0,0 +1,64 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_MAILBOX_HPP_
+#define _MOTION_PLANNING_LIBRARIES_MAILBOX_HPP_
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace motion_planning_libraries
+{
+
+/**
+ * Lock-free single-value mailbox for one producer and one consumer thread,
+ * the latest posted value wins. Implemented as a triple buffer: The producer
+ * writes into its own buffer and swaps it with the shared middle buffer, the
+ * consumer swaps its buffer with the middle one if it contains a new value.
+ * So neither post() nor fetch() ever waits for the other thread and
+ * a value is never copied while the other thread accesses it.
+ */
+template <class T>
+class Mailbox : private boost::noncopyable
+{
+ public:
+    Mailbox() : mMiddle(1), mWriteIndex(0), mReadIndex(2) {
+    }
+
+    /**
+     * Producer: Replaces a value which has not been fetched yet.
+     */
+    void post(const T& value) {
+        mBuffers[mWriteIndex] = value;
+        unsigned int middle = mMiddle.exchange(mWriteIndex | NEW_VALUE_FLAG,
+                boost::memory_order_acq_rel);
+        mWriteIndex = middle & INDEX_MASK;
+    }
+
+    /**
+     * Consumer: Copies the latest posted value.
+     * \return false if no new value has been posted since the last fetch().
+     */
+    bool fetch(T& value) {
+        if((mMiddle.load(boost::memory_order_relaxed) & NEW_VALUE_FLAG) == 0) {
+            return false;
+        }
+        unsigned int middle = mMiddle.exchange(mReadIndex, boost::memory_order_acq_rel);
+        mReadIndex = middle & INDEX_MASK;
+        value = mBuffers[mReadIndex];
+        return true;
+    }
+
+ private:
+    static const unsigned int INDEX_MASK = 3;
+    static const unsigned int NEW_VALUE_FLAG = 4;
+
+    T mBuffers[3];
+    // Index of the middle buffer, NEW_VALUE_FLAG is set until it has been fetched.
+    boost::atomic<unsigned int> mMiddle;
+    // Only accessed by the producer.
+    unsigned int mWriteIndex;
+    // Only accessed by the consumer.
+    unsigned int mReadIndex;
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_MAILBOX_HPP_
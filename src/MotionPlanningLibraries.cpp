@@ -1,6 +1,7 @@
 #include "MotionPlanningLibraries.hpp"
 
 #include "Helpers.hpp"
+#include "Parallel.hpp"
 
 #include <motion_planning_libraries/sbpl/SbplEnvXY.hpp>
 #include <motion_planning_libraries/sbpl/SbplEnvXYTHETA.hpp>
@@ -12,12 +13,14 @@
 namespace motion_planning_libraries
 {
 
+const unsigned char MotionPlanningLibraries::PATH_CHECK_MAX_COST;
+
 // PUBLIC
-MotionPlanningLibraries::MotionPlanningLibraries(Config config) : 
+MotionPlanningLibraries::MotionPlanningLibraries(Config const& config) : 
         mConfig(config),
         mpTravGrid(NULL), 
         mpTravData(),
-        mpLastTravGrid(NULL),
+        mpPreprocessedMap(),
         mStartState(), mGoalState(), 
         mStartStateGrid(), mGoalStateGrid(), 
         mPlannedPathInWorld(),
@@ -25,6 +28,25 @@ MotionPlanningLibraries::MotionPlanningLibraries(Config config) :
         mNewGoalReceived(false),
         mLostX(0.0),
         mLostY(0.0),
+        mStartUpdateRate(0.0),
+        mGoalUpdateRate(0.0),
+        mUnusedPlanningTime(0.0),
+        mpAsyncPlanning(),
+        mBatchPlanningLibs(),
+        mpBatchTravData(),
+        mTravGridMailbox(),
+        mStartStateMailbox(),
+        mGoalStateMailbox(),
+        mCostToGo(),
+        mHorizonSuffixInWorld(),
+        mHorizonGoalActive(false),
+        mHorizonGoalGrid(),
+        mPlannedPathGrid(),
+        mTransformBufferX(),
+        mTransformBufferY(),
+        mTransformBufferZ(),
+        mImprovedPathInWorld(),
+        mImprovedStatesInWorld(),
         mError(MPL_ERR_NONE) {
             
     // Do some checks.
@@ -40,57 +62,7 @@ MotionPlanningLibraries::MotionPlanningLibraries(Config config) :
     }
 
     // Creates the requested planning library.  
-    switch(config.mPlanningLibType) {
-        case LIB_SBPL: {
-            switch(config.mEnvType) {
-                case ENV_XY: {
-                    mpPlanningLib = boost::shared_ptr<AbstractMotionPlanningLibrary>
-                            (new SbplEnvXY(config));    
-                    break;
-                }
-                case ENV_XYTHETA: {
-                    mpPlanningLib = boost::shared_ptr<AbstractMotionPlanningLibrary>
-                            (new SbplEnvXYTHETA(config)); 
-                    break;
-                }
-                default: {
-                    LOG_ERROR("Environment is not available in SBPL");
-                    throw new std::runtime_error("Environment not available in SBPL");
-                }
-            }
-            break;    
-        }    
-        case LIB_OMPL: {
-            switch(config.mEnvType) {
-                case ENV_XY: {
-                    mpPlanningLib = boost::shared_ptr<AbstractMotionPlanningLibrary>
-                            (new OmplEnvXY(config));    
-                    break;
-                }
-                case ENV_XYTHETA: {
-                    mpPlanningLib = boost::shared_ptr<AbstractMotionPlanningLibrary>
-                            (new OmplEnvXYTHETA(config));    
-                    break;
-                }
-                case ENV_ARM: {
-                    mpPlanningLib = boost::shared_ptr<AbstractMotionPlanningLibrary>
-                            (new OmplEnvARM(config));    
-                    break;
-                }
-                case ENV_SHERPA: {
-                    mpPlanningLib = boost::shared_ptr<AbstractMotionPlanningLibrary>
-                            (new OmplEnvSHERPA(config));    
-                    break;
-                }
-                //mpPlanningLib = boost::shared_ptr<AbstractMotionPlanningLibrary>(new Ompl(config));
-                default: {
-                    LOG_ERROR("Environment is not available in OMPL");
-                    throw new std::runtime_error("Environment not available in OMPL");
-                }
-            }
-            break;
-        }
-    }
+    mpPlanningLib = createPlanningLibrary(mConfig);
     
     // Currently the arm environment will be initialized just once.
     // Later changes in the environment may require a reinitialization similar 
@@ -103,6 +75,12 @@ MotionPlanningLibraries::MotionPlanningLibraries(Config config) :
 }
 
 MotionPlanningLibraries::~MotionPlanningLibraries() {
+    // The planning thread uses this object.
+    boost::shared_ptr<PlanningHandle> handle = mpAsyncPlanning.lock();
+    if(handle) {
+        handle->cancel();
+        handle->wait();
+    }
 }
 
 bool MotionPlanningLibraries::setTravGrid(envire::Environment* env, std::string trav_map_id) {
@@ -117,11 +95,6 @@ bool MotionPlanningLibraries::setTravGrid(envire::Environment* env, std::string
         return false;
     } 
     
-    LOG_INFO("Received Trav Map: Number of cells (%d, %d), cell size in meter (%4.2f, %4.2f), offset (%4.2f, %4.2f)", 
-            trav_grid->getCellSizeX(), trav_grid->getCellSizeY(), 
-            trav_grid->getScaleX(), trav_grid->getScaleY(), 
-            trav_grid->getOffsetX(), trav_grid->getOffsetY());
-    
     // Currently if you start the grap-slam-module and do not wait a few seconds
     // you get a map with sizex/sizey 0.1.
     if(trav_grid->getSizeX() < 1 || trav_grid->getSizeY() < 1) {
@@ -129,40 +102,59 @@ bool MotionPlanningLibraries::setTravGrid(envire::Environment* env, std::string
         return false;
     }
     
+    return setPreprocessedMap(PreprocessedMap::create(trav_grid));
+}
+
+bool MotionPlanningLibraries::setPreprocessedMap(
+        boost::shared_ptr<const PreprocessedMap> preprocessed_map) {
+    
+    if(mpPlanningLib == NULL) {
+        LOG_WARN("Planning library has not been allocated yet");
+        return false;
+    }
+    if(!preprocessed_map) {
+        LOG_WARN("No preprocessed map has been passed");
+        return false;
+    }
+    envire::TraversabilityGrid* trav_grid = preprocessed_map->getTravGrid();
+    
+    LOG_INFO("Received Trav Map: Number of cells (%d, %d), cell size in meter (%4.2f, %4.2f), offset (%4.2f, %4.2f)", 
+            trav_grid->getCellSizeX(), trav_grid->getCellSizeY(), 
+            trav_grid->getScaleX(), trav_grid->getScaleY(), 
+            trav_grid->getOffsetX(), trav_grid->getOffsetY());
+    
     // If the map size has not changed, partial updates are possible.
     bool different_map_size = true;
-    if(mpLastTravGrid != NULL) {
-        different_map_size = mpTravGrid->getWidth() != mpLastTravGrid->getWidth() ||
-            mpTravGrid->getHeight() != mpLastTravGrid->getHeight();
+    if(mpPreprocessedMap) {
+        different_map_size = 
+                mpPreprocessedMap->getCellSizeX() != preprocessed_map->getCellSizeX() ||
+                mpPreprocessedMap->getCellSizeY() != preprocessed_map->getCellSizeY();
         LOG_INFO("Trav map sizes are different: %s", different_map_size ? "true" : "false");
     }
     
+    mpPlanningLib->setPreprocessedMap(preprocessed_map);
+    
     std::vector<CellUpdate> cell_updates;
     // Tests if partialUpdates are supported by the planning library (empty vector should return true).
     bool partial_update_implemented = mpPlanningLib->partialMapUpdate(cell_updates);
     bool partial_update_successful = false;
     // Execute the partial update.
     if(!different_map_size && partial_update_implemented) {
-        collectCellUpdates(mpLastTravGrid, mpTravGrid, cell_updates);
+        collectCellUpdates(mpPreprocessedMap, preprocessed_map, cell_updates);
         partial_update_successful = mpPlanningLib->partialMapUpdate(cell_updates);
         if(!partial_update_successful) {
              LOG_WARN("A complete initialization will be executed, a partial update failed");
         }
     }
     
+    // The map data is shared with all planners using the same preprocessed map,
+    // the last map is kept for partial update testing.
+    boost::shared_ptr<const PreprocessedMap> old_map = mpPreprocessedMap;
+    mpPreprocessedMap = preprocessed_map;
     mpTravGrid = trav_grid;
-    // Creates a copy of the new grid data.
-    mpTravData = boost::shared_ptr<TravData>(new TravData(
-            trav_grid->getGridData(envire::TraversabilityGrid::TRAVERSABILITY)));
-    
-    // Stores last trav map for partial update testing.
-    if(mpLastTravGrid != NULL) {
-        delete mpLastTravGrid;
-        mpLastTravGrid = NULL;
-    }
-    mpLastTravGrid = new envire::TraversabilityGrid(*mpTravGrid);
-    //envire::TraversabilityGrid grid = *mpTravGrid;
-    
+    mpTravData = preprocessed_map->getTravData();
+    // The coarse path to the goal may have changed.
+    resetHorizonGoal();
     
     // Reinitialize the complete planning environment.
     // Will be used if the partial update has not been implemented or could not be executed.
@@ -191,13 +183,18 @@ bool MotionPlanningLibraries::setTravGrid(envire::Environment* env, std::string
         
         // Replanning without valid start/goal is not necessary.
         if(mConfig.mReplanning.mReplanOnNewMap) {
-            mReplanRequired = true;
+            if(mConfig.mReplanning.mReplanOnlyIfPathInvalid && !mReplanRequired &&
+                    isPlannedPathValid(old_map, preprocessed_map)) {
+                LOG_INFO("Current path is still valid within the new map, no replanning required");
+            } else {
+                mReplanRequired = true;
+            }
         }
     }
     return true;
 }
 
-bool MotionPlanningLibraries::setStartState(struct State new_state) {
+bool MotionPlanningLibraries::setStartState(struct State const& new_state) {
     if(mpPlanningLib == NULL) {
         LOG_WARN("Planning library has not been allocated yet");
         return false;
@@ -222,7 +219,7 @@ bool MotionPlanningLibraries::setStartState(struct State new_state) {
             
             // Start
             base::samples::RigidBodyState new_grid;
-            if(!world2grid(mpTravGrid, new_state.getPose(), new_grid)) {
+            if(!world2gridCached(new_state.mPose, new_grid)) {
                 LOG_WARN("Start pose could not be transformed into the grid");
                 return false;
             }
@@ -239,13 +236,10 @@ bool MotionPlanningLibraries::setStartState(struct State new_state) {
         }
     }
     
-    // If required create dummy goal state (a start copy).
-    State goal_state_grid;
-    if(goalStateAvailable()) {
-        goal_state_grid = mGoalStateGrid;
-    } else {
-        goal_state_grid = mStartStateGrid;
-    }
+    // If required use the start as dummy goal state.
+    // A horizon goal remains within the planning library.
+    const State& goal_state_grid = !goalStateAvailable() ? mStartStateGrid : 
+            (mHorizonGoalActive ? mHorizonGoalGrid : mGoalStateGrid);
     
     if(!mpPlanningLib->setStartGoal(mStartStateGrid, goal_state_grid)) {
             LOG_WARN("Start/goal state could not be set");
@@ -253,6 +247,10 @@ bool MotionPlanningLibraries::setStartState(struct State new_state) {
             return false;
     }
     
+    if(new_state_received) {
+        registerStateUpdate(true);
+    }
+    
     if(mConfig.mReplanning.mReplanOnNewStartPose && new_state_received) {
         mReplanRequired = true;
         
@@ -261,12 +259,14 @@ bool MotionPlanningLibraries::setStartState(struct State new_state) {
     return true;
 }
 
-bool MotionPlanningLibraries::setGoalState(struct State new_state, bool reset) {
+bool MotionPlanningLibraries::setGoalState(struct State const& new_state, bool reset) {
     if(mpPlanningLib == NULL) {
         LOG_WARN("Planning library has not been allocated yet");
         return false;
     }
     
+    bool new_state_received = mGoalState.differs(new_state);
+    
     switch (new_state.getStateType()) {
         case STATE_EMPTY: {
             LOG_WARN("States contain no valid values and could not be set");
@@ -284,7 +284,7 @@ bool MotionPlanningLibraries::setGoalState(struct State new_state, bool reset) {
             
             // Start
             base::samples::RigidBodyState new_grid;
-            if(!world2grid(mpTravGrid, new_state.getPose(), new_grid, &mLostX, &mLostY)) {
+            if(!world2gridCached(new_state.mPose, new_grid, &mLostX, &mLostY)) {
                 LOG_WARN("Goal pose could not be transformed into the grid");
                 return false;
             }
@@ -301,13 +301,11 @@ bool MotionPlanningLibraries::setGoalState(struct State new_state, bool reset) {
         }
     }
     
-    // If required create dummy start state (a goal copy).
-    State start_state_grid;
-    if(startStateAvailable()) {
-        start_state_grid = mStartStateGrid;
-    } else {
-        start_state_grid = mGoalStateGrid;
-    }
+    // A new goal replaces the horizon goal.
+    resetHorizonGoal();
+    
+    // If required use the goal as dummy start state.
+    const State& start_state_grid = startStateAvailable() ? mStartStateGrid : mGoalStateGrid;
     
     if(!mpPlanningLib->setStartGoal(start_state_grid, mGoalStateGrid)) {
             LOG_WARN("Start/goal state could not be set");
@@ -316,6 +314,9 @@ bool MotionPlanningLibraries::setGoalState(struct State new_state, bool reset) {
     }
     
     if(!reset) {
+        if(new_state_received) {
+            registerStateUpdate(false);
+        }
         if(mConfig.mReplanning.mReplanOnNewGoalPose) {
             mReplanRequired = true;
         }  
@@ -325,6 +326,18 @@ bool MotionPlanningLibraries::setGoalState(struct State new_state, bool reset) {
     return true;
 }
 
+void MotionPlanningLibraries::postTravGrid(envire::Environment* env, std::string trav_map_id) {
+    mTravGridMailbox.post(TravGridInput(env, trav_map_id));
+}
+
+void MotionPlanningLibraries::postStartState(struct State new_state) {
+    mStartStateMailbox.post(new_state);
+}
+
+void MotionPlanningLibraries::postGoalState(struct State new_state) {
+    mGoalStateMailbox.post(new_state);
+}
+
 bool MotionPlanningLibraries::allInputsAvailable(enum MplErrors& err) {
     int err_i = (int)MPL_ERR_NONE;
     // TODO CHECK
@@ -380,14 +393,63 @@ bool MotionPlanningLibraries::foundFinalSolution()
     return mpPlanningLib->foundFinalSolution();
 }
 
+int MotionPlanningLibraries::getNumExpansions()
+{
+    if(mpPlanningLib == NULL) {
+        return -1;
+    }
+    return mpPlanningLib->getNumExpansions();
+}
+
+double MotionPlanningLibraries::getEpsilon()
+{
+    if(mpPlanningLib == NULL) {
+        return nan("");
+    }
+    return mpPlanningLib->getEpsilon();
+}
+
+bool MotionPlanningLibraries::isForwardSearch()
+{
+    if(mpPlanningLib == NULL) {
+        return true;
+    }
+    return mpPlanningLib->isForwardSearch();
+}
+
+bool MotionPlanningLibraries::saveRoadmap()
+{
+    if(mpPlanningLib == NULL) {
+        return false;
+    }
+    return mpPlanningLib->saveRoadmap(mConfig.mOmplRoadmapFile);
+}
+
+unsigned int MotionPlanningLibraries::getNumRoadmapVertices()
+{
+    if(mpPlanningLib == NULL) {
+        return 0;
+    }
+    return mpPlanningLib->getNumRoadmapVertices();
+}
+
 
 bool MotionPlanningLibraries::plan(double max_time, double& cost) {
+    return plan(max_time, cost, SolutionCallback());
+}
+
+bool MotionPlanningLibraries::plan(double max_time, double& cost, SolutionCallback solution_callback) {
     
     if(mpPlanningLib == NULL) {
         LOG_WARN("Planning library has not been allocated yet");
         return false;
     }
     
+    // Inputs posted by other threads are taken over before the search starts.
+    if(!processPostedInputs()) {
+        return false;
+    }
+    
     if(max_time <= 0) {
         LOG_WARN("Max allowed planning time must exceed 0, set to 1");
         max_time = 1.0;
@@ -414,17 +476,44 @@ bool MotionPlanningLibraries::plan(double max_time, double& cost) {
         return false;
     }
     
+    // Receding horizon: Only the part up to the horizon is searched in detail.
+    bool horizon_used = setHorizonGoal();
+    
     // Planning
-    LOG_INFO("Planning from \n%s (Grid %s) \nto \n%s (Grid %s)", 
-        mStartState.getString().c_str(), mStartStateGrid.getString().c_str(),
-        mGoalState.getString().c_str(), mGoalStateGrid.getString().c_str());    
+    // The arguments are evaluated even if INFO is not logged, State::getString()
+    // would allocate within each replanning cycle.
+    if(mStartStateGrid.getStateType() == STATE_POSE) {
+        LOG_INFO("Planning from (%4.2f, %4.2f) (Grid (%d, %d)) to (%4.2f, %4.2f) (Grid (%d, %d))",
+            mStartState.mPose.position.x(), mStartState.mPose.position.y(),
+            (int)mStartStateGrid.mPose.position.x(), (int)mStartStateGrid.mPose.position.y(),
+            mGoalState.mPose.position.x(), mGoalState.mPose.position.y(),
+            (int)mGoalStateGrid.mPose.position.x(), (int)mGoalStateGrid.mPose.position.y());
+    } else {
+        LOG_INFO("Planning from %d to %d joint angles", 
+            (int)mStartState.mJointAngles.size(), (int)mGoalState.mJointAngles.size());
+    }
+    if(solution_callback) {
+        mpPlanningLib->setImprovedSolutionCallback(boost::bind(
+                &MotionPlanningLibraries::improvedSolutionCallback, this, solution_callback));
+    }
+    if(mConfig.mSBPLAutoSearchDirection) {
+        updateSearchDirection();
+    }
+    base::Time solve_start = base::Time::now();
     bool solved = mpPlanningLib->solve(max_time);
+    mUnusedPlanningTime = std::max(0.0, max_time - (base::Time::now() - solve_start).toSeconds());
+    mpPlanningLib->setImprovedSolutionCallback(ImprovedSolutionCallback());
     mReplanRequired = false;
     mNewGoalReceived = false;
     
     if (!solved) {
         LOG_WARN("No solution found");   
         mError = MPL_ERR_PLANNING_FAILED;
+        if(horizon_used) {
+            // The next planning starts without the horizon goal.
+            resetHorizonGoal();
+            mpPlanningLib->setStartGoal(mStartStateGrid, mGoalStateGrid);
+        }
         return false;
     }
 
@@ -434,38 +523,23 @@ bool MotionPlanningLibraries::plan(double max_time, double& cost) {
     // Request costs if available, otherwise nan is returned.
     cost = mpPlanningLib->getCost();
     
-    // By default grid coordinates are expected.
-    std::vector<State> planned_path;
-    bool pos_defined_in_local_grid = false;
-    
-    mpPlanningLib->fillPath(planned_path, pos_defined_in_local_grid);
-    
-    if(planned_path.size() == 0) {
+    bool path_available = requestPathInWorld(mPlannedPathInWorld);
+    if(horizon_used) {
+        // The coarse part completes the path.
+        mPlannedPathInWorld.append(mHorizonSuffixInWorld);
+    }
+    if(!path_available) {
         LOG_WARN("Planned path does not contain any states!");
         mError = MPL_ERR_UNDEFINED;
         return false;
     }
     
-    // Convert path from grid or grid-local to world.
-    mPlannedPathInWorld.clear();
-    std::vector<State>::iterator it = planned_path.begin();
-    base::samples::RigidBodyState rbs_world;
-    for(; it != planned_path.end(); it++) {
-        if(pos_defined_in_local_grid) {
-            gridlocal2world(mpTravGrid, it->getPose(), rbs_world);
-        } else {
-            grid2world(mpTravGrid, it->getPose(), rbs_world);
-        }
-        it->setPose(rbs_world);
-        mPlannedPathInWorld.push_back(*it);
-    }
-    
     // Calculate distance between goal pose and end of trajectory.
     // Currently with OMPL the trajectory may not reach the goal pose.
-    if(mPlannedPathInWorld.size() > 0) {
-        base::samples::RigidBodyState end_pose_trajectory = (mPlannedPathInWorld.end()-1)->mPose;
-        double dist = (end_pose_trajectory.position - mGoalState.getPose().position).head(2).norm();
-        double max_allowed_dist = 0.2;
+    if(mPlannedPathInWorld.size() > 0 && mPlannedPathInWorld.mStateType == STATE_POSE) {
+        base::Position end_position = mPlannedPathInWorld.getPosition(mPlannedPathInWorld.size()-1);
+        double dist = (end_position - mGoalState.getPose().position).head(2).norm();
+        double max_allowed_dist = 0.2 + mConfig.mGoalPosTolerance;
         LOG_INFO("Distance end of trajectory to goal position in world: %4.2f", dist);
         if(dist > max_allowed_dist) {
             LOG_WARN("Goal position could only be reached imprecisely (>%4.2f m)", max_allowed_dist);
@@ -478,22 +552,429 @@ bool MotionPlanningLibraries::plan(double max_time, double& cost) {
     return true;
 }
 
+boost::shared_ptr<PlanningHandle> MotionPlanningLibraries::planAsync(double max_time) {
+    boost::shared_ptr<PlanningHandle> running = mpAsyncPlanning.lock();
+    if(running && !running->isDone()) {
+        LOG_WARN("Asynchronous planning is still running");
+        return boost::shared_ptr<PlanningHandle>();
+    }
+    
+    boost::shared_ptr<PlanningHandle> handle(new PlanningHandle(this, max_time));
+    mpAsyncPlanning = handle;
+    handle->start();
+    return handle;
+}
+
+bool MotionPlanningLibraries::planBatch(struct State start_state, 
+        std::vector<struct State> const& goal_states, double budget, 
+        std::vector<BatchPlanningResult>& results) {
+    
+    results.clear();
+    results.resize(goal_states.size());
+    if(goal_states.empty()) {
+        return true;
+    }
+    
+    if(mpPlanningLib == NULL || !travGridAvailable()) {
+        LOG_WARN("Batch planning requires a traversability map");
+        return false;
+    }
+    
+    if(budget <= 0) {
+        LOG_WARN("Batch planning budget must exceed 0, set to 1");
+        budget = 1.0;
+    }
+    
+    // The initialization of the workers counts to the budget as well.
+    base::Time deadline = base::Time::now() + base::Time::fromSeconds(budget);
+    
+    // All transformations are done within this thread.
+    State start_grid;
+    if(!world2gridState(start_state, start_grid)) {
+        LOG_WARN("Batch start state could not be transformed into the grid");
+        return false;
+    }
+    std::vector<State> goals_grid(goal_states.size());
+    // Discretization error of each goal, used to convert its path back.
+    std::vector<double> goals_lost_x(goal_states.size(), 0.0);
+    std::vector<double> goals_lost_y(goal_states.size(), 0.0);
+    for(unsigned int i=0; i<goal_states.size(); ++i) {
+        if(!world2gridState(goal_states[i], goals_grid[i], &goals_lost_x[i], &goals_lost_y[i])) {
+            LOG_WARN("Batch goal %d could not be transformed into the grid", i);
+            goals_grid[i] = State();
+            results[i].mError = MPL_ERR_SET_START_GOAL;
+        }
+    }
+    
+    ParallelFor parallel_for(mConfig.mNumThreads);
+    size_t num_workers = std::min<size_t>(parallel_for.getNumThreads(), goal_states.size());
+    if(!prepareBatchPlanningLibs(num_workers)) {
+        mError = MPL_ERR_INITIALIZE_MAP;
+        return false;
+    }
+    
+    LOG_INFO("Batch planning of %d goals with %d workers, %4.2f sec left", 
+            (int)goal_states.size(), (int)num_workers, (deadline - base::Time::now()).toSeconds());
+    
+    std::vector<unsigned char> pos_defined_in_local_grid(goal_states.size(), 0);
+    try {
+        parallel_for.run(num_workers, boost::bind(&MotionPlanningLibraries::planBatchWorker, 
+                this, _1, num_workers, start_grid, &goals_grid, deadline, 
+                &results, &pos_defined_in_local_grid));
+    } catch (std::runtime_error& e) {
+        LOG_ERROR("Batch planning failed: %s", e.what());
+        results.clear();
+        results.resize(goal_states.size());
+        return false;
+    }
+    
+    // The paths have been stored in grid coordinates.
+    std::vector<State> planned_path;
+    CompactPath path_in_world;
+    for(unsigned int i=0; i<results.size(); ++i) {
+        if(results[i].mSolved) {
+            planned_path.swap(results[i].mPathInWorld);
+            convertPathToWorld(planned_path, pos_defined_in_local_grid[i], path_in_world,
+                    goals_lost_x[i], goals_lost_y[i]);
+            path_in_world.getStates(results[i].mPathInWorld);
+        }
+    }
+    return true;
+}
+
+bool MotionPlanningLibraries::setHorizonGoal() {
+    
+    if(mConfig.mRecedingHorizon <= 0 || !mpPreprocessedMap ||
+            mGoalStateGrid.getStateType() != STATE_POSE) {
+        return false;
+    }
+    
+    // The horizon goal is kept within the planning library (changing the goal 
+    // reinitializes e.g. the backward AD* search) until the robot approaches it.
+    double scale = mpTravGrid->getScaleX();
+    if(mHorizonGoalActive) {
+        double dist_to_horizon_goal = (mHorizonGoalGrid.mPose.position - 
+                mStartStateGrid.mPose.position).head(2).norm() * scale;
+        if(dist_to_horizon_goal > mConfig.mRecedingHorizon / 2.0) {
+            return true;
+        }
+        resetHorizonGoal();
+        mpPlanningLib->setStartGoal(mStartStateGrid, mGoalStateGrid);
+    }
+    
+    // The field is only recalculated for a new map or goal cell.
+    int start_x = mStartStateGrid.mPose.position.x();
+    int start_y = mStartStateGrid.mPose.position.y();
+    int goal_x = mGoalStateGrid.mPose.position.x();
+    int goal_y = mGoalStateGrid.mPose.position.y();
+    std::vector<int> path_x, path_y;
+    if(!mCostToGo.update(mpPreprocessedMap, goal_x, goal_y) || 
+            !mCostToGo.extractPath(start_x, start_y, path_x, path_y)) {
+        LOG_WARN("No coarse path to the goal, the complete problem will be planned");
+        return false;
+    }
+    
+    // First cell beyond the horizon.
+    double dist = 0.0;
+    size_t horizon_idx = 0;
+    while(horizon_idx + 1 < path_x.size() && dist < mConfig.mRecedingHorizon) {
+        ++horizon_idx;
+        int dx = path_x[horizon_idx] - path_x[horizon_idx-1];
+        int dy = path_y[horizon_idx] - path_y[horizon_idx-1];
+        dist += ((dx != 0 && dy != 0) ? M_SQRT2 : 1.0) * scale;
+    }
+    if(dist < mConfig.mRecedingHorizon) {
+        return false; // The goal lies within the horizon.
+    }
+    
+    // The coarse path only avoids obstacles with its center cell, so the 
+    // horizon goal moves along it until the footprint (its smallest 
+    // circumcircle) keeps away from the obstacles of the distance field.
+    boost::shared_ptr<const std::vector<float> > obstacle_distances = 
+            mpPreprocessedMap->getObstacleDistances();
+    double min_obstacle_dist = mConfig.getMinRadius() / scale;
+    int size_x = mpTravGrid->getCellSizeX();
+    for(; horizon_idx + 1 < path_x.size(); ++horizon_idx) {
+        if((*obstacle_distances)[path_y[horizon_idx] * size_x + path_x[horizon_idx]] > 
+                min_obstacle_dist) {
+            break;
+        }
+    }
+    if(horizon_idx + 1 >= path_x.size()) {
+        LOG_INFO("No valid horizon goal, the complete problem will be planned");
+        return false;
+    }
+    
+    // The heading follows the coarse path.
+    const size_t lookahead = 3;
+    size_t from = horizon_idx - 1;
+    size_t to = std::min(horizon_idx + lookahead, path_x.size() - 1);
+    double yaw = atan2(path_y[to] - path_y[from], path_x[to] - path_x[from]);
+    State horizon_goal = mGoalStateGrid;
+    horizon_goal.mPose.position = base::Position(path_x[horizon_idx], path_y[horizon_idx], 0);
+    horizon_goal.mPose.orientation = Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ());
+    if(!mpPlanningLib->setStartGoal(mStartStateGrid, horizon_goal) ||
+            mpPlanningLib->isStartGoalValid() != MPL_ERR_NONE) {
+        LOG_INFO("Horizon goal is not valid, the complete problem will be planned");
+        mpPlanningLib->setStartGoal(mStartStateGrid, mGoalStateGrid);
+        return false;
+    }
+    
+    // Remaining coarse path (grid) to world, it ends with the real goal.
+    std::vector<State> suffix_grid;
+    suffix_grid.reserve(path_x.size() - horizon_idx);
+    State state_grid = mGoalStateGrid;
+    for(size_t i=horizon_idx+1; i+1 < path_x.size(); ++i) {
+        double yaw = atan2(path_y[i+1] - path_y[i-1], path_x[i+1] - path_x[i-1]);
+        state_grid.mPose.position = base::Position(path_x[i], path_y[i], 0);
+        state_grid.mPose.orientation = Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ());
+        suffix_grid.push_back(state_grid);
+    }
+    convertPathToWorld(suffix_grid, false, mHorizonSuffixInWorld, mLostX, mLostY);
+    State goal_state = mGoalState;
+    mHorizonSuffixInWorld.push_back(goal_state);
+    
+    mHorizonGoalGrid = horizon_goal;
+    mHorizonGoalActive = true;
+    
+    LOG_INFO("Receding horizon: Goal cell (%d,%d), %d coarse states up to the goal",
+            path_x[horizon_idx], path_y[horizon_idx], (int)mHorizonSuffixInWorld.size());
+    return true;
+}
+
+void MotionPlanningLibraries::resetHorizonGoal() {
+    mHorizonGoalActive = false;
+    mHorizonSuffixInWorld.clear();
+}
+
+bool MotionPlanningLibraries::requestPathInWorld(CompactPath& path_in_world) {
+    
+    // By default grid coordinates are expected.
+    bool pos_defined_in_local_grid = false;
+    
+    path_in_world.clear();
+    mPlannedPathGrid.clear();
+    mpPlanningLib->fillPath(mPlannedPathGrid, pos_defined_in_local_grid);
+    
+    if(mPlannedPathGrid.size() == 0) {
+        return false;
+    }
+    
+    convertPathToWorld(mPlannedPathGrid, pos_defined_in_local_grid, path_in_world, 
+            mLostX, mLostY);
+    return true;
+}
+
+void MotionPlanningLibraries::convertPathToWorld(std::vector<State>& planned_path, 
+        bool pos_defined_in_local_grid, CompactPath& path_in_world, 
+        double lost_x, double lost_y) {
+    
+    path_in_world.clear();
+    size_t num_states = planned_path.size();
+    if(num_states == 0) {
+        return;
+    }
+    path_in_world.reserve(num_states);
+    
+    // Arm states are not transformed.
+    if(planned_path.front().getStateType() != STATE_POSE) {
+        for(size_t i=0; i<num_states; ++i) {
+            path_in_world.push_back(planned_path[i]);
+        }
+        return;
+    }
+    
+    // Grid or grid local to local like grid2world() and gridlocal2world(),
+    // the positions are stored as arrays to transform them at once.
+    double scale_x = pos_defined_in_local_grid ? 1.0 : mpTravGrid->getScaleX();
+    double scale_y = pos_defined_in_local_grid ? 1.0 : mpTravGrid->getScaleY();
+    double offset_x = mpTravGrid->getOffsetX() + lost_x;
+    double offset_y = mpTravGrid->getOffsetY() + lost_y;
+    std::vector<double>& xs = mTransformBufferX;
+    std::vector<double>& ys = mTransformBufferY;
+    std::vector<double>& zs = mTransformBufferZ;
+    xs.resize(num_states);
+    ys.resize(num_states);
+    zs.resize(num_states);
+    for(size_t i=0; i<num_states; ++i) {
+        const base::Position& position = planned_path[i].mPose.position;
+        xs[i] = position.x() * scale_x + offset_x;
+        ys[i] = position.y() * scale_y + offset_y;
+        zs[i] = pos_defined_in_local_grid ? position.z() : 0.0;
+    }
+    
+    // One transform lookup for the complete path.
+    Eigen::Affine3d local2world = getLocal2World(mpTravGrid);
+    transformPositions(local2world, xs, ys, zs);
+    Eigen::Quaterniond local2world_rot(local2world.linear());
+    
+    // Only the yaw is kept, the planners work within the plane.
+    for(size_t i=0; i<num_states; ++i) {
+        base::Orientation orientation = local2world_rot * planned_path[i].mPose.orientation;
+        path_in_world.push_back(xs[i], ys[i], zs[i], base::getYaw(orientation), planned_path[i]);
+    }
+}
+
+bool MotionPlanningLibraries::world2gridState(struct State const& world_state, struct State& grid_state,
+        double* lost_x, double* lost_y) {
+    switch (world_state.getStateType()) {
+        case STATE_POSE: {
+            base::samples::RigidBodyState grid_pose;
+            if(!world2gridCached(world_state.getPose(), grid_pose, lost_x, lost_y)) {
+                return false;
+            }
+            grid_state = world_state;
+            grid_state.mPose = grid_pose;
+            return true;
+        }
+        case STATE_ARM: {
+            grid_state = world_state;
+            return true;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+bool MotionPlanningLibraries::prepareBatchPlanningLibs(size_t num_workers) {
+    // Each setTravGrid() creates new map data.
+    if(mpBatchTravData != mpTravData) {
+        mBatchPlanningLibs.clear();
+        mpBatchTravData = mpTravData;
+    }
+    
+    // Initialized sequentially, the environments are not prepared for 
+    // parallel initialization (e.g. the generated SBPL primitive file).
+    while(mBatchPlanningLibs.size() < num_workers) {
+        boost::shared_ptr<AbstractMotionPlanningLibrary> planning_lib = 
+                createPlanningLibrary(mConfig);
+        planning_lib->setPreprocessedMap(mpPreprocessedMap);
+        if(!planning_lib->initialize(mpTravGrid, mpBatchTravData)) {
+            LOG_WARN("Batch planning library could not be initialized");
+            return false;
+        }
+        mBatchPlanningLibs.push_back(planning_lib);
+    }
+    return true;
+}
+
+void MotionPlanningLibraries::planBatchWorker(size_t worker_id, size_t num_workers, 
+        struct State start_grid, std::vector<State>* goals_grid, base::Time deadline,
+        std::vector<BatchPlanningResult>* results, 
+        std::vector<unsigned char>* pos_defined_in_local_grid) {
+    
+    AbstractMotionPlanningLibrary* planning_lib = mBatchPlanningLibs[worker_id].get();
+    for(size_t i = worker_id; i < goals_grid->size(); i += num_workers) {
+        BatchPlanningResult& result = (*results)[i];
+        if((*goals_grid)[i].getStateType() == STATE_EMPTY) {
+            continue; // Could not be transformed into the grid.
+        }
+        if(!planning_lib->setStartGoal(start_grid, (*goals_grid)[i])) {
+            result.mError = MPL_ERR_SET_START_GOAL;
+            continue;
+        }
+        result.mError = planning_lib->isStartGoalValid();
+        if(result.mError != MPL_ERR_NONE) {
+            continue;
+        }
+        size_t num_remaining_goals = (goals_grid->size() - 1 - i) / num_workers + 1;
+        double time_for_goal = (deadline - base::Time::now()).toSeconds() / num_remaining_goals;
+        if(time_for_goal <= 0) {
+            result.mError = MPL_ERR_PLANNING_FAILED;
+            continue;
+        }
+        if(!planning_lib->solve(time_for_goal)) {
+            result.mError = MPL_ERR_PLANNING_FAILED;
+            continue;
+        }
+        bool pos_local = false;
+        planning_lib->fillPath(result.mPathInWorld, pos_local);
+        if(result.mPathInWorld.empty()) {
+            result.mError = MPL_ERR_UNDEFINED;
+            continue;
+        }
+        (*pos_defined_in_local_grid)[i] = pos_local;
+        result.mCost = planning_lib->getCost();
+        result.mSolved = true;
+    }
+}
+
+void MotionPlanningLibraries::improvedSolutionCallback(SolutionCallback solution_callback) {
+    if(!requestPathInWorld(mImprovedPathInWorld)) {
+        LOG_WARN("Improved solution does not contain any states");
+        return;
+    }
+    mImprovedPathInWorld.getStates(mImprovedStatesInWorld);
+    solution_callback(mImprovedStatesInWorld, mpPlanningLib->getCost());
+}
+
+bool MotionPlanningLibraries::processPostedInputs() {
+    bool ret = true;
+    TravGridInput trav_grid_input;
+    if(mTravGridMailbox.fetch(trav_grid_input) && 
+            !setTravGrid(trav_grid_input.mpEnv, trav_grid_input.mTravMapId)) {
+        LOG_WARN("Posted traversability map could not be set");
+        mError = MPL_ERR_INITIALIZE_MAP;
+        ret = false;
+    }
+    
+    // The goal first, setStartState() passes the current goal to the planning library.
+    State state;
+    if(mGoalStateMailbox.fetch(state) && !setGoalState(state)) {
+        LOG_WARN("Posted goal state could not be set");
+        mError = MPL_ERR_SET_START_GOAL;
+        ret = false;
+    }
+    if(mStartStateMailbox.fetch(state) && !setStartState(state)) {
+        LOG_WARN("Posted start state could not be set");
+        mError = MPL_ERR_SET_START_GOAL;
+        ret = false;
+    }
+    return ret;
+}
+
+void MotionPlanningLibraries::cancelPlanning() {
+    if(mpPlanningLib != NULL) {
+        mpPlanningLib->cancel();
+    }
+}
+
+void MotionPlanningLibraries::resetCancelPlanning() {
+    if(mpPlanningLib != NULL) {
+        mpPlanningLib->resetCancel();
+    }
+}
+
+void MotionPlanningLibraries::setProgressCallback(ProgressCallback progress_callback) {
+    if(mpPlanningLib != NULL) {
+        mpPlanningLib->setProgressCallback(progress_callback);
+    }
+}
+
 std::vector<struct State> MotionPlanningLibraries::getStatesInWorld() {
-    return mPlannedPathInWorld;
+    std::vector<State> states;
+    mPlannedPathInWorld.getStates(states);
+    return states;
+}
+
+void MotionPlanningLibraries::getStatesInWorld(std::vector<struct State>& states) {
+    mPlannedPathInWorld.getStates(states);
 }
 
 std::vector<base::Waypoint> MotionPlanningLibraries::getPathInWorld() {
     std::vector<base::Waypoint> path;
-    std::vector<State>::iterator it = mPlannedPathInWorld.begin();
-    base::Waypoint waypoint;
-    for(;it != mPlannedPathInWorld.end(); it++) {
-        waypoint.position = it->getPose().position;
-        waypoint.heading = it->getPose().getYaw();
-        path.push_back(waypoint);  
-    }
+    getPathInWorld(path);
     return path;
 }
 
+void MotionPlanningLibraries::getPathInWorld(std::vector<base::Waypoint>& path) {
+    path.resize(mPlannedPathInWorld.size());
+    for(size_t i=0; i<mPlannedPathInWorld.size(); ++i) {
+        path[i] = mPlannedPathInWorld.getWaypoint(i);  
+    }
+}
+
 std::vector<base::Trajectory> MotionPlanningLibraries::getTrajectoryInWorld() {
     
     std::vector<base::Trajectory> trajectories;
@@ -511,14 +992,14 @@ std::vector<base::Trajectory> MotionPlanningLibraries::getTrajectoryInWorld() {
     base::Vector3d last_position;
     last_position[0] = last_position[1] = last_position[2] = nan("");
      
-    std::vector<State>::iterator it = mPlannedPathInWorld.begin();  
-    LOG_DEBUG("mPlannedPathInWorld size %d", mPlannedPathInWorld.size()); 
-    for(;it != mPlannedPathInWorld.end(); it++) {
-        if(!std::isnan(it->mSpeed)) {
-            use_this_speed = it->mSpeed;
+    size_t num_states = mPlannedPathInWorld.size();
+    LOG_DEBUG("mPlannedPathInWorld size %d", (int)num_states); 
+    for(size_t i=0; i<num_states; ++i) {
+        if(!std::isnan(mPlannedPathInWorld.mSpeed[i])) {
+            use_this_speed = mPlannedPathInWorld.mSpeed[i];
         }
         // Add positions to path.
-        base::Vector3d position = it->getPose().position;
+        base::Vector3d position = mPlannedPathInWorld.getPosition(i);
         // Prevents to add the same position consecutively, otherwise
         // the spline creation fails.
         if(position != last_position) {
@@ -530,7 +1011,7 @@ std::vector<base::Trajectory> MotionPlanningLibraries::getTrajectoryInWorld() {
         // For each new speed a new trajectory will be created (if already more than one point have been added)
         // If the last point have been reached a trajectory will be created with all the remaining points
         // (or all points if only one speed has been used).
-        if((use_this_speed != last_speed && path.size() > 1) || it+1 == mPlannedPathInWorld.end()) {
+        if((use_this_speed != last_speed && path.size() > 1) || i+1 == num_states) {
             base::Trajectory trajectory;
             trajectory.speed = last_speed;  
             LOG_DEBUG("Adds trajectory with speed %4.2f, path contains %d coordinates", 
@@ -636,7 +1117,7 @@ std::vector<base::Trajectory> MotionPlanningLibraries::getEscapeTrajectoryInWorl
             // Stops if the first point does not lie on an obstacle anymore.
             // Transforms to the grid and uses the max radius of the system.
             rbs_world.position = point;
-            world2grid(mpTravGrid, rbs_world, rbs_grid, NULL, NULL); 
+            world2gridCached(rbs_world, rbs_grid); 
             grid_calc.setFootprintPoseInGrid(rbs_grid.position[0], rbs_grid.position[1], 0);
             try {
                 free_point_found = grid_calc.isValid();
@@ -680,7 +1161,7 @@ std::vector<base::Trajectory> MotionPlanningLibraries::getEscapeTrajectoryInWorl
 void MotionPlanningLibraries::printPathInWorld() {
     std::vector<base::Waypoint> waypoints = getPathInWorld();
     std::vector<base::Waypoint>::iterator it = waypoints.begin();
-    std::vector<State>::iterator it_state = mPlannedPathInWorld.begin();
+    size_t i_state = 0;
     
     int counter = 1;
     
@@ -688,21 +1169,22 @@ void MotionPlanningLibraries::printPathInWorld() {
     {
         printf("%s %s %s %s %s %s\n", "       #", "       X", "       Y",
                 "       Z", "   THETA", "  RADIUS");
-        for(; it != waypoints.end() && it_state != mPlannedPathInWorld.end(); it++, counter++, it_state++) {
+        for(; it != waypoints.end() && i_state < mPlannedPathInWorld.size(); it++, counter++, i_state++) {
             printf("%8d %8.2f %8.2f %8.2f %8.2f %8.2f\n", counter, 
                     it->position[0], it->position[1], it->position[2], 
-                    it->heading, it_state->getFootprintRadius());
+                    it->heading, mPlannedPathInWorld.mFootprintRadius[i_state]);
         }
     } 
     else if(mConfig.mEnvType == ENV_XYTHETA && mConfig.mPlanningLibType == LIB_SBPL) 
     {
         printf("%s %s %s %s %s %s %s %s\n", "       #", "       X", "       Y",
                 "       Z", "   THETA", " PRIM ID", "  SPEEDS", "MOVEMENT TYPE");
-        for(; it != waypoints.end() && it_state != mPlannedPathInWorld.end(); it++, counter++, it_state++) {
+        for(; it != waypoints.end() && i_state < mPlannedPathInWorld.size(); it++, counter++, i_state++) {
             printf("%8d %8.2f %8.2f %8.2f %8.2f %8.2d %8.2f %s\n", counter, 
                     it->position[0], it->position[1], it->position[2], 
-                    it->heading, it_state->mSBPLPrimId, it_state->mSpeed,
-                    MovementTypesString[it_state->mMovType].c_str()
+                    it->heading, mPlannedPathInWorld.mSBPLPrimId[i_state], 
+                    mPlannedPathInWorld.mSpeed[i_state],
+                    MovementTypesString[mPlannedPathInWorld.mMovType[i_state]].c_str()
                   );
         }
     } 
@@ -753,11 +1235,26 @@ bool MotionPlanningLibraries::world2grid(envire::TraversabilityGrid const* trav,
         return false;
     }
 
-    // Transforms from world to local.
-    base::samples::RigidBodyState local_pose;
     Eigen::Affine3d world2local = trav->getEnvironment()->relativeTransform(
             trav->getEnvironment()->getRootNode(),
             trav->getFrameNode());
+    return world2grid(trav, world2local, world_pose, grid_pose, lost_x, lost_y);
+}
+
+bool MotionPlanningLibraries::world2grid(envire::TraversabilityGrid const* trav,
+        Eigen::Affine3d const& world2local,
+        base::samples::RigidBodyState const& world_pose, 
+        base::samples::RigidBodyState& grid_pose,
+        double* lost_x,
+        double* lost_y) {
+    
+    if(trav == NULL) {
+        LOG_WARN("world2grid transformation requires a traversability map");
+        return false;
+    }
+    
+    // Transforms from world to local.
+    base::samples::RigidBodyState local_pose;
     local_pose.setTransform(world2local * world_pose.getTransform());
     
     // Calculate and set grid coordinates (and orientation).
@@ -816,10 +1313,7 @@ bool MotionPlanningLibraries::grid2world(envire::TraversabilityGrid const* trav,
     local_pose.position[2] = 0.0;
     
     // Transformation LOCAL2WOLRD
-    Eigen::Affine3d local2world = trav->getEnvironment()->relativeTransform(
-        trav->getFrameNode(),
-        trav->getEnvironment()->getRootNode());
-    world_pose.setTransform(local2world * local_pose.getTransform() );
+    world_pose.setTransform(getLocal2World(trav) * local_pose.getTransform() );
     
     return true;
 }
@@ -844,15 +1338,107 @@ bool MotionPlanningLibraries::gridlocal2world(envire::TraversabilityGrid const*
     grid_local_pose_tmp.position[1] += mLostY;
         
     // Transformation LOCAL2WOLRD
-    Eigen::Affine3d local2world = trav->getEnvironment()->relativeTransform(
-        trav->getFrameNode(),
-        trav->getEnvironment()->getRootNode());
-    world_pose.setTransform(local2world * grid_local_pose_tmp.getTransform() );
+    world_pose.setTransform(getLocal2World(trav) * grid_local_pose_tmp.getTransform() );
     
     return true;
 }
 
 // PRIVATE
+bool MotionPlanningLibraries::world2gridCached(base::samples::RigidBodyState const& world_pose, 
+        base::samples::RigidBodyState& grid_pose,
+        double* lost_x,
+        double* lost_y) {
+    if(!mpPreprocessedMap) {
+        return world2grid(mpTravGrid, world_pose, grid_pose, lost_x, lost_y);
+    }
+    return world2grid(mpTravGrid, mpPreprocessedMap->getWorld2Local(), 
+            world_pose, grid_pose, lost_x, lost_y);
+}
+
+Eigen::Affine3d MotionPlanningLibraries::getLocal2World(envire::TraversabilityGrid const* trav) {
+    if(mpPreprocessedMap && trav == mpPreprocessedMap->getTravGrid()) {
+        return mpPreprocessedMap->getLocal2World();
+    }
+    return trav->getEnvironment()->relativeTransform(
+        trav->getFrameNode(),
+        trav->getEnvironment()->getRootNode());
+}
+
+void MotionPlanningLibraries::transformPositions(Eigen::Affine3d const& transform,
+        std::vector<double>& xs, std::vector<double>& ys, std::vector<double>& zs) {
+    const Eigen::Matrix4d& m = transform.matrix();
+    const double m00 = m(0,0), m01 = m(0,1), m02 = m(0,2), m03 = m(0,3);
+    const double m10 = m(1,0), m11 = m(1,1), m12 = m(1,2), m13 = m(1,3);
+    const double m20 = m(2,0), m21 = m(2,1), m22 = m(2,2), m23 = m(2,3);
+    double* x = &xs[0];
+    double* y = &ys[0];
+    double* z = &zs[0];
+    // Independent iterations over contiguous arrays, vectorized by the compiler.
+    for(size_t i=0; i<xs.size(); ++i) {
+        double xi = x[i], yi = y[i], zi = z[i];
+        x[i] = m00 * xi + m01 * yi + m02 * zi + m03;
+        y[i] = m10 * xi + m11 * yi + m12 * zi + m13;
+        z[i] = m20 * xi + m21 * yi + m22 * zi + m23;
+    }
+}
+
+boost::shared_ptr<AbstractMotionPlanningLibrary> MotionPlanningLibraries::createPlanningLibrary(
+        Config const& config) {
+    boost::shared_ptr<AbstractMotionPlanningLibrary> planning_lib;
+    switch(config.mPlanningLibType) {
+        case LIB_SBPL: {
+            switch(config.mEnvType) {
+                case ENV_XY: {
+                    planning_lib = boost::shared_ptr<AbstractMotionPlanningLibrary>
+                            (new SbplEnvXY(config));    
+                    break;
+                }
+                case ENV_XYTHETA: {
+                    planning_lib = boost::shared_ptr<AbstractMotionPlanningLibrary>
+                            (new SbplEnvXYTHETA(config)); 
+                    break;
+                }
+                default: {
+                    LOG_ERROR("Environment is not available in SBPL");
+                    throw new std::runtime_error("Environment not available in SBPL");
+                }
+            }
+            break;    
+        }    
+        case LIB_OMPL: {
+            switch(config.mEnvType) {
+                case ENV_XY: {
+                    planning_lib = boost::shared_ptr<AbstractMotionPlanningLibrary>
+                            (new OmplEnvXY(config));    
+                    break;
+                }
+                case ENV_XYTHETA: {
+                    planning_lib = boost::shared_ptr<AbstractMotionPlanningLibrary>
+                            (new OmplEnvXYTHETA(config));    
+                    break;
+                }
+                case ENV_ARM: {
+                    planning_lib = boost::shared_ptr<AbstractMotionPlanningLibrary>
+                            (new OmplEnvARM(config));    
+                    break;
+                }
+                case ENV_SHERPA: {
+                    planning_lib = boost::shared_ptr<AbstractMotionPlanningLibrary>
+                            (new OmplEnvSHERPA(config));    
+                    break;
+                }
+                //mpPlanningLib = boost::shared_ptr<AbstractMotionPlanningLibrary>(new Ompl(config));
+                default: {
+                    LOG_ERROR("Environment is not available in OMPL");
+                    throw new std::runtime_error("Environment not available in OMPL");
+                }
+            }
+            break;
+        }
+    }
+    return planning_lib;
+}
+
 envire::TraversabilityGrid* MotionPlanningLibraries::extractTravGrid(envire::Environment* env, 
         std::string trav_map_id) {
     typedef envire::TraversabilityGrid e_trav;
@@ -877,12 +1463,12 @@ envire::TraversabilityGrid* MotionPlanningLibraries::extractTravGrid(envire::Env
     }
 }
 
-void MotionPlanningLibraries::collectCellUpdates( envire::TraversabilityGrid* old_map,
-        envire::TraversabilityGrid* new_map,
+void MotionPlanningLibraries::collectCellUpdates(
+        boost::shared_ptr<const PreprocessedMap> old_map,
+        boost::shared_ptr<const PreprocessedMap> new_map,
         std::vector<CellUpdate>& cell_updates) {
     
-    assert(old_map->getCellSizeX() == new_map->getCellSizeX());
-    assert(old_map->getCellSizeY() == new_map->getCellSizeY());
+    assert(old_map->getTravData()->num_elements() == new_map->getTravData()->num_elements());
 
     base::Time start_t = base::Time::now();
     
@@ -891,21 +1477,18 @@ void MotionPlanningLibraries::collectCellUpdates( envire::TraversabilityGrid* ol
     double driveability = 0.0;
     double probability = 0.0;
     
-    envire::Grid<uint8_t>::ArrayType& trav_old = old_map->getGridData(envire::TraversabilityGrid::TRAVERSABILITY);
-    envire::Grid<uint8_t>::ArrayType& prob_old = old_map->getGridData(envire::TraversabilityGrid::PROBABILITY);
-    envire::Grid<uint8_t>::ArrayType& trav_new = new_map->getGridData(envire::TraversabilityGrid::TRAVERSABILITY);
-    envire::Grid<uint8_t>::ArrayType& prob_new = new_map->getGridData(envire::TraversabilityGrid::PROBABILITY);
-    
-    uint8_t* trav_old_p = trav_old.origin();
-    uint8_t* prob_old_p = prob_old.origin();
-    uint8_t* trav_new_p = trav_new.origin();
-    uint8_t* prob_new_p = prob_new.origin();
+    const uint8_t* trav_old_p = old_map->getTravData()->origin();
+    const uint8_t* prob_old_p = old_map->getProbabilityData()->origin();
+    const uint8_t* trav_new_p = new_map->getTravData()->origin();
+    const uint8_t* prob_new_p = new_map->getProbabilityData()->origin();
+    unsigned int size_x = new_map->getCellSizeX();
+    unsigned int size_y = new_map->getCellSizeY();
     
     // TODO Probability relevant? Currently not used as double.
-    for(unsigned int y=0; y < new_map->getCellSizeY(); ++y) {
-        for(unsigned int x=0; x < new_map->getCellSizeX(); ++x) {
+    for(unsigned int y=0; y < size_y; ++y) {
+        for(unsigned int x=0; x < size_x; ++x) {
             if(*trav_old_p != *trav_new_p || *prob_old_p != *prob_new_p) {
-                driveability = new_map->getTraversabilityClass(*trav_new_p).getDrivability();
+                driveability = new_map->getDriveability(*trav_new_p);
                 // Does the same conversion which is done in TraversabilityGrid.
                 probability = ((double)*prob_new_p) /std::numeric_limits< uint8_t >::max();
                 cell_updates.push_back(CellUpdate(x, y, *trav_new_p, probability, driveability));
@@ -925,4 +1508,115 @@ void MotionPlanningLibraries::collectCellUpdates( envire::TraversabilityGrid* ol
     LOG_INFO("Number of unchanged cells %d", cell_counter_same);
 }
 
+bool MotionPlanningLibraries::isPlannedPathValid(
+        boost::shared_ptr<const PreprocessedMap> old_map,
+        boost::shared_ptr<const PreprocessedMap> new_map) {
+    
+    if(!old_map || mPlannedPathInWorld.empty() || 
+            mPlannedPathInWorld.mStateType != STATE_POSE) {
+        return false;
+    }
+    
+    // The grid of the old map may not exist anymore, only its snapshot is used.
+    if(!old_map->hasSameGeometry(*new_map) ||
+            !old_map->getWorld2Local().isApprox(new_map->getWorld2Local())) {
+        LOG_INFO("Map size or frame has changed, the path cannot be checked");
+        return false;
+    }
+    
+    base::Time start_t = base::Time::now();
+    
+    const TravData& old_data = *old_map->getTravData();
+    const TravData& new_data = *new_map->getTravData();
+    envire::TraversabilityGrid* new_grid = new_map->getTravGrid();
+    int size_x = new_map->getCellSizeX();
+    int size_y = new_map->getCellSizeY();
+    double old_cost = 0.0;
+    double new_cost = 0.0;
+    unsigned int num_changed_states = 0;
+    base::samples::RigidBodyState world_pose, grid_pose;
+    
+    for(size_t i=0; i<mPlannedPathInWorld.size(); ++i) {
+        world_pose.position = mPlannedPathInWorld.getPosition(i);
+        world_pose.orientation = mPlannedPathInWorld.getOrientation(i);
+        if(!world2grid(new_grid, new_map->getWorld2Local(), world_pose, grid_pose)) {
+            return false;
+        }
+        int x_grid = grid_pose.position.x();
+        int y_grid = grid_pose.position.y();
+        double radius = mPlannedPathInWorld.mFootprintRadius[i] > 0 ? 
+                mPlannedPathInWorld.mFootprintRadius[i] : mConfig.getMaxRadius();
+        int radius_grid = std::ceil(radius / new_map->getScaleX());
+        
+        // Only the changed cells below the footprint are tested.
+        bool changed = false;
+        for(int dy=-radius_grid; dy <= radius_grid; ++dy) {
+            for(int dx=-radius_grid; dx <= radius_grid; ++dx) {
+                if(dx*dx + dy*dy > radius_grid*radius_grid) {
+                    continue;
+                }
+                int x = x_grid + dx, y = y_grid + dy;
+                if(x < 0 || x >= size_x || y < 0 || y >= size_y) {
+                    continue; // Unchanged as well, the planners handle the border.
+                }
+                uint8_t old_klass = old_data[y][x];
+                uint8_t new_klass = new_data[y][x];
+                if(old_klass == new_klass && 
+                        old_map->getDriveability(old_klass) == new_map->getDriveability(new_klass)) {
+                    continue;
+                }
+                changed = true;
+                if(new_map->getDriveability(new_klass) == 0.0) {
+                    LOG_INFO("Current path collides with a new obstacle at cell (%d,%d)", x, y);
+                    return false;
+                }
+            }
+        }
+        if(changed) {
+            num_changed_states++;
+        }
+        old_cost += PreprocessedMap::driveability2cost(
+                old_map->getDriveability(old_data[y_grid][x_grid]), PATH_CHECK_MAX_COST);
+        new_cost += PreprocessedMap::driveability2cost(
+                new_map->getDriveability(new_data[y_grid][x_grid]), PATH_CHECK_MAX_COST);
+    }
+    
+    LOG_INFO("Path check: %d of %d states below changed cells, costs %4.2f -> %4.2f within %4.4f sec", 
+            num_changed_states, (int)mPlannedPathInWorld.size(), old_cost, new_cost,
+            (base::Time::now() - start_t).toSeconds());
+    
+    return new_cost <= old_cost * (1.0 + mConfig.mReplanning.mReplanPathCostTolerance);
+}
+
+void MotionPlanningLibraries::registerStateUpdate(bool start_update) {
+    // Older updates lose their influence, so the direction follows 
+    // a changing usage (e.g. a static robot which starts to move).
+    const double decay = 0.8;
+    mStartUpdateRate *= decay;
+    mGoalUpdateRate *= decay;
+    if(start_update) {
+        mStartUpdateRate += 1.0;
+    } else {
+        mGoalUpdateRate += 1.0;
+    }
+}
+
+void MotionPlanningLibraries::updateSearchDirection() {
+    // Required ratio between both update rates to change the direction.
+    const double hysteresis = 2.0;
+    bool forward = true;
+    if(mStartUpdateRate > hysteresis * mGoalUpdateRate) {
+        forward = false;
+    } else if(mGoalUpdateRate > hysteresis * mStartUpdateRate) {
+        forward = true;
+    } else {
+        return;
+    }
+    LOG_DEBUG("Start update rate %4.2f, goal update rate %4.2f, use %s search", 
+            mStartUpdateRate, mGoalUpdateRate, forward ? "forward" : "backward");
+    if(!mpPlanningLib->setForwardSearch(forward)) {
+        LOG_DEBUG("Search direction could not be changed");
+    }
+}
+
 } // namespace motion_planning_libraries
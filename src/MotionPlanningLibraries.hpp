@@ -1,6 +1,10 @@
 #ifndef _MOTION_PLANNING_LIBRARIES_HPP_
 #define _MOTION_PLANNING_LIBRARIES_HPP_
 
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
 #include <base/samples/RigidBodyState.hpp>
 #include <base/Waypoint.hpp>
 #include <base/Trajectory.hpp>
@@ -10,11 +14,53 @@
 #include "Config.hpp"
 #include "State.hpp"
 #include "AbstractMotionPlanningLibrary.hpp"
+#include "CompactPath.hpp"
+#include "CostToGo.hpp"
+#include "Mailbox.hpp"
+#include "PlanningHandle.hpp"
 
 namespace motion_planning_libraries
 {
 
 typedef envire::TraversabilityGrid::ArrayType TravData;
+
+/**
+ * Receives each improved solution during MotionPlanningLibraries::plan(),
+ * the path is defined within the world frame.
+ */
+typedef boost::function<void (const std::vector<struct State>& path_in_world, double cost)> SolutionCallback;
+
+/**
+ * Result of a single goal of MotionPlanningLibraries::planBatch().
+ */
+struct BatchPlanningResult {
+    bool mSolved;
+    // Cost of the path or nan if not available.
+    double mCost;
+    enum MplErrors mError;
+    std::vector<struct State> mPathInWorld;
+    
+    BatchPlanningResult() : mSolved(false), 
+            mCost(nan("")), 
+            mError(MPL_ERR_NONE), 
+            mPathInWorld() {
+    }
+};
+
+/**
+ * Traversability map posted by MotionPlanningLibraries::postTravGrid().
+ */
+struct TravGridInput {
+    envire::Environment* mpEnv;
+    std::string mTravMapId;
+    
+    TravGridInput() : mpEnv(NULL), mTravMapId() {
+    }
+    
+    TravGridInput(envire::Environment* env, std::string trav_map_id) : 
+            mpEnv(env), mTravMapId(trav_map_id) {
+    }
+};
     
 /**
  * \mainpage MPL - Motion Planning Libraries
@@ -100,23 +146,44 @@ typedef envire::TraversabilityGrid::ArrayType TravData;
  * | ---------------- | ----------- |
  * | mPlanningLibType | Defines the planning library, see motion_planning_libraries::PlanningLibraryType |
  * | mEnvType         | Defines the environment, see motion_planning_libraries::EnvType | 
+ * | mNumThreads      | Number of threads for parallelizable computations, 0 uses all cores. |
+ * | mRecedingHorizon | (optional) Searches in detail only up to this distance (m) along a coarse 2D path, which is appended up to the goal. The coarse part only keeps its cells off obstacles and ignores the footprint, it is replaced while the horizon moves on. Bounds the planning time of far goals, pose environments only. |
+ * | mReplanning.mReplanOnlyIfPathInvalid | (optional) A new map only initiates a replanning if the current path collides with a changed cell or its costs increase by more than mReplanning.mReplanPathCostTolerance. Requires maps of the same size and frame. |
  * \subsection OMPL
  * | Environment | Parameter              | Description |
  * | ----------- | ---------------------- | ----------- |
  * | ENV_XYTHETA | mMobilty               | mSpeed and mTurningSpeed are used to define the control space and to calculate the cost traversing a grid cell. |
  * |             | mFootprintLengthMinMax | Used for the car ODE. | 
+ * |             | mOmplSteering          | (optional) STEERING_DUBINS or STEERING_REEDS_SHEPP connect the states with curves of mMinTurningRadius and use the geometric planners instead of the control problem. |
  * | ENV_SHERPA  | mFootprintRadiusMinMax | Footprint is defined as a circle here. |
  * |             | mNumFootprintClasses   | To reduce the plannign dimension the footprint radius is descretized. |
  * |             | mTimeToAdaptFootprint  | Time to change the system from min to max footprint. |
  * |             | mAdaptFootprintPenalty | Additional costs which are added if the footprint changes between two states. | 
  * | ENV_ARM     | mJointBorders          | Borders of the arm joints. |
+ * | all         | mPlanner               | (optional) Geometric planners RRT_CONNECT, RRT_STAR, INFORMED_RRT_STAR, BIT_STAR, RRT_SHARP, PRM_STAR, LAZY_PRM_STAR or KPIECE, for ENV_XYTHETA KPIECE or SST. By default RRTConnect / RRT* (mSearchUntilFirstSolution) and control RRT for ENV_XYTHETA. |
+ * |             | mMaxAllowedSampleDist  | (optional) Passed as 'range' to the planner. |
+ * |             | mOmplGoalBias          | (optional) Passed as 'goal_bias' to the planner. |
+ * | geometric   | mOmplNumParallelPlanners | (optional) Number of planner instances solving the problem concurrently, the best solution is used. |
+ * |             | mOmplMultiQuery        | (optional) PRM* / LazyPRM* keeps its roadmap for all queries on the same map. |
+ * |             | mOmplRoadmapFile       | (optional) Multi-query mode: Roadmap file, loaded if it belongs to the current map, see saveRoadmap(). |
+ * |             | mOmplWarmStart         | (optional) RRT* starts each new search with the repaired last solution. |
+ * |             | mOmplSimplificationTime | (optional) Additional time to shorten and smooth the found path in parallel. |
+ * | all         | mOmplCostTolerance     | (optional) Optimizing planners stop within this fraction above the straight line lower bound of the costs. |
+ * |             | mOmplStagnationTime    | (optional) Optimizing planners stop if the costs have not been improved within this time. |
+ * |             | mOmplPooledStates      | (optional) Allocates the states from per-thread arenas instead of the heap, unused arenas are released with each new start / goal. |
+ * | geometric   | mOmplGridNearestNeighbors | (optional) RRT* and RRTConnect use a bucket grid for the nearest neighbor queries. |
+ * | all but ARM | mOmplFreeCellSampling  | (optional) Samples only the valid cells of the map, weighted by their driveability. ENV_SHERPA samples only the footprint classes which fit into the cell, preferring the larger ones. |
  * \subsection SBPL
  * | Environment | Parameter | Description |
  * | ----------- | ------------------------- | ----------- |
  * | ENV_XY      | mSBPLEnvFile              | (optional) Allows to load an SBPL environment instead of using the Envire traversability map. | 
  * | ENV_XYTHETA | mMobilty                  | Speeds are used together with the multipliers for the cost calculation. In addition the multipliers are used to activates the movement types (>0). mMinTurnignRadius takes care that the curve primitives are driveable for the system. | 
  * |             | mSBPLEnvFile              | (optional) Allows to load an SBPL environment instead of using the Envire traversability map. | 
+ * |             | mGoalPosTolerance         | (optional) The search ends within this distance (m) to the goal. |
+ * |             | mGoalYawTolerance         | (optional) The search ends within this heading difference (rad) to the goal. |
+ * |             | mSBPLAutoSearchDirection  | (optional, AD*) Searches from the goal to the robot if the start changes more often than the goal to reuse the search tree. |
  * |             | mSBPLMotionPrimitivesFile | (optional) Allows to use an existing SBPL primitive file instead of creating one based on the mMobility parameters. |
+ * |             | mNumAngles                | Number of discrete angles (8, 16, 32 or 64) used to generate the primitives. Fewer angles speed up (re-)planning, more angles allow precise docking maneuvers. Ignored if mSBPLMotionPrimitivesFile is used. |
  * |             | mFootprintLengthMinMax    | The max value is used to define the robot length in SBPL. |
  * |             | mFootprintWidthMinMax     | The max value is used to define the robot width in SBPL. |
  * |             | mNumIntermediatePoints    | Sets the number of intermediate points which are added to each primitive to create smoother trajectories. |
@@ -137,26 +204,177 @@ typedef envire::TraversabilityGrid::ArrayType TravData;
  */
 class MotionPlanningLibraries
 {   
+    friend class PlanningHandle;
+    
+    // Driveability 0.0 to 1.0 is mapped to PATH_CHECK_MAX_COST + 1 to 1 to compare 
+    // the costs of the planned path on the old and the new map, like Sbpl::SBPL_MAX_COST.
+    static const unsigned char PATH_CHECK_MAX_COST = 20;
+    
     Config mConfig;
     
     boost::shared_ptr<AbstractMotionPlanningLibrary> mpPlanningLib;
     
     envire::TraversabilityGrid* mpTravGrid;
     boost::shared_ptr<TravData> mpTravData;
-    // Receives a copy of each trav grid, which is used for partial update testing.
-    envire::TraversabilityGrid* mpLastTravGrid;
+    // Current map, shared with other planners which plan on the same map.
+    // The last map is used for partial update testing.
+    boost::shared_ptr<const PreprocessedMap> mpPreprocessedMap;
     struct State mStartState, mGoalState; // Pose in world coordinates.
     struct State mStartStateGrid, mGoalStateGrid;
-    std::vector<State> mPlannedPathInWorld; // Pose in world coordinates.
+    CompactPath mPlannedPathInWorld; // Pose in world coordinates.
     bool mReplanRequired;
     bool mNewGoalReceived;
     double mLostX; // Used to trac discretization error.
     double mLostY;
+    // Exponentially decayed number of start/goal updates, used to 
+    // select the search direction (Config::mSBPLAutoSearchDirection).
+    double mStartUpdateRate;
+    double mGoalUpdateRate;
+    // Planning time in seconds which has not been used by the last plan() call.
+    double mUnusedPlanningTime;
+    // Last handle returned by planAsync(), used to prevent concurrent plannings.
+    boost::weak_ptr<PlanningHandle> mpAsyncPlanning;
+    // One planning library per planBatch() worker, initialized with mpBatchTravData.
+    std::vector< boost::shared_ptr<AbstractMotionPlanningLibrary> > mBatchPlanningLibs;
+    boost::shared_ptr<TravData> mpBatchTravData;
+    // Latest inputs of the post*() methods, taken over by plan().
+    Mailbox<TravGridInput> mTravGridMailbox;
+    Mailbox<State> mStartStateMailbox;
+    Mailbox<State> mGoalStateMailbox;
+    // Receding horizon (Config::mRecedingHorizon): Coarse cost-to-go to the current
+    // goal and the part of the path beyond the horizon in world coordinates.
+    CostToGo mCostToGo;
+    CompactPath mHorizonSuffixInWorld;
+    // Goal of the planning library while the receding horizon is used,
+    // kept until a new goal or map is received or the robot approaches it.
+    bool mHorizonGoalActive;
+    State mHorizonGoalGrid;
+    // Buffers which are reused by each plan(), so the code of this library does not
+    // allocate memory within a replanning cycle once they have reached the path size.
+    // The searches of SBPL and OMPL still allocate internally.
+    std::vector<State> mPlannedPathGrid;
+    std::vector<double> mTransformBufferX;
+    std::vector<double> mTransformBufferY;
+    std::vector<double> mTransformBufferZ;
+    CompactPath mImprovedPathInWorld;
+    std::vector<State> mImprovedStatesInWorld;
+    
+    /**
+     * Counts a new start or goal state for the search direction selection.
+     */
+    void registerStateUpdate(bool start_update);
+    
+    /**
+     * Searches backwards if the start changes clearly more often than the goal
+     * and forward in the opposite case. A hysteresis prevents toggling, because
+     * each change discards the search tree.
+     */
+    void updateSearchDirection();
+    
+    /**
+     * Receding horizon: If the coarse path to the goal exceeds mRecedingHorizon
+     * the first valid state on it beyond the horizon is passed to the planning
+     * library as goal and the remaining coarse path is stored in mHorizonSuffixInWorld.
+     * The horizon goal stays within the planning library until the start
+     * comes closer than half the horizon. Only the horizon goal is checked with 
+     * the footprint, the cells of the coarse path are merely free of obstacles.
+     * \return true if a horizon goal is used, false to plan the complete problem.
+     */
+    bool setHorizonGoal();
+    
+    /**
+     * Drops the horizon goal and the coarse path, the caller has to pass
+     * the real goal to the planning library.
+     */
+    void resetHorizonGoal();
+    
+    /**
+     * Requests the current solution of the planning library and 
+     * converts it to the world frame.
+     */
+    bool requestPathInWorld(CompactPath& path_in_world);
+    
+    /**
+     * Converts the path of a planning library from grid or grid local to world.
+     * \param lost_x, lost_y Discretization error of the goal of the path, see world2grid().
+     */
+    void convertPathToWorld(std::vector<State>& planned_path, bool pos_defined_in_local_grid,
+            CompactPath& path_in_world, double lost_x, double lost_y);
+    
+    /**
+     * world2grid() using the transformation cached by the current map.
+     */
+    bool world2gridCached(base::samples::RigidBodyState const& world_pose, 
+            base::samples::RigidBodyState& grid_pose,
+            double* lost_x = NULL,
+            double* lost_y = NULL);
+    
+    /**
+     * Returns the cached transformation if trav belongs to the current map,
+     * otherwise the envire frame tree is used.
+     */
+    Eigen::Affine3d getLocal2World(envire::TraversabilityGrid const* trav);
+    
+    /**
+     * Applies the affine transformation to the positions (structure of arrays).
+     */
+    static void transformPositions(Eigen::Affine3d const& transform,
+            std::vector<double>& xs, std::vector<double>& ys, std::vector<double>& zs);
+    
+    /**
+     * Transforms a pose state from world to grid, arm states are copied.
+     */
+    bool world2gridState(struct State const& world_state, struct State& grid_state,
+            double* lost_x = NULL, double* lost_y = NULL);
+    
+    /**
+     * Creates and initializes the worker libraries of planBatch()
+     * if they do not use the current map yet.
+     */
+    bool prepareBatchPlanningLibs(size_t num_workers);
+    
+    /**
+     * Plans the goals worker_id, worker_id + num_workers, ... using
+     * mBatchPlanningLibs[worker_id]. The time until the deadline is split 
+     * between the remaining goals of the worker, so the time left by fast 
+     * solutions is used by the following goals. 
+     * The paths are stored in grid coordinates.
+     */
+    void planBatchWorker(size_t worker_id, size_t num_workers, struct State start_grid, 
+            std::vector<State>* goals_grid, base::Time deadline,
+            std::vector<BatchPlanningResult>* results, 
+            std::vector<unsigned char>* pos_defined_in_local_grid);
+    
+    /**
+     * Registered at the planning library if plan() has been called with a callback,
+     * converts the improved solution and passes it to the user callback.
+     */
+    void improvedSolutionCallback(SolutionCallback solution_callback);
+    
+    /**
+     * Thread-safe, used by PlanningHandle to stop the running solve().
+     */
+    void cancelPlanning();
+    
+    void resetCancelPlanning();
+    
+    /**
+     * Used by PlanningHandle to receive the search progress of the planning
+     * library, an empty function removes the callback.
+     */
+    void setProgressCallback(ProgressCallback progress_callback);
+    
+    /**
+     * Sets the map, the goal and the start state (in this order) which have
+     * been posted since the last call. 
+     * \return false if one of the posted inputs could not be set.
+     */
+    bool processPostedInputs();
     
  public: 
     enum MplErrors mError; 
      
-    MotionPlanningLibraries(Config config = Config());
+    MotionPlanningLibraries(Config const& config = Config());
     ~MotionPlanningLibraries();
     
     /**
@@ -168,6 +386,15 @@ class MotionPlanningLibraries
      */
     bool setTravGrid(envire::Environment* env, std::string trav_map_id);
     
+    /**
+     * Like setTravGrid(), but uses a map which can be shared by several 
+     * MotionPlanningLibraries objects with different configs (e.g. a fleet of 
+     * robots on the same site). The map data and the data derived from it 
+     * (SBPL costs, obstacle distances, map id) are only created once.
+     * setTravGrid() creates a private preprocessed map.
+     */
+    bool setPreprocessedMap(boost::shared_ptr<const PreprocessedMap> preprocessed_map);
+    
     inline bool travGridAvailable() {
         return mpTravGrid != NULL;
     }
@@ -177,7 +404,7 @@ class MotionPlanningLibraries
      * within the world frame. This pose is transformed to the traversability 
      * grid and is used to set mStartGrid.
      */
-    bool setStartState(struct State new_state);
+    bool setStartState(struct State const& new_state);
     
     inline bool startStateAvailable() {
         return (mStartState.mStateType != STATE_EMPTY);
@@ -190,12 +417,28 @@ class MotionPlanningLibraries
      * \param reset A reset does not set mReplanningRequired and mNewGoalReceived to true.
      * This is used in setTravGrid to reset the old start/goal pose within the new environment.
      */
-    bool setGoalState(struct State new_state, bool reset = false);
+    bool setGoalState(struct State const& new_state, bool reset = false);
     
     inline bool goalStateAvailable() {
         return (mGoalState.mStateType != STATE_EMPTY);
     }
     
+    /**
+     * Thread-safe and lock-free versions of setTravGrid(), setStartState() and
+     * setGoalState() which can be called at any time, e.g. with 100 Hz 
+     * pose updates while plan() or planAsync() is running. Only the latest
+     * value of each input is kept, it is taken over at the beginning of the 
+     * next plan() call. So the inputs never wait for a running search and
+     * a search never sees inputs changing. Each post method must only be
+     * called by one thread, the posted map must not be changed until the
+     * next plan() call has started.
+     */
+    void postTravGrid(envire::Environment* env, std::string trav_map_id);
+    
+    void postStartState(struct State new_state);
+    
+    void postGoalState(struct State new_state);
+    
     /**
      * Checks if the trav map, start pose and goal pose are available.
      * The trav map is required to set start and goal.
@@ -214,6 +457,43 @@ class MotionPlanningLibraries
      */
     bool foundFinalSolution();
     
+    /**
+     * Returns the number of state expansions of the last planning run
+     * or -1 if this is not supported by the planning library.
+     */
+    int getNumExpansions();
+    
+    /**
+     * Returns the suboptimality bound of the last solution (SBPL epsilon)
+     * or nan if this is not supported by the planning library.
+     */
+    double getEpsilon();
+    
+    /**
+     * Current search direction of the planning library, 
+     * see Config::mSBPLAutoSearchDirection.
+     */
+    bool isForwardSearch();
+    
+    /**
+     * OMPL multi-query mode: Stores the current roadmap to mConfig.mOmplRoadmapFile,
+     * so it can be reused for the same map after a restart.
+     */
+    bool saveRoadmap();
+    
+    /**
+     * OMPL multi-query mode: Number of vertices of the current roadmap.
+     */
+    unsigned int getNumRoadmapVertices();
+    
+    /**
+     * Returns the time in seconds the last plan() call has saved by stopping 
+     * before max_time (e.g. first solution, mOmplCostTolerance or mOmplStagnationTime).
+     */
+    double getUnusedPlanningTime() {
+        return mUnusedPlanningTime;
+    }
+    
     /**
      * Tries to find a trajectory within the passed time.
      * If this method is called several times (with the same configurations),
@@ -229,15 +509,78 @@ class MotionPlanningLibraries
      */
     bool plan(double max_time, double& cost); 
     
+    /**
+     * Like plan(), but \a solution_callback is called for each improved solution
+     * found during planning (each epsilon step of the SBPL anytime planners, each 
+     * cost improvement of the optimizing OMPL planners). This allows to start 
+     * driving on the first solution while the planner refines it. The final 
+     * solution is still available via getStatesInWorld(std::vector<State>&) after
+     * plan() returns.
+     * The callback is called within the planning thread, so it should return quickly.
+     */
+    bool plan(double max_time, double& cost, SolutionCallback solution_callback);
+    
+    /**
+     * Starts plan() within its own thread and returns immediately, so a real-time
+     * loop never blocks on planning. The returned handle allows to cancel the 
+     * planning, to query its progress and to poll the result. Until the handle
+     * reports isDone() this object must not be used (apart from the post*() 
+     * methods), the final path is available via 
+     * getStatesInWorld(std::vector<State>&) afterwards.
+     * \return An empty pointer if the last asynchronous planning is still running.
+     */
+    boost::shared_ptr<PlanningHandle> planAsync(double max_time);
+    
+    /**
+     * Plans from one start to many goals (e.g. frontiers or docking spots) on the 
+     * current map, independent of the start and goal of plan(). The goals are 
+     * distributed over mConfig.mNumThreads workers, each worker uses its own
+     * planning library. All workers share the read-only map data and its 
+     * cost map conversion (PreprocessedMap), they are initialized once per map 
+     * and reused by the following batches. Goal dependent data like the 
+     * heuristics of the SBPL environments is still computed by each worker.
+     * \param budget Time in seconds for the complete batch including the 
+     * initialization of the workers. The time left until this deadline is 
+     * shared by the remaining goals of each worker.
+     * \param results Receives one result per goal (same order), the paths
+     * are defined within the world frame.
+     * \return false if the batch could not be started (e.g. no map or invalid start),
+     * otherwise the results have to be checked.
+     */
+    bool planBatch(struct State start_state, std::vector<struct State> const& goal_states,
+            double budget, std::vector<BatchPlanningResult>& results);
+    
     /**
      * Like getStates() but with world coordinates.
+     * The states are created from getCompactPathInWorld() with each call and
+     * returned within a new vector, so each call allocates. Within a replanning
+     * loop use getStatesInWorld(std::vector<State>&) instead.
      */
     std::vector<struct State> getStatesInWorld();
     
+    /**
+     * Fills the passed vector, which can be reused to prevent allocations.
+     * States with joint angles still allocate for their own joint vector.
+     */
+    void getStatesInWorld(std::vector<struct State>& states);
+    
+    /**
+     * The planned path in world coordinates without any copy, valid
+     * until the next plan() call.
+     */
+    inline const CompactPath& getCompactPathInWorld() const {
+        return mPlannedPathInWorld;
+    }
+    
     // POSE SPECIFIC METHODS.
     /** Returns the path stored in mPath as a list of waypoints. */
     std::vector<base::Waypoint> getPathInWorld();
     
+    /**
+     * Fills the passed vector, which can be reused to prevent allocations.
+     */
+    void getPathInWorld(std::vector<base::Waypoint>& path);
+    
     /** 
      * Returns the path stored in mPath as a trajectory (spline). 
      * If the speed parameter is set it will be used, otherwise
@@ -294,9 +637,21 @@ class MotionPlanningLibraries
         base::samples::RigidBodyState& grid_pose,
         double* lost_x = NULL,
         double* lost_y = NULL);
+    
+    /**
+     * Like world2grid() but uses the passed world to grid local transformation
+     * instead of walking the envire frame tree.
+     */
+    static bool world2grid(envire::TraversabilityGrid const* trav, 
+        Eigen::Affine3d const& world2local,
+        base::samples::RigidBodyState const& world_pose, 
+        base::samples::RigidBodyState& grid_pose,
+        double* lost_x = NULL,
+        double* lost_y = NULL);
         
     /**
      * Transforms the grid-coordinates to grid local to world.
+     * The transformation of the current map is cached.
      */
     bool grid2world(envire::TraversabilityGrid const* trav,
             base::samples::RigidBodyState const& grid_pose, 
@@ -312,6 +667,11 @@ class MotionPlanningLibraries
         base::samples::RigidBodyState& world_pose);
     
  private:
+    /**
+     * Creates the planning library and environment defined in the config.
+     */
+    static boost::shared_ptr<AbstractMotionPlanningLibrary> createPlanningLibrary(Config const& config);
+    
     /**
      * Extracts the traversability map \a trav_map_id from the passed environment.
      * If the id is not available, the first traversability map will be used.
@@ -324,9 +684,19 @@ class MotionPlanningLibraries
      * The size of both maps have to be the same.
      * TODO Currently 
      */
-    void collectCellUpdates( envire::TraversabilityGrid* old_map, 
-            envire::TraversabilityGrid* new_map,
+    void collectCellUpdates(boost::shared_ptr<const PreprocessedMap> old_map, 
+            boost::shared_ptr<const PreprocessedMap> new_map,
             std::vector<CellUpdate>& cell_updates);
+    
+    /**
+     * Sweeps the footprint along mPlannedPathInWorld through the new map,
+     * only cells which differ from the old map are tested.
+     * \return false if the footprint hits a new obstacle or leaves the grid,
+     * if the costs along the path increase by more than mReplanPathCostTolerance
+     * or if the maps differ in size or frame.
+     */
+    bool isPlannedPathValid(boost::shared_ptr<const PreprocessedMap> old_map, 
+            boost::shared_ptr<const PreprocessedMap> new_map);
 };
 
 } // end namespace motion_planning_libraries
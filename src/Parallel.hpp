@@ -0,0 +1,118 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_PARALLEL_HPP_
+#define _MOTION_PLANNING_LIBRARIES_PARALLEL_HPP_
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+namespace motion_planning_libraries
+{
+
+/**
+ * Small helper to distribute independent tasks over a number of threads.
+ * Each task is identified by its index, so the callers can write their
+ * results into preallocated per-task buffers and merge them afterwards
+ * in index order. This keeps the result independent of the thread scheduling.
+ */
+class ParallelFor
+{
+ public:
+    /**
+     * \param num_threads Number of worker threads, 0 uses the number of
+     * available cores.
+     */
+    ParallelFor(unsigned int num_threads = 0) : mNumThreads(num_threads),
+            mMutex(), mNextTask(0), mNumTasks(0), mTask(), mErrorMsg() {
+        if(mNumThreads == 0) {
+            mNumThreads = boost::thread::hardware_concurrency();
+        }
+        if(mNumThreads == 0) {
+            mNumThreads = 1;
+        }
+    }
+
+    unsigned int getNumThreads() const {
+        return mNumThreads;
+    }
+
+    /**
+     * Calls task(i) for all i in [0, num_tasks) and returns after all
+     * tasks have been processed. If a task throws, the remaining tasks are
+     * skipped and a std::runtime_error containing the first error
+     * message is thrown within the calling thread.
+     */
+    void run(size_t num_tasks, boost::function<void (size_t)> task) {
+        mNextTask = 0;
+        mNumTasks = num_tasks;
+        mTask = task;
+        mErrorMsg.clear();
+
+        unsigned int num_threads = std::min<size_t>(mNumThreads, num_tasks);
+        if(num_threads <= 1) {
+            // No need to start a thread, exceptions are passed directly.
+            for(size_t i=0; i<num_tasks; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        boost::thread_group threads;
+        for(unsigned int i=0; i<num_threads; ++i) {
+            threads.create_thread(boost::bind(&ParallelFor::worker, this));
+        }
+        threads.join_all();
+
+        if(!mErrorMsg.empty()) {
+            throw std::runtime_error(mErrorMsg);
+        }
+    }
+
+ private:
+    unsigned int mNumThreads;
+    boost::mutex mMutex;
+    size_t mNextTask;
+    size_t mNumTasks;
+    boost::function<void (size_t)> mTask;
+    std::string mErrorMsg;
+
+    /**
+     * Requests the next task index, returns false if all tasks
+     * have been distributed or an error occurred.
+     */
+    bool nextTask(size_t& task_id) {
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        if(mNextTask >= mNumTasks || !mErrorMsg.empty()) {
+            return false;
+        }
+        task_id = mNextTask++;
+        return true;
+    }
+
+    void worker() {
+        size_t task_id = 0;
+        while(nextTask(task_id)) {
+            try {
+                mTask(task_id);
+            } catch (std::exception& e) {
+                setError(e.what());
+            } catch (...) {
+                setError("Unknown exception within a parallel task");
+            }
+        }
+    }
+
+    void setError(std::string msg) {
+        boost::lock_guard<boost::mutex> lock(mMutex);
+        if(mErrorMsg.empty()) {
+            mErrorMsg = msg;
+        }
+    }
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_PARALLEL_HPP_
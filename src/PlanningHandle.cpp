@@ -0,0 +1,138 @@
+#include "PlanningHandle.hpp"
+
+#include <exception>
+
+#include <boost/bind.hpp>
+
+#include <base-logging/Logging.hpp>
+
+#include "MotionPlanningLibraries.hpp"
+
+namespace motion_planning_libraries
+{
+
+// PUBLIC
+PlanningHandle::~PlanningHandle() {
+    cancel();
+    wait();
+}
+
+bool PlanningHandle::isDone() {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    return !mRunning;
+}
+
+void PlanningHandle::cancel() {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    // The request is reset by run(), so it must not be set after the planning has finished.
+    if(mRunning) {
+        mpMpl->cancelPlanning();
+    }
+}
+
+PlanningProgress PlanningHandle::getProgress() {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    PlanningProgress progress = mProgress;
+    progress.mRunning = mRunning;
+    if(mRunning) {
+        progress.mElapsedTime = (base::Time::now() - mStartTime).toSeconds();
+    }
+    return progress;
+}
+
+bool PlanningHandle::getLatestSolution(std::vector<struct State>& path_in_world, double& cost) {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    if(mLatestPath.empty()) {
+        return false;
+    }
+    path_in_world = mLatestPath;
+    cost = mProgress.mCost;
+    return true;
+}
+
+bool PlanningHandle::tryGetResult(bool& solved, double& cost, enum MplErrors& error) {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    if(mRunning) {
+        return false;
+    }
+    solved = mSolved;
+    cost = mCost;
+    error = mError;
+    return true;
+}
+
+void PlanningHandle::wait() {
+    if(mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+// PRIVATE
+PlanningHandle::PlanningHandle(MotionPlanningLibraries* mpl, double max_time) : 
+        mpMpl(mpl),
+        mMaxTime(max_time),
+        mStartTime(),
+        mMutex(),
+        mRunning(false),
+        mSolved(false),
+        mCost(nan("")),
+        mError(MPL_ERR_NONE),
+        mProgress(),
+        mLatestPath(),
+        mThread() {
+}
+
+void PlanningHandle::start() {
+    mpMpl->resetCancelPlanning();
+    mRunning = true;
+    mStartTime = base::Time::now();
+    mThread = boost::thread(boost::bind(&PlanningHandle::run, this));
+}
+
+void PlanningHandle::run() {
+    bool solved = false;
+    double cost = nan("");
+    enum MplErrors error = MPL_ERR_UNDEFINED;
+    mpMpl->setProgressCallback(boost::bind(&PlanningHandle::progressCallback, this));
+    try {
+        solved = mpMpl->plan(mMaxTime, cost, 
+                boost::bind(&PlanningHandle::solutionCallback, this, _1, _2));
+        error = mpMpl->getError();
+    } catch (std::exception& e) {
+        LOG_ERROR("Asynchronous planning failed: %s", e.what());
+    }
+    mpMpl->setProgressCallback(ProgressCallback());
+    
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    mSolved = solved;
+    mCost = cost;
+    mError = error;
+    if(solved) {
+        mpMpl->getStatesInWorld(mLatestPath);
+        mProgress.mCost = cost;
+    }
+    mProgress.mNumExpansions = mpMpl->getNumExpansions();
+    mProgress.mEpsilon = mpMpl->getEpsilon();
+    mProgress.mElapsedTime = (base::Time::now() - mStartTime).toSeconds();
+    mpMpl->resetCancelPlanning();
+    mRunning = false;
+}
+
+void PlanningHandle::solutionCallback(const std::vector<struct State>& path_in_world, 
+        double cost) {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    mLatestPath = path_in_world;
+    mProgress.mCost = cost;
+    mProgress.mNumSolutions++;
+    mProgress.mNumExpansions = mpMpl->getNumExpansions();
+    mProgress.mEpsilon = mpMpl->getEpsilon();
+    mProgress.mElapsedTime = (base::Time::now() - mStartTime).toSeconds();
+}
+
+void PlanningHandle::progressCallback() {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    mProgress.mNumExpansions = mpMpl->getNumExpansions();
+    mProgress.mElapsedTime = (base::Time::now() - mStartTime).toSeconds();
+}
+
+} // namespace motion_planning_libraries
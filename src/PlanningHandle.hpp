@@ -0,0 +1,131 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_PLANNING_HANDLE_HPP_
+#define _MOTION_PLANNING_LIBRARIES_PLANNING_HANDLE_HPP_
+
+#include <cmath>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include <base/Time.hpp>
+
+#include "Config.hpp"
+#include "State.hpp"
+
+namespace motion_planning_libraries
+{
+
+class MotionPlanningLibraries;
+
+/**
+ * Snapshot of a running or finished asynchronous planning.
+ * Values which are not supported by the planning library are
+ * -1 (expansions) or nan (epsilon, cost). SBPL updates the expansions after
+ * each time slice (Sbpl::SBPL_TIME_SLICE). OMPL provides no expansions, 
+ * its progress consists of the elapsed time and the improved solutions.
+ */
+struct PlanningProgress {
+    bool mRunning;
+    // Seconds since the planning has been started.
+    double mElapsedTime;
+    // Expansions up to the last finished part of the search.
+    int mNumExpansions;
+    // Suboptimality bound of the last improved solution (SBPL).
+    double mEpsilon;
+    // Cost of the last improved solution.
+    double mCost;
+    unsigned int mNumSolutions;
+
+    PlanningProgress() : mRunning(false),
+            mElapsedTime(0.0),
+            mNumExpansions(-1),
+            mEpsilon(nan("")),
+            mCost(nan("")),
+            mNumSolutions(0) {
+    }
+};
+
+/**
+ * Returned by MotionPlanningLibraries::planAsync(), runs
+ * MotionPlanningLibraries::plan() within its own thread.
+ * All methods return immediately (apart from wait()) and can be
+ * called periodically by a real-time loop. While the planning is running
+ * the MotionPlanningLibraries object must not be used, apart from
+ * the methods which are marked as thread-safe.
+ * The destructor cancels the planning and waits for the thread.
+ */
+class PlanningHandle : private boost::noncopyable
+{
+    friend class MotionPlanningLibraries;
+
+ public:
+    ~PlanningHandle();
+
+    bool isDone();
+
+    /**
+     * Stops the planning as soon as possible, the best solution found
+     * so far is kept. OMPL stops within its next iteration, SBPL after
+     * the current time slice (Sbpl::SBPL_TIME_SLICE).
+     */
+    void cancel();
+
+    PlanningProgress getProgress();
+
+    /**
+     * Copies the last improved solution (world frame), which can be
+     * used while the planning continues.
+     * \return false if no solution has been reported yet.
+     */
+    bool getLatestSolution(std::vector<struct State>& path_in_world, double& cost);
+
+    /**
+     * Non-blocking result retrieval.
+     * \param solved Return value of MotionPlanningLibraries::plan().
+     * \param error Error state of the planning.
+     * \return false if the planning is still running.
+     */
+    bool tryGetResult(bool& solved, double& cost, enum MplErrors& error);
+
+    /**
+     * Blocks until the planning thread has finished.
+     */
+    void wait();
+
+ private:
+    MotionPlanningLibraries* mpMpl;
+    double mMaxTime;
+    base::Time mStartTime;
+
+    boost::mutex mMutex;
+    bool mRunning;
+    bool mSolved;
+    double mCost;
+    enum MplErrors mError;
+    PlanningProgress mProgress;
+    std::vector<struct State> mLatestPath;
+    boost::thread mThread;
+
+    /**
+     * Only created by MotionPlanningLibraries::planAsync().
+     */
+    PlanningHandle(MotionPlanningLibraries* mpl, double max_time);
+
+    void start();
+
+    void run();
+
+    /**
+     * Called within the planning thread for each improved solution.
+     */
+    void solutionCallback(const std::vector<struct State>& path_in_world, double cost);
+    
+    /**
+     * Called within the planning thread after each part of the search.
+     */
+    void progressCallback();
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_PLANNING_HANDLE_HPP_
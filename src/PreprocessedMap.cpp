@@ -0,0 +1,144 @@
+#include "PreprocessedMap.hpp"
+
+#include <sstream>
+
+#include <boost/functional/hash.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <base-logging/Logging.hpp>
+
+#include "Helpers.hpp"
+
+namespace motion_planning_libraries
+{
+
+// PUBLIC
+boost::shared_ptr<const PreprocessedMap> PreprocessedMap::create(
+        envire::TraversabilityGrid* trav_grid) {
+    return boost::shared_ptr<const PreprocessedMap>(new PreprocessedMap(trav_grid));
+}
+
+boost::shared_ptr<const std::vector<unsigned char> > PreprocessedMap::getCostMap(
+        unsigned char max_cost) const {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    if(mCostMaps.empty()) {
+        mCostMaps.resize(256);
+    }
+    if(!mCostMaps[max_cost]) {
+        unsigned char costs[256];
+        for(unsigned int i=0; i<256; ++i) {
+            costs[i] = driveability2cost(mDriveabilities[i], max_cost);
+        }
+        boost::shared_ptr<std::vector<unsigned char> > cost_map(
+                new std::vector<unsigned char>(mpTravData->num_elements()));
+        const uint8_t* cells = mpTravData->data();
+        for(size_t i=0; i<cost_map->size(); ++i) {
+            (*cost_map)[i] = costs[cells[i]];
+        }
+        mCostMaps[max_cost] = cost_map;
+    }
+    return mCostMaps[max_cost];
+}
+
+boost::shared_ptr<const std::vector<float> > PreprocessedMap::getObstacleDistances() const {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    if(!mpObstacleDistances) {
+        mpObstacleDistances.reset(new std::vector<float>(
+                GridCalculations::createObstacleDistances(mCellSizeX, mCellSizeY, 
+                mpTravData, mDriveabilities)));
+    }
+    return mpObstacleDistances;
+}
+
+std::string PreprocessedMap::getMapId() const {
+    boost::lock_guard<boost::mutex> lock(mMutex);
+    if(mMapId.empty()) {
+        mMapId = createMapId(mCellSizeX, mCellSizeY, mScaleX, mScaleY, 
+                mOffsetX, mOffsetY, mpTravData, mDriveabilities);
+    }
+    return mMapId;
+}
+
+std::string PreprocessedMap::createMapId(envire::TraversabilityGrid* trav_grid,
+        boost::shared_ptr<TravData> grid_data) {
+    std::vector<bool> used_classes(256, false);
+    const uint8_t* cells = grid_data->data();
+    for(size_t i=0; i<grid_data->num_elements(); ++i) {
+        used_classes[cells[i]] = true;
+    }
+    std::vector<double> driveabilities(256, 0.0);
+    for(unsigned int i=0; i<used_classes.size(); ++i) {
+        if(used_classes[i]) {
+            driveabilities[i] = trav_grid->getTraversabilityClass(i).getDrivability();
+        }
+    }
+    return createMapId(trav_grid->getCellSizeX(), trav_grid->getCellSizeY(),
+            trav_grid->getScaleX(), trav_grid->getScaleY(), 
+            trav_grid->getOffsetX(), trav_grid->getOffsetY(), 
+            grid_data, driveabilities);
+}
+
+// PRIVATE
+PreprocessedMap::PreprocessedMap(envire::TraversabilityGrid* trav_grid) :
+        mpTravGrid(trav_grid),
+        mCellSizeX(trav_grid->getCellSizeX()),
+        mCellSizeY(trav_grid->getCellSizeY()),
+        mScaleX(trav_grid->getScaleX()),
+        mScaleY(trav_grid->getScaleY()),
+        mOffsetX(trav_grid->getOffsetX()),
+        mOffsetY(trav_grid->getOffsetY()),
+        mpTravData(new TravData(trav_grid->getGridData(envire::TraversabilityGrid::TRAVERSABILITY))),
+        mpProbabilityData(new TravData(trav_grid->getGridData(envire::TraversabilityGrid::PROBABILITY))),
+        mDriveabilities(256, 0.0),
+        mWorld2Local(trav_grid->getEnvironment()->relativeTransform(
+                trav_grid->getEnvironment()->getRootNode(), trav_grid->getFrameNode())),
+        mLocal2World(trav_grid->getEnvironment()->relativeTransform(
+                trav_grid->getFrameNode(), trav_grid->getEnvironment()->getRootNode())),
+        mMutex(),
+        mCostMaps(),
+        mpObstacleDistances(),
+        mMapId() {
+
+    // Only the classes which are used by the cells, the others are treated as obstacles.
+    std::vector<bool> used_classes(256, false);
+    const uint8_t* cells = mpTravData->data();
+    for(size_t i=0; i<mpTravData->num_elements(); ++i) {
+        used_classes[cells[i]] = true;
+    }
+    for(unsigned int i=0; i<used_classes.size(); ++i) {
+        if(used_classes[i]) {
+            mDriveabilities[i] = trav_grid->getTraversabilityClass(i).getDrivability();
+        }
+    }
+    LOG_INFO("Preprocessed map with %d x %d cells has been created",
+            (int)mCellSizeX, (int)mCellSizeY);
+}
+
+std::string PreprocessedMap::createMapId(size_t cell_size_x, size_t cell_size_y,
+        double scale_x, double scale_y, double offset_x, double offset_y,
+        boost::shared_ptr<TravData> grid_data, std::vector<double> const& driveabilities) {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, scale_x);
+    boost::hash_combine(seed, scale_y);
+    boost::hash_combine(seed, offset_x);
+    boost::hash_combine(seed, offset_y);
+
+    // The cell classes and the driveability of the used classes.
+    std::vector<bool> used_classes(256, false);
+    const uint8_t* cells = grid_data->data();
+    for(size_t i=0; i<grid_data->num_elements(); ++i) {
+        boost::hash_combine(seed, cells[i]);
+        used_classes[cells[i]] = true;
+    }
+    for(unsigned int i=0; i<used_classes.size(); ++i) {
+        if(used_classes[i]) {
+            boost::hash_combine(seed, driveabilities[i]);
+        }
+    }
+
+    std::stringstream ss;
+    ss << cell_size_x << "x" << cell_size_y << "_" << std::hex << seed;
+    return ss.str();
+}
+
+} // namespace motion_planning_libraries
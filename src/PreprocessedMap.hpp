@@ -0,0 +1,180 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_PREPROCESSED_MAP_HPP_
+#define _MOTION_PLANNING_LIBRARIES_PREPROCESSED_MAP_HPP_
+
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <Eigen/Geometry>
+
+#include <envire/maps/TraversabilityGrid.hpp>
+
+namespace motion_planning_libraries
+{
+
+typedef envire::TraversabilityGrid::ArrayType TravData;
+
+/**
+ * Immutable snapshot of a traversability map and the data derived from it,
+ * shared by all planners which plan on the same map, e.g. several robots with
+ * different footprints and mobility (MotionPlanningLibraries::setPreprocessedMap()).
+ * So the preprocessing time scales with the number of maps instead of maps times 
+ * robots. The memory of the snapshot and its derived data is shared as well, but 
+ * the SBPL environments copy the cost map into their own grid on initialization 
+ * (see Sbpl::createSBPLMap()). The derived data is independent of the robot config and is
+ * created on first request, later requests of any planner return the same object.
+ * All methods are thread-safe.
+ */
+class PreprocessedMap : private boost::noncopyable
+{
+ public:
+    /**
+     * Copies the traversability and probability layer and the geometry of the grid.
+     * The grid itself is only kept for the world/grid transformations of the
+     * planner which uses it as its current map, the snapshot and its derived data 
+     * never access it. So an old map can be compared with a new one after
+     * its grid has been removed.
+     */
+    static boost::shared_ptr<const PreprocessedMap> create(envire::TraversabilityGrid* trav_grid);
+
+    inline envire::TraversabilityGrid* getTravGrid() const {
+        return mpTravGrid;
+    }
+    
+    /**
+     * Geometry of the grid at the time of the snapshot.
+     */
+    inline size_t getCellSizeX() const {
+        return mCellSizeX;
+    }
+    
+    inline size_t getCellSizeY() const {
+        return mCellSizeY;
+    }
+    
+    inline double getScaleX() const {
+        return mScaleX;
+    }
+    
+    inline double getScaleY() const {
+        return mScaleY;
+    }
+    
+    inline double getOffsetX() const {
+        return mOffsetX;
+    }
+    
+    inline double getOffsetY() const {
+        return mOffsetY;
+    }
+    
+    /**
+     * True if both maps use the same number of cells, cell size and offset.
+     */
+    inline bool hasSameGeometry(PreprocessedMap const& other) const {
+        return mCellSizeX == other.mCellSizeX && mCellSizeY == other.mCellSizeY &&
+                mScaleX == other.mScaleX && mScaleY == other.mScaleY &&
+                mOffsetX == other.mOffsetX && mOffsetY == other.mOffsetY;
+    }
+
+    /**
+     * Transformation from the world (root node of the environment) to the grid
+     * local frame at the time of the snapshot. Walking the envire frame tree is
+     * done once per map, a moved map frame requires a new map.
+     */
+    inline const Eigen::Affine3d& getWorld2Local() const {
+        return mWorld2Local;
+    }
+
+    inline const Eigen::Affine3d& getLocal2World() const {
+        return mLocal2World;
+    }
+
+    /**
+     * Traversability classes of the cells, must not be changed.
+     */
+    inline boost::shared_ptr<TravData> getTravData() const {
+        return mpTravData;
+    }
+
+    /**
+     * Probability of the cells, must not be changed.
+     */
+    inline boost::shared_ptr<TravData> getProbabilityData() const {
+        return mpProbabilityData;
+    }
+
+    /**
+     * Driveability of the traversability class at the time of the snapshot,
+     * 0 for classes which are not used by the map.
+     */
+    inline double getDriveability(uint8_t klass) const {
+        return mDriveabilities[klass];
+    }
+
+    /**
+     * Cost of each cell (row by row) with driveability 0.0 to 1.0 mapped to
+     * max_cost + 1 to 1, see driveability2cost().
+     */
+    boost::shared_ptr<const std::vector<unsigned char> > getCostMap(unsigned char max_cost) const;
+
+    /**
+     * Distance field, see GridCalculations::createObstacleDistances().
+     */
+    boost::shared_ptr<const std::vector<float> > getObstacleDistances() const;
+
+    /**
+     * Id which describes the size, resolution and content of the map, see createMapId().
+     */
+    std::string getMapId() const;
+
+    static inline unsigned char driveability2cost(double driveability, unsigned char max_cost) {
+        return max_cost - (int)(driveability * (double)max_cost) + 1.0;
+    }
+
+    /**
+     * Creates an id which describes the size, resolution and content of the map.
+     */
+    static std::string createMapId(envire::TraversabilityGrid* trav_grid,
+            boost::shared_ptr<TravData> grid_data);
+
+ private:
+    envire::TraversabilityGrid* mpTravGrid;
+    size_t mCellSizeX;
+    size_t mCellSizeY;
+    double mScaleX;
+    double mScaleY;
+    double mOffsetX;
+    double mOffsetY;
+    boost::shared_ptr<TravData> mpTravData;
+    boost::shared_ptr<TravData> mpProbabilityData;
+    std::vector<double> mDriveabilities;
+    Eigen::Affine3d mWorld2Local;
+    Eigen::Affine3d mLocal2World;
+
+    // Derived data, created on first request.
+    mutable boost::mutex mMutex;
+    mutable std::vector< boost::shared_ptr<const std::vector<unsigned char> > > mCostMaps;
+    mutable boost::shared_ptr<const std::vector<float> > mpObstacleDistances;
+    mutable std::string mMapId;
+
+    PreprocessedMap(envire::TraversabilityGrid* trav_grid);
+    
+    /**
+     * See createMapId(), \a driveabilities has to contain the driveability 
+     * of each class used by \a grid_data.
+     */
+    static std::string createMapId(size_t cell_size_x, size_t cell_size_y,
+            double scale_x, double scale_y, double offset_x, double offset_y,
+            boost::shared_ptr<TravData> grid_data, std::vector<double> const& driveabilities);
+
+ public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_PREPROCESSED_MAP_HPP_
@@ -84,28 +84,28 @@ struct State {
         mMovType = MOV_UNDEFINED;
     }
     
-    enum StateType getStateType() {
+    enum StateType getStateType() const {
         return mStateType;
     }
     
-    base::samples::RigidBodyState getPose() {
+    base::samples::RigidBodyState getPose() const {
         return mPose;
     }
     
-    std::vector<double> getJointAngles() {
+    std::vector<double> getJointAngles() const {
         return mJointAngles;
     }
     
-    int getNumJoints() {
+    int getNumJoints() const {
         return mJointAngles.size();
     }
     
-    double getFootprintRadius() {
+    double getFootprintRadius() const {
         return mFootprintRadius;
     }
     
     unsigned int getFootprintClass(double fp_radius_min, double fp_radius_max, 
-            unsigned int num_fp_classes) {
+            unsigned int num_fp_classes) const {
         assert (fp_radius_min <= fp_radius_max);
         assert (num_fp_classes > 0);
         if(mFootprintRadius < fp_radius_min || mFootprintRadius > fp_radius_max) {
@@ -142,7 +142,7 @@ struct State {
                 fp_class / (num_fp_classes - 1);
     }
     
-    bool hasValidPosition() {
+    bool hasValidPosition() const {
         return mPose.hasValidPosition();
     }
 
@@ -150,7 +150,7 @@ struct State {
      * Returns the abs-distance between both states.
      * If the states are not pose-states a negative number will be returned.
      */
-    double dist(State state) {
+    double dist(State const& state) const {
         
         if(!this->mPose.hasValidPosition() || !state.mPose.hasValidPosition()) {
             LOG_WARN("Distance cannot be calculated, position(s) are not valid");
@@ -187,29 +187,30 @@ struct State {
         return ss.str();
     }
     
-    bool differs(State state) {
+    bool differs(State const& state) const {
         if(this->mStateType != state.mStateType) {
             return true;
         }
         
+        // Uses the members directly, the getters return copies.
         switch(state.mStateType) {
             case STATE_EMPTY: 
                 return false;
             case STATE_POSE: {
-                double dist = (this->getPose().position - state.getPose().position).norm();
-                double turn = fabs(this->getPose().getYaw() - state.getPose().getYaw());
+                double dist = (this->mPose.position - state.mPose.position).norm();
+                double turn = fabs(this->mPose.getYaw() - state.mPose.getYaw());
                 if (dist > REPLANNING_DIST_THRESHOLD || turn > REPLANNING_TURN_THRESHOLD) {
                     return true;
                 }
                 break;
             }
             case STATE_ARM: {
-                std::vector<double>::iterator it = this->getJointAngles().begin();
-                std::vector<double>::iterator it_new = state.getJointAngles().begin();
-                if(this->getJointAngles().size() != state.getJointAngles().size()) {
+                if(this->mJointAngles.size() != state.mJointAngles.size()) {
                     return true;
                 }
-                for(; it != this->getJointAngles().end(); it++, it_new++) {
+                std::vector<double>::const_iterator it = this->mJointAngles.begin();
+                std::vector<double>::const_iterator it_new = state.mJointAngles.begin();
+                for(; it != this->mJointAngles.end(); it++, it_new++) {
                     if(fabs(*it - *it_new) > REPLANNING_JOINT_ANGLE_THRESHOLD) {
                        return true;
                     }
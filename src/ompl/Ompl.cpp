@@ -1,38 +1,624 @@
 #include "Ompl.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <boost/bind.hpp>
+
+#include <ompl/config.h>
+#include <ompl/base/goals/GoalState.h>
+#include <ompl/base/PlannerData.h>
+#include <ompl/base/PlannerDataStorage.h>
+#include <ompl/base/PlannerTerminationCondition.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/base/spaces/SE2StateSpace.h>
+#include <ompl/control/PathControl.h>
 #include <ompl/geometric/PathGeometric.h>
+#include <ompl/geometric/PathSimplifier.h>
+#include <ompl/tools/multiplan/ParallelPlan.h>
+#include <ompl/geometric/planners/rrt/RRTConnect.h>
+#include <ompl/geometric/planners/rrt/RRTstar.h>
+#include <ompl/geometric/planners/prm/PRM.h>
+#include <ompl/geometric/planners/prm/PRMstar.h>
+#include <ompl/geometric/planners/kpiece/KPIECE1.h>
+#if OMPL_VERSION_VALUE >= 1001000
+#include <ompl/geometric/planners/rrt/InformedRRTstar.h>
+#include <ompl/geometric/planners/bitstar/BITstar.h>
+#include <ompl/geometric/planners/prm/LazyPRM.h>
+#include <ompl/geometric/planners/prm/LazyPRMstar.h>
+#endif
+#if OMPL_VERSION_VALUE >= 1002000
+#include <ompl/geometric/planners/rrt/RRTsharp.h>
+#endif
+
+#include <motion_planning_libraries/Parallel.hpp>
+#include <motion_planning_libraries/ompl/datastructures/GridNearestNeighbors.hpp>
+#include <motion_planning_libraries/ompl/planners/WarmStartRRTstar.hpp>
+#include <motion_planning_libraries/ompl/samplers/FreeCellStateSampler.hpp>
+#include <motion_planning_libraries/ompl/spaces/SherpaStateSpace.hpp>
+#include <motion_planning_libraries/ompl/spaces/StatePool.hpp>
+
+namespace og = ompl::geometric;
 
 namespace motion_planning_libraries
 {    
     
+const double Ompl::STAGNATION_MIN_IMPROVEMENT = 0.01;
+const unsigned int Ompl::MIN_STATES_PER_SEGMENT;
+    
 // PUBLIC
-Ompl::Ompl(Config config) : AbstractMotionPlanningLibrary(config) {
+Ompl::Ompl(Config const& config) : AbstractMotionPlanningLibrary(config),
+        mpParallelPlan(),
+        mParallelPlanners(),
+        mSolutionMutex(),
+        mBestReportedCost(std::numeric_limits<double>::infinity()),
+        mLastImprovementTime(),
+        mMapId(),
+        mRoadmapMapId() {
 }
 
 bool Ompl::solve(double time) {
-    ompl::base::PlannerStatus solved = mpPlanner->solve(time);
+    
+    // Reports each improved solution of the optimizing planners (e.g. RRT*).
+    // Also required to detect a stagnating optimization.
+    if(mImprovedSolutionCallback || mConfig.mOmplStagnationTime > 0) {
+        mpProblemDefinition->setIntermediateSolutionCallback(
+                boost::bind(&Ompl::intermediateSolutionCallback, this, _1, _2, _3));
+    } else {
+        mpProblemDefinition->setIntermediateSolutionCallback(
+                ompl::base::ReportIntermediateSolutionFn());
+    }
+    
+    // Stop as soon as the solution is close to the lower bound.
+    if(mConfig.mOmplCostTolerance > 0 && mpProblemDefinition->hasOptimizationObjective()) {
+        double lower_bound = getCostLowerBound();
+        if(lower_bound > 0) {
+            double threshold = lower_bound * (1.0 + mConfig.mOmplCostTolerance);
+            mpProblemDefinition->getOptimizationObjective()->setCostThreshold(
+                    ompl::base::Cost(threshold));
+            LOG_INFO("Cost lower bound %4.2f, stop below %4.2f", lower_bound, threshold);
+        }
+    }
+    
+    mBestReportedCost = std::numeric_limits<double>::infinity();
+    mLastImprovementTime = base::Time();
+    
+    ompl::base::PlannerTerminationCondition ptc = ompl::base::timedPlannerTerminationCondition(time);
+    if(mConfig.mOmplStagnationTime > 0) {
+        // Evaluated within its own thread every 10 ms.
+        ptc = ompl::base::plannerOrTerminationCondition(ptc, 
+                ompl::base::PlannerTerminationCondition(boost::bind(&Ompl::isStagnating, this), 0.01));
+    }
+    // Allows to stop an asynchronous planning (see MotionPlanningLibraries::planAsync()).
+    ptc = ompl::base::plannerOrTerminationCondition(ptc, 
+            ompl::base::PlannerTerminationCondition(
+            boost::bind(&AbstractMotionPlanningLibrary::isCancelRequested, this)));
+    
+    ompl::base::PlannerStatus solved;
+    if(mpParallelPlan) {
+        // Combines the found solutions (path hybridization) if possible.
+        solved = mpParallelPlan->solve(ptc, true);
+    } else {
+        solved = mpPlanner->solve(ptc);
+    }
 
     if (solved)
     {
         mpPathInGridOmpl = mpProblemDefinition->getSolutionPath();
+        if(mConfig.mOmplSimplificationTime > 0) {
+            simplifyPath(mConfig.mOmplSimplificationTime);
+        }
+        if(mpProblemDefinition->hasOptimizationObjective()) {
+            mPathCost = getCostValue(mpPathInGridOmpl->cost(
+                    mpProblemDefinition->getOptimizationObjective()));
+        }
         return true;
     } else {
         return false;
     }
 }
 
-std::vector<ompl::base::State*> Ompl::getPathStates()
-{
+bool Ompl::saveRoadmap(std::string filename) {
+    if(!mConfig.mOmplMultiQuery || !mpPlanner || filename.empty()) {
+        LOG_WARN("Roadmap can only be stored in multi-query mode to a valid file");
+        return false;
+    }
+    
+    ompl::base::PlannerData data(mpSpaceInformation);
+    mpPlanner->getPlannerData(data);
+    ompl::base::PlannerDataStorage storage;
+    if(!storage.store(data, filename.c_str())) {
+        LOG_WARN("Roadmap could not be stored to %s", filename.c_str());
+        return false;
+    }
+    
+    std::ofstream map_id_file((filename + ".mapid").c_str());
+    map_id_file << mRoadmapMapId << std::endl;
+    if(!map_id_file) {
+        LOG_WARN("Map id could not be stored to %s.mapid", filename.c_str());
+        return false;
+    }
+    LOG_INFO("Roadmap with %d vertices has been stored to %s", data.numVertices(), filename.c_str());
+    return true;
+}
+
+unsigned int Ompl::getNumRoadmapVertices() {
+    if(!mConfig.mOmplMultiQuery || !mpPlanner) {
+        return 0;
+    }
+    ompl::base::PlannerData data(mpSpaceInformation);
+    mpPlanner->getPlannerData(data);
+    return data.numVertices();
+}
+
+// PROTECTED
+ompl::base::PlannerPtr Ompl::createPlanner() {
+    return ompl::base::PlannerPtr();
+}
+
+ompl::base::PlannerPtr Ompl::createGeometricPlanner(const ompl::base::SpaceInformationPtr& si) {
+    ompl::base::PlannerPtr planner;
+    
+    if(mConfig.mOmplMultiQuery) {
+        planner = createRoadmapPlanner(si);
+        mRoadmapMapId = mMapId;
+        if(planner) {
+            setPlannerParams(planner);
+            return planner;
+        }
+    }
+    
+    switch(mConfig.mPlanner) {
+        case UNDEFINED_PLANNER: {
+            if(mConfig.mOmplMultiQuery) { // Keeps its roadmap between the queries.
+                planner = ompl::base::PlannerPtr(new og::PRMstar(si));
+            } else if(mConfig.mSearchUntilFirstSolution) { // Not optimizing planner, 
+                planner = ompl::base::PlannerPtr(new og::RRTConnect(si));
+            } else { // Optimizing planners use all the available time to improve the solution.
+                planner = createRRTstar(si);
+            }
+            break;
+        }
+        case RRT_CONNECT: {
+            planner = ompl::base::PlannerPtr(new og::RRTConnect(si));
+            break;
+        }
+        case RRT_STAR: {
+            planner = createRRTstar(si);
+            break;
+        }
+        case PRM_STAR: {
+            planner = ompl::base::PlannerPtr(new og::PRMstar(si));
+            break;
+        }
+        case KPIECE: {
+            // Requires a default projection of the state space.
+            planner = ompl::base::PlannerPtr(new og::KPIECE1(si));
+            break;
+        }
+#if OMPL_VERSION_VALUE >= 1001000
+        case INFORMED_RRT_STAR: {
+            planner = ompl::base::PlannerPtr(new og::InformedRRTstar(si));
+            break;
+        }
+        case BIT_STAR: {
+            planner = ompl::base::PlannerPtr(new og::BITstar(si));
+            break;
+        }
+        case LAZY_PRM_STAR: {
+            planner = ompl::base::PlannerPtr(new og::LazyPRMstar(si));
+            break;
+        }
+#endif
+#if OMPL_VERSION_VALUE >= 1002000
+        case RRT_SHARP: {
+            planner = ompl::base::PlannerPtr(new og::RRTsharp(si));
+            break;
+        }
+#endif
+        default: {
+            LOG_ERROR("Planner %d is not available for this environment or OMPL version", 
+                    (int)mConfig.mPlanner);
+            return planner;
+        }
+    }
+    
+    setPlannerParams(planner);
+    setGridNearestNeighbors(planner);
+    return planner;
+}
+
+void Ompl::setPlannerParams(const ompl::base::PlannerPtr& planner) {
+    ompl::base::ParamSet& param_set = planner->params();
+    
+    if(mConfig.mMaxAllowedSampleDist > 0 && !std::isnan(mConfig.mMaxAllowedSampleDist) && 
+            param_set.hasParam("range")) {
+        std::stringstream ss;
+        ss << mConfig.mMaxAllowedSampleDist;
+        param_set.setParam("range", ss.str());
+    }
+    
+    if(mConfig.mOmplGoalBias >= 0 && param_set.hasParam("goal_bias")) {
+        std::stringstream ss;
+        ss << std::min(mConfig.mOmplGoalBias, 1.0);
+        param_set.setParam("goal_bias", ss.str());
+    }
+}
+
+void Ompl::setGridNearestNeighbors(const ompl::base::PlannerPtr& planner) {
+    if(!mConfig.mOmplGridNearestNeighbors) {
+        return;
+    }
+    
+    // The distances of these spaces are never smaller than the euclidean position distance.
+    ompl::base::StateSpace* space = planner->getSpaceInformation()->getStateSpace().get();
+    bool xy_space = dynamic_cast<ompl::base::RealVectorStateSpace*>(space) != NULL && 
+            space->getDimension() == 2;
+    bool compound_xy_space = dynamic_cast<SherpaStateSpace*>(space) != NULL ||
+            dynamic_cast<ompl::base::SE2StateSpace*>(space) != NULL;
+    if(!xy_space && !compound_xy_space) {
+        return;
+    }
+    
+    // Includes the subclasses InformedRRTstar and WarmStartRRTstar.
+    og::RRTstar* rrt_star = dynamic_cast<og::RRTstar*>(planner.get());
+    og::RRTConnect* rrt_connect = dynamic_cast<og::RRTConnect*>(planner.get());
+    if(rrt_star != NULL) {
+        if(xy_space) {
+            rrt_star->setNearestNeighbors<XYGridNearestNeighbors>();
+        } else {
+            rrt_star->setNearestNeighbors<CompoundXYGridNearestNeighbors>();
+        }
+    } else if(rrt_connect != NULL) {
+        if(xy_space) {
+            rrt_connect->setNearestNeighbors<XYGridNearestNeighbors>();
+        } else {
+            rrt_connect->setNearestNeighbors<CompoundXYGridNearestNeighbors>();
+        }
+    }
+}
+
+ompl::base::PlannerPtr Ompl::createRRTstar(const ompl::base::SpaceInformationPtr& si) {
+    if(mConfig.mOmplWarmStart) {
+#if OMPL_VERSION_VALUE >= 1001000
+        return ompl::base::PlannerPtr(new WarmStartRRTstar(si));
+#else
+        LOG_WARN("Warm start requires OMPL >= 1.1, RRT* is used");
+#endif
+    }
+    return ompl::base::PlannerPtr(new og::RRTstar(si));
+}
+
+void Ompl::warmStartPlanners() {
+#if OMPL_VERSION_VALUE >= 1001000
+    if(!mConfig.mOmplWarmStart || !mpPlanner || !mpPathInGridOmpl) {
+        return;
+    }
+    
+    // Only geometric paths can seed the tree of the geometric RRT*.
+    if(dynamic_cast<og::PathGeometric*>(mpPathInGridOmpl.get()) == NULL) {
+        return;
+    }
+    std::vector<ompl::base::State*> seed_states = getPathStates();
+    std::vector<ompl::base::PlannerPtr> planners(mParallelPlanners);
+    planners.push_back(mpPlanner);
+    for(unsigned int i=0; i<planners.size(); ++i) {
+        WarmStartRRTstar* planner = dynamic_cast<WarmStartRRTstar*>(planners[i].get());
+        if(planner != NULL) {
+            // The old trees are rooted at the last start.
+            planner->clear();
+            planner->setSeedPath(seed_states);
+        }
+    }
+    if(mpParallelPlan) {
+        mpParallelPlan->clearHybridizationPaths();
+    }
+    mpProblemDefinition->clearSolutionPaths();
+#endif
+}
+
+void Ompl::releaseUnusedStates() {
+    PooledStates* pooled_states = dynamic_cast<PooledStates*>(mpStateSpace.get());
+    if(pooled_states == NULL) {
+        return;
+    }
+    size_t num_released = pooled_states->getStatePool().releaseUnusedArenas();
+    LOG_DEBUG("Released %d state arenas, %d arenas with %d states remain", (int)num_released, 
+            (int)pooled_states->getStatePool().getNumArenas(), 
+            (int)pooled_states->getStatePool().getNumAllocatedBlocks());
+}
+
+ompl::base::PlannerPtr Ompl::createRoadmapPlanner(const ompl::base::SpaceInformationPtr& si) {
 #if OMPL_VERSION_VALUE < 1001000
-    // Downcast from Path to PathGeometric is valid.
-    return boost::static_pointer_cast<ompl::geometric::PathGeometric>(mpPathInGridOmpl)->getStates();
+    // The planners cannot be created from planner data.
+    LOG_WARN("Reusing a roadmap requires OMPL 1.1.0 or newer");
+    return ompl::base::PlannerPtr();
 #else
-    std::shared_ptr<ompl::geometric::PathGeometric> pathGeometric = std::static_pointer_cast<ompl::geometric::PathGeometric>(mpPathInGridOmpl);
-    if(!pathGeometric)
-    {
-        throw std::runtime_error("motion_planning_libraries::OmplEnvXYTHETA::fillPath: could not cast path to geometric path");
+    if(mMapId.empty() || (mConfig.mPlanner != UNDEFINED_PLANNER && 
+            mConfig.mPlanner != PRM_STAR && mConfig.mPlanner != LAZY_PRM_STAR)) {
+        return ompl::base::PlannerPtr();
+    }
+    
+    ompl::base::PlannerData data(si);
+    if(mpPlanner && mRoadmapMapId == mMapId) {
+        // The environment has been recreated for the same map, continue the current roadmap.
+        mpPlanner->getPlannerData(data);
+    } else if(!mConfig.mOmplRoadmapFile.empty()) {
+        std::ifstream map_id_file((mConfig.mOmplRoadmapFile + ".mapid").c_str());
+        std::string file_map_id;
+        if(!(map_id_file >> file_map_id) || file_map_id != mMapId) {
+            LOG_INFO("Roadmap %s has not been created for the current map", 
+                    mConfig.mOmplRoadmapFile.c_str());
+            return ompl::base::PlannerPtr();
+        }
+        ompl::base::PlannerDataStorage storage;
+        if(!storage.load(mConfig.mOmplRoadmapFile.c_str(), data)) {
+            LOG_WARN("Roadmap %s could not be loaded", mConfig.mOmplRoadmapFile.c_str());
+            return ompl::base::PlannerPtr();
+        }
+    }
+    
+    if(data.numVertices() == 0) {
+        return ompl::base::PlannerPtr();
+    }
+    LOG_INFO("Reuse roadmap with %d vertices and %d edges", data.numVertices(), data.numEdges());
+    
+    // The planners copy the states of the planner data.
+    if(mConfig.mPlanner == LAZY_PRM_STAR) {
+        return ompl::base::PlannerPtr(new og::LazyPRM(data, true));
+    }
+    return ompl::base::PlannerPtr(new og::PRM(data, true));
+#endif
+}
+
+void Ompl::clearQuery() {
+    if(!mConfig.mOmplMultiQuery || !mpPlanner) {
+        return;
+    }
+    
+    og::PRM* prm = dynamic_cast<og::PRM*>(mpPlanner.get());
+    if(prm != NULL) {
+        prm->clearQuery();
+    }
+#if OMPL_VERSION_VALUE >= 1001000
+    og::LazyPRM* lazy_prm = dynamic_cast<og::LazyPRM*>(mpPlanner.get());
+    if(lazy_prm != NULL) {
+        lazy_prm->clearQuery();
     }
-    return pathGeometric->getStates();
 #endif
+    mpProblemDefinition->clearSolutionPaths();
+    
+    // The first solution found within the roadmap answers the query.
+    if(mConfig.mSearchUntilFirstSolution && mpProblemDefinition->hasOptimizationObjective()) {
+        mpProblemDefinition->getOptimizationObjective()->setCostThreshold(
+                ompl::base::Cost(std::numeric_limits<double>::infinity()));
+    }
+}
+
+std::string Ompl::getMapId(envire::TraversabilityGrid* trav_grid,
+        boost::shared_ptr<TravData> grid_data) {
+    boost::shared_ptr<const PreprocessedMap> preprocessed_map = getPreprocessedMap(grid_data);
+    if(preprocessed_map) {
+        return preprocessed_map->getMapId();
+    }
+    return PreprocessedMap::createMapId(trav_grid, grid_data);
+}
+
+void Ompl::setupFreeCellSampling(envire::TraversabilityGrid* trav_grid,
+        boost::shared_ptr<TravData> grid_data) {
+    if(!mConfig.mOmplFreeCellSampling) {
+        return;
+    }
+    
+    boost::shared_ptr<FreeCellTable> free_cells(new FreeCellTable());
+    if(!free_cells->create(mpSpaceInformation, trav_grid, grid_data, mConfig, 
+            getPreprocessedMap(grid_data))) {
+        LOG_WARN("The map does not contain any valid cell, free cell sampling is not used");
+        return;
+    }
+    mpStateSpace->setStateSamplerAllocator(boost::bind(&FreeCellStateSampler::alloc, _1, 
+            mConfig.mEnvType, boost::shared_ptr<const FreeCellTable>(free_cells)));
+}
+
+void Ompl::setupParallelPlanners() {
+    mpParallelPlan.reset();
+    mParallelPlanners.clear();
+    
+    if(mConfig.mOmplNumParallelPlanners <= 1) {
+        return;
+    }
+    
+    if(mConfig.mOmplMultiQuery) {
+        LOG_WARN("Parallel planners are not used in multi-query mode");
+        return;
+    }
+    
+    std::vector<ompl::base::PlannerPtr> planners;
+    for(unsigned int i=1; i<mConfig.mOmplNumParallelPlanners; ++i) {
+        ompl::base::PlannerPtr planner = createPlanner();
+        if(!planner) {
+            LOG_WARN("Parallel planning is not supported by this environment, one planner will be used");
+            return;
+        }
+        planner->setProblemDefinition(mpProblemDefinition);
+        planner->setup();
+        planners.push_back(planner);
+    }
+    
+    mpParallelPlan = boost::shared_ptr<ompl::tools::ParallelPlan>(
+            new ompl::tools::ParallelPlan(mpProblemDefinition));
+    mpParallelPlan->addPlanner(mpPlanner);
+    for(unsigned int i=0; i<planners.size(); ++i) {
+        mpParallelPlan->addPlanner(planners[i]);
+    }
+    mParallelPlanners = planners;
+    LOG_INFO("%d %s planners will run in parallel", mConfig.mOmplNumParallelPlanners, 
+            mpPlanner->getName().c_str());
+}
+
+std::vector<ompl::base::State*> Ompl::getPathStates()
+{
+    // ENV_XYTHETA with STEERING_CONTROL creates a control path.
+    og::PathGeometric* path_geometric = dynamic_cast<og::PathGeometric*>(mpPathInGridOmpl.get());
+    if(path_geometric != NULL) {
+        return path_geometric->getStates();
+    }
+    ompl::control::PathControl* path_control = 
+            dynamic_cast<ompl::control::PathControl*>(mpPathInGridOmpl.get());
+    if(path_control != NULL) {
+        return path_control->getStates();
+    }
+    LOG_WARN("Path does not contain any states or has an unknown type");
+    return std::vector<ompl::base::State*>();
+}
+
+void Ompl::simplifyPath(double time) {
+    og::PathGeometric* path = dynamic_cast<og::PathGeometric*>(mpPathInGridOmpl.get());
+    if(path == NULL || path->getStateCount() < 3) {
+        return;
+    }
+    
+    // Splits the path into segments, neighbouring segments share their end state.
+    ParallelFor parallel_for(mConfig.mNumThreads);
+    unsigned int num_states = path->getStateCount();
+    unsigned int num_segments = std::max(1u, std::min(parallel_for.getNumThreads(), 
+            num_states / MIN_STATES_PER_SEGMENT));
+    std::vector< boost::shared_ptr<og::PathGeometric> > segments;
+    for(unsigned int i=0; i<num_segments; ++i) {
+        unsigned int first = i * (num_states - 1) / num_segments;
+        unsigned int last = (i + 1) * (num_states - 1) / num_segments;
+        boost::shared_ptr<og::PathGeometric> segment(new og::PathGeometric(mpSpaceInformation));
+        for(unsigned int j=first; j<=last; ++j) {
+            segment->append(path->getState(j));
+        }
+        segments.push_back(segment);
+    }
+    
+    parallel_for.run(segments.size(), 
+            boost::bind(&Ompl::simplifySegment, this, &segments, time, _1));
+    
+    og::PathGeometric* simplified_path = new og::PathGeometric(mpSpaceInformation);
+    simplified_path->append(segments[0]->getState(0));
+    for(unsigned int i=0; i<segments.size(); ++i) {
+        for(unsigned int j=1; j<segments[i]->getStateCount(); ++j) {
+            simplified_path->append(segments[i]->getState(j));
+        }
+    }
+    LOG_INFO("Path has been simplified in %d segments from %d to %d states, length %4.2f to %4.2f", 
+            num_segments, num_states, (int)simplified_path->getStateCount(), 
+            path->length(), simplified_path->length());
+    mpPathInGridOmpl = ompl::base::PathPtr(simplified_path);
+}
+
+void Ompl::intermediateSolutionCallback(const ompl::base::Planner* planner, 
+        const std::vector<const ompl::base::State*>& states, 
+        const ompl::base::Cost cost) {
+    
+    // Parallel planners report from their own threads, only improvements 
+    // of the overall best solution are passed on.
+    boost::lock_guard<boost::mutex> lock(mSolutionMutex);
+    double cost_value = getCostValue(cost);
+    if(cost_value >= mBestReportedCost) {
+        return;
+    }
+    if(mLastImprovementTime.isNull() || 
+            cost_value < mBestReportedCost * (1.0 - STAGNATION_MIN_IMPROVEMENT)) {
+        mLastImprovementTime = base::Time::now();
+    }
+    mBestReportedCost = cost_value;
+    
+    if(!mImprovedSolutionCallback) {
+        return;
+    }
+    
+    // The planners may pass the states without start and goal and in 
+    // reversed order (RRT* runs from the goal motion back to the start).
+    const ompl::base::State* start = mpProblemDefinition->getStartState(0);
+    const ompl::base::State* goal = NULL;
+    const ompl::base::GoalState* goal_state = 
+            dynamic_cast<const ompl::base::GoalState*>(mpProblemDefinition->getGoal().get());
+    if(goal_state != NULL) {
+        goal = goal_state->getState();
+    }
+    
+    std::vector<const ompl::base::State*> ordered_states(states);
+    if(ordered_states.size() > 1 && start != NULL && 
+            mpSpaceInformation->distance(start, ordered_states.back()) < 
+            mpSpaceInformation->distance(start, ordered_states.front())) {
+        std::reverse(ordered_states.begin(), ordered_states.end());
+    }
+    
+    ompl::geometric::PathGeometric* path = new ompl::geometric::PathGeometric(mpSpaceInformation);
+    if(start != NULL && (ordered_states.empty() || 
+            !mpSpaceInformation->equalStates(start, ordered_states.front()))) {
+        path->append(start);
+    }
+    for(unsigned int i=0; i<ordered_states.size(); ++i) {
+        path->append(ordered_states[i]);
+    }
+    if(goal != NULL && !mpSpaceInformation->equalStates(goal, path->getStates().back())) {
+        path->append(goal);
+    }
+    
+    mpPathInGridOmpl = ompl::base::PathPtr(path);
+    mPathCost = cost_value;
+    LOG_INFO("Improved solution with cost %4.2f contains %d states", 
+            mPathCost, path->getStateCount());
+    notifyImprovedSolution();
+}
+
+double Ompl::getStartGoalDistance() {
+    if(mpProblemDefinition->getStartStateCount() == 0) {
+        return 0.0;
+    }
+    const ompl::base::GoalState* goal_state = 
+            dynamic_cast<const ompl::base::GoalState*>(mpProblemDefinition->getGoal().get());
+    if(goal_state == NULL) {
+        return 0.0;
+    }
+    return mpSpaceInformation->distance(mpProblemDefinition->getStartState(0), 
+            goal_state->getState());
+}
+
+bool Ompl::isStagnating() {
+    boost::lock_guard<boost::mutex> lock(mSolutionMutex);
+    if(mLastImprovementTime.isNull()) {
+        return false;
+    }
+    if((base::Time::now() - mLastImprovementTime).toSeconds() > mConfig.mOmplStagnationTime) {
+        LOG_INFO("Solution has not been improved within %4.2f sec, stop planning", 
+                mConfig.mOmplStagnationTime);
+        return true;
+    }
+    return false;
+}
+
+double Ompl::getCostValue(const ompl::base::Cost& cost) {
+#if OMPL_VERSION_VALUE > 1000000
+    return cost.value();
+#else
+    return cost.v;
+#endif
+}
+
+// PRIVATE
+void Ompl::simplifySegment(std::vector< boost::shared_ptr<og::PathGeometric> >* segments,
+        double time, size_t segment_id) {
+    // Each thread uses its own simplifier (random number generator). 
+    // The validity checks are reentrant.
+    og::PathSimplifier simplifier(mpSpaceInformation);
+    og::PathGeometric& segment = *(*segments)[segment_id];
+    og::PathGeometric raw_segment(segment);
+    simplifier.simplify(segment, time);
+    // The B-spline smoothing subdivides the segment. If this results in more
+    // states than before, the segment is only shortened by vertex reduction.
+    if(segment.getStateCount() >= raw_segment.getStateCount()) {
+        segment = raw_segment;
+        simplifier.reduceVertices(segment);
+    }
 }
 
 } // namespace motion_planning_libraries
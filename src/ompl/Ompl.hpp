@@ -6,8 +6,22 @@
 #include <ompl/base/OptimizationObjective.h>
 #include <ompl/base/Planner.h>
 
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <base/Time.hpp>
+
 #include <motion_planning_libraries/AbstractMotionPlanningLibrary.hpp>
 
+namespace ompl {
+namespace tools {
+class ParallelPlan;
+}
+namespace geometric {
+class PathGeometric;
+}
+}
+
 namespace motion_planning_libraries
 {
 
@@ -24,25 +38,188 @@ namespace motion_planning_libraries
 class Ompl : public AbstractMotionPlanningLibrary
 {
  protected: 
+    // Paths are only split into parallel simplified segments of at least this size.
+    static const unsigned int MIN_STATES_PER_SEGMENT = 10;
+    // Relative cost reduction which counts as an improvement (mOmplStagnationTime).
+    static const double STAGNATION_MIN_IMPROVEMENT;
+    
     ompl::base::StateSpacePtr mpStateSpace;
     ompl::base::SpaceInformationPtr mpSpaceInformation;
     ompl::base::ProblemDefinitionPtr mpProblemDefinition;
     ompl::base::PlannerPtr mpPlanner;
     ompl::base::OptimizationObjectivePtr mpMultiOptimization;
     ompl::base::PathPtr mpPathInGridOmpl;
+    // Runs mpPlanner and additional planner instances concurrently, 
+    // only created if mOmplNumParallelPlanners > 1.
+    boost::shared_ptr<ompl::tools::ParallelPlan> mpParallelPlan;
+    std::vector<ompl::base::PlannerPtr> mParallelPlanners; // Without mpPlanner.
+    // The intermediate solutions of the parallel planners are reported 
+    // from their threads.
+    boost::mutex mSolutionMutex;
+    double mBestReportedCost;
+    // Time of the last noticeable improvement (mOmplStagnationTime).
+    base::Time mLastImprovementTime;
+    // Multi-query mode: Identifies the map of the current environment and 
+    // the map the roadmap of mpPlanner has been built on.
+    std::string mMapId;
+    std::string mRoadmapMapId;
       
  public: 
-    Ompl(Config config = Config());
+    Ompl(Config const& config = Config());
     virtual ~Ompl() {}
 
     /**
      * Tries to find a valid path for \a time seconds.
      * If this method is called several times it will optimize the found solution.
+     * If an improved solution callback is registered, the intermediate 
+     * solutions of the optimizing planners are reported.
      */
     virtual bool solve(double time);
+    
+    /**
+     * Multi-query mode: Stores the roadmap of the planner and the map id
+     * (<filename>.mapid), so it can be reused by setting mOmplRoadmapFile.
+     */
+    virtual bool saveRoadmap(std::string filename);
+    
+    /**
+     * Multi-query mode: Number of vertices of the current roadmap.
+     */
+    virtual unsigned int getNumRoadmapVertices();
 
  protected:
+    /**
+     * Creates a new planner instance for the current space information.
+     * Used to create the additional planners of the parallel mode, 
+     * an environment which does not support it returns an empty pointer.
+     */
+    virtual ompl::base::PlannerPtr createPlanner();
+    
+    /**
+     * Creates the geometric planner selected by mConfig.mPlanner. For UNDEFINED_PLANNER
+     * RRTConnect is used if mSearchUntilFirstSolution is set, otherwise RRT*. 
+     * Returns an empty pointer if the planner is not available.
+     */
+    ompl::base::PlannerPtr createGeometricPlanner(const ompl::base::SpaceInformationPtr& si);
+    
+    /**
+     * Passes mMaxAllowedSampleDist ('range') and mOmplGoalBias ('goal_bias') 
+     * to the planner if they are set and supported by the planner.
+     */
+    void setPlannerParams(const ompl::base::PlannerPtr& planner);
+    
+    /**
+     * Replaces the default nearest neighbor structure (GNAT) of RRT* and RRTConnect
+     * by a GridNearestNeighbors if mOmplGridNearestNeighbors is set and the state 
+     * space is based on the 2D grid position (XY, SHERPA, SE2). 
+     * Has to be called before the planner is set up.
+     */
+    void setGridNearestNeighbors(const ompl::base::PlannerPtr& planner);
+    
+    /**
+     * Returns WarmStartRRTstar if mOmplWarmStart is set, otherwise RRT*.
+     */
+    ompl::base::PlannerPtr createRRTstar(const ompl::base::SpaceInformationPtr& si);
+    
+    /**
+     * Warm start mode: Has to be called before new start and goal states are set.
+     * Clears the trees of the planners and passes the current solution 
+     * as seed path, see WarmStartRRTstar.
+     */
+    void warmStartPlanners();
+    
+    /**
+     * Returns the unused arenas of the state pool to the heap (mOmplPooledStates),
+     * called with each new start and goal after the planners have been cleared
+     * (clearQuery(), warmStartPlanners()).
+     */
+    void releaseUnusedStates();
+    
+    /**
+     * Multi-query mode: Creates PRM* (or LazyPRM*) which continues the roadmap 
+     * of the current planner if the map has not changed (see mMapId) or
+     * the roadmap stored in mOmplRoadmapFile if it matches the map.
+     * Returns an empty pointer if no roadmap can be reused.
+     */
+    ompl::base::PlannerPtr createRoadmapPlanner(const ompl::base::SpaceInformationPtr& si);
+    
+    /**
+     * Multi-query mode: Has to be called before new start and goal states are set.
+     * Removes the old query and solutions but keeps the roadmap.
+     */
+    void clearQuery();
+    
+    /**
+     * Returns an id which describes the size, resolution and content of the map,
+     * see PreprocessedMap::createMapId(). The id of an attached preprocessed
+     * map is only calculated once for all planners.
+     */
+    std::string getMapId(envire::TraversabilityGrid* trav_grid,
+            boost::shared_ptr<TravData> grid_data);
+    
+    /**
+     * If more than one parallel planner has been configured, mpPlanner and 
+     * mOmplNumParallelPlanners-1 further planners created by createPlanner() are
+     * combined into one ompl::tools::ParallelPlan. They share the space information
+     * and the problem definition, so the found solutions are merged and the best 
+     * one is used. Has to be called after mpPlanner has been set up.
+     */
+    void setupParallelPlanners();
+    
+    /**
+     * If mOmplFreeCellSampling is set, the uniform samples of the state space are 
+     * drawn from the valid cells of the map (FreeCellStateSampler). 
+     * Has to be called after the validator has been set.
+     */
+    void setupFreeCellSampling(envire::TraversabilityGrid* trav_grid,
+            boost::shared_ptr<TravData> grid_data);
+    
+    /**
+     * Returns the states of the current geometric or control path, 
+     * they are owned by the path.
+     */
     std::vector<ompl::base::State*> getPathStates();
+    
+    /**
+     * Shortens and smoothes the geometric path within \a time seconds. Longer paths 
+     * are split into segments which are simplified in parallel (mNumThreads).
+     * A simplified segment never contains more states than before.
+     */
+    void simplifyPath(double time);
+    
+    /**
+     * Receives the intermediate solutions of the planner, stores them 
+     * as the current path (including start and goal) and notifies the callback.
+     */
+    void intermediateSolutionCallback(const ompl::base::Planner* planner, 
+            const std::vector<const ompl::base::State*>& states, 
+            const ompl::base::Cost cost);
+    
+    static double getCostValue(const ompl::base::Cost& cost);
+    
+    /**
+     * Lower bound of the costs from start to goal, used to stop the optimizing 
+     * planners close to it (mOmplCostTolerance). 0 if no bound is known.
+     */
+    virtual double getCostLowerBound() {
+        return 0.0;
+    }
+    
+    /**
+     * Distance between the first start and the goal state within the state space,
+     * 0 if the goal is not a single state.
+     */
+    double getStartGoalDistance();
+    
+    /**
+     * Termination condition: True if the solution has not been improved 
+     * by STAGNATION_MIN_IMPROVEMENT within mOmplStagnationTime.
+     */
+    bool isStagnating();
+    
+ private:
+    void simplifySegment(std::vector< boost::shared_ptr<ompl::geometric::PathGeometric> >* segments,
+            double time, size_t segment_id);
 };
 
 } // end namespace motion_planning_libraries
@@ -2,10 +2,9 @@
 
 #include <ompl/base/spaces/RealVectorStateSpace.h>
 #include <ompl/base/objectives/PathLengthOptimizationObjective.h>
-#include <ompl/geometric/planners/rrt/RRTConnect.h>
-#include <ompl/geometric/planners/rrt/RRTstar.h>
 
 #include <motion_planning_libraries/ompl/objectives/TravGridObjective.hpp>
+#include <motion_planning_libraries/ompl/spaces/PooledStateSpaces.hpp>
 
 namespace ob = ompl::base;
 namespace og = ompl::geometric;
@@ -14,7 +13,7 @@ namespace motion_planning_libraries
 {
     
 // PUBLIC
-OmplEnvARM::OmplEnvARM(Config config) : Ompl(config) {
+OmplEnvARM::OmplEnvARM(Config const& config) : Ompl(config) {
 }
  
 bool OmplEnvARM::initialize_arm() {
@@ -25,7 +24,11 @@ bool OmplEnvARM::initialize_arm() {
 
     LOG_INFO("Create OMPL RealVector(%d) environment", mConfig.mJointBorders.size());
     
-    mpStateSpace = ob::StateSpacePtr(new ob::RealVectorStateSpace(mConfig.mJointBorders.size()));
+    if(mConfig.mOmplPooledStates) {
+        mpStateSpace = ob::StateSpacePtr(new PooledRealVectorStateSpace(mConfig.mJointBorders.size()));
+    } else {
+        mpStateSpace = ob::StateSpacePtr(new ob::RealVectorStateSpace(mConfig.mJointBorders.size()));
+    }
     ob::RealVectorBounds bounds(mConfig.mJointBorders.size());
     
     std::vector< std::pair<double,double> >::iterator it = mConfig.mJointBorders.begin();
@@ -49,10 +52,9 @@ bool OmplEnvARM::initialize_arm() {
     // Create problem definition. By default path length optimization will be used.    
     mpProblemDefinition = ob::ProblemDefinitionPtr(new ob::ProblemDefinition(mpSpaceInformation));
    
-    if(mConfig.mSearchUntilFirstSolution) { // Not optimizing planner, 
-        mpPlanner = ob::PlannerPtr(new og::RRTConnect(mpSpaceInformation));
-    } else { // Optimizing planners use all the available time to improve the solution.
-        mpPlanner = ob::PlannerPtr(new og::RRTstar(mpSpaceInformation));
+    mpPlanner = createGeometricPlanner(mpSpaceInformation);
+    if(!mpPlanner) {
+        return false;
     }
 
     // Set the problem instance for our planner to solve
@@ -62,7 +64,7 @@ bool OmplEnvARM::initialize_arm() {
     return true;
 }
 
-bool OmplEnvARM::setStartGoal(struct State start_state, struct State goal_state) {
+bool OmplEnvARM::setStartGoal(struct State const& start_state, struct State const& goal_state) {
     
     assert(start_state.getJointAngles().size() == goal_state.getJointAngles().size());
     assert(start_state.getJointAngles().size() == mConfig.mJointBorders.size());
@@ -72,6 +74,8 @@ bool OmplEnvARM::setStartGoal(struct State start_state, struct State goal_state)
         return false;
     }
     
+    releaseUnusedStates();
+    
     ob::ScopedState<> start_ompl(mpStateSpace);
     ob::ScopedState<> goal_ompl(mpStateSpace);
     
@@ -15,7 +15,7 @@ class OmplEnvARM : public Ompl
     ompl::base::OptimizationObjectivePtr mpTravGridObjective;
       
  public: 
-    OmplEnvARM(Config config = Config());
+    OmplEnvARM(Config const& config = Config());
     virtual ~OmplEnvARM() {}
 
     /**
@@ -26,7 +26,7 @@ class OmplEnvARM : public Ompl
     /**
      * Sets the global start and goal poses (in grid coordinates) in OMPL.
      */ 
-    virtual bool setStartGoal(struct State start_state, struct State goal_state);
+    virtual bool setStartGoal(struct State const& start_state, struct State const& goal_state);
     
     /**
      * Tries to find a valid path for \a time seconds.
@@ -2,8 +2,6 @@
 
 #include <ompl/base/spaces/RealVectorStateSpace.h>
 #include <ompl/base/objectives/PathLengthOptimizationObjective.h>
-#include <ompl/geometric/planners/rrt/RRTConnect.h>
-#include <ompl/geometric/planners/rrt/RRTstar.h>
 #include <ompl/base/samplers/ObstacleBasedValidStateSampler.h>
 #include <ompl/base/samplers/GaussianValidStateSampler.h>
 
@@ -18,13 +16,19 @@ namespace motion_planning_libraries
 {
     
 // PUBLIC
-OmplEnvSHERPA::OmplEnvSHERPA(Config config) : Ompl(config) {
+OmplEnvSHERPA::OmplEnvSHERPA(Config const& config) : Ompl(config) {
 }
  
 bool OmplEnvSHERPA::initialize(envire::TraversabilityGrid* trav_grid,
             boost::shared_ptr<TravData> grid_data) { 
 
     LOG_INFO("Create OMPL SHERPA environment");
+    // Allows to reuse the roadmap of the last environment in multi-query mode,
+    // the id of the shared preprocessed map is only calculated once per map.
+    mMapId.clear();
+    if(mConfig.mOmplMultiQuery) {
+        mMapId = getMapId(trav_grid, grid_data);
+    }
     
     if(mConfig.mFootprintRadiusMinMax.first == 0 || mConfig.mFootprintRadiusMinMax.second == 0) {
         LOG_WARN("No min AND max radius have been defined within the Sherpa environment, abort");
@@ -53,7 +57,13 @@ bool OmplEnvSHERPA::initialize(envire::TraversabilityGrid* trav_grid,
     mpSpaceInformation->setStateValidityChecker(mpTravMapValidator);
     // 1/mpStateSpace->getMaximumExtent() (max dist between two states) -> resolution of one meter.
     // mpSpaceInformation->setStateValidityCheckingResolution (1/mpStateSpace->getMaximumExtent());
-    mpSpaceInformation->setValidStateSamplerAllocator(allocOBValidStateSampler);
+    if(mConfig.mOmplFreeCellSampling) {
+        // The default valid state sampler uses the free cell sampler and 
+        // usually succeeds with its first attempt.
+        setupFreeCellSampling(trav_grid, grid_data);
+    } else {
+        mpSpaceInformation->setValidStateSamplerAllocator(allocOBValidStateSampler);
+    }
     mpSpaceInformation->setup();
         
     // Create problem definition.        
@@ -65,27 +75,25 @@ bool OmplEnvSHERPA::initialize(envire::TraversabilityGrid* trav_grid,
             trav_grid, grid_data, mConfig));
     mpProblemDefinition->setOptimizationObjective(getBalancedObjective(mpSpaceInformation));
 
-    if(mConfig.mSearchUntilFirstSolution) { // Not optimizing planner, 
-        mpPlanner = ob::PlannerPtr(new og::RRTConnect(mpSpaceInformation));
-    } else { // Optimizing planners use all the available time to improve the solution.
-        mpPlanner = ob::PlannerPtr(new og::RRTstar(mpSpaceInformation));
-        // Allows to configure the max allowed dist between two samples.
-        if(mConfig.mMaxAllowedSampleDist > 0 && !std::isnan(mConfig.mMaxAllowedSampleDist)) {
-            ompl::base::ParamSet param_set = mpPlanner->params();
-            std::stringstream ss;
-            ss << mConfig.mMaxAllowedSampleDist;
-            param_set.setParam("range", ss.str().c_str());
-        }
+    mpPlanner = createPlanner();
+    if(!mpPlanner) {
+        return false;
     }
 
     // Set the problem instance for our planner to solve
     mpPlanner->setProblemDefinition(mpProblemDefinition);
     mpPlanner->setup(); // Calls mpSpaceInformation->setup() as well.
     
+    setupParallelPlanners();
+    
     return true;
 }
 
-bool OmplEnvSHERPA::setStartGoal(struct State start_state, struct State goal_state) {
+bool OmplEnvSHERPA::setStartGoal(struct State const& start_state, struct State const& goal_state) {
+    
+    clearQuery();
+    warmStartPlanners();
+    releaseUnusedStates();
     
     double start_x = start_state.getPose().position[0];
     double start_y = start_state.getPose().position[1];
@@ -155,6 +163,19 @@ bool OmplEnvSHERPA::fillPath(std::vector<struct State>& path, bool& pos_defined_
 }
 
 // PROTECTED
+ompl::base::PlannerPtr OmplEnvSHERPA::createPlanner() {
+    return createGeometricPlanner(mpSpaceInformation);
+}
+
+double OmplEnvSHERPA::getCostLowerBound() {
+    if(!mpTravGridObjective) {
+        return 0.0;
+    }
+    TravGridObjective* trav_objective = static_cast<TravGridObjective*>(mpTravGridObjective.get());
+    // Only the trav grid objective is used, changing the footprint adds further costs.
+    return getStartGoalDistance() * trav_objective->getMinStateCost();
+}
+
 ompl::base::OptimizationObjectivePtr OmplEnvSHERPA::getBalancedObjective(
     const ompl::base::SpaceInformationPtr& si) {
 
@@ -15,7 +15,7 @@ class OmplEnvSHERPA : public Ompl
     ompl::base::OptimizationObjectivePtr mpTravGridObjective;
       
  public: 
-    OmplEnvSHERPA(Config config = Config());
+    OmplEnvSHERPA(Config const& config = Config());
 
     /**
      * (Re-)creates the complete ompl environment.
@@ -26,7 +26,7 @@ class OmplEnvSHERPA : public Ompl
     /**
      * Sets the global start and goal poses (in grid coordinates) in OMPL.
      */ 
-    virtual bool setStartGoal(struct State start_state, struct State goal_state);
+    virtual bool setStartGoal(struct State const& start_state, struct State const& goal_state);
         
     /**
      * Converts the ompl path to an rigid body state path (both in grid coordinates).
@@ -34,6 +34,17 @@ class OmplEnvSHERPA : public Ompl
     virtual bool fillPath(std::vector<struct State>& path, bool& pos_defined_in_local_grid);
     
  protected:  
+    /**
+     * Lower bound of the balanced objective: distance between start and goal
+     * times the lowest costs per distance.
+     */
+    virtual double getCostLowerBound();
+    
+    /**
+     * Creates the planner selected by mConfig.mPlanner, see createGeometricPlanner().
+     */
+    virtual ompl::base::PlannerPtr createPlanner();
+    
     /**
      * Creates a combined optimization objective which tries to minimize the
      * costs of the trav grid.
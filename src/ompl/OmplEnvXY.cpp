@@ -2,11 +2,10 @@
 
 #include <ompl/base/spaces/RealVectorStateSpace.h>
 #include <ompl/base/objectives/PathLengthOptimizationObjective.h>
-#include <ompl/geometric/planners/rrt/RRTConnect.h>
-#include <ompl/geometric/planners/rrt/RRTstar.h>
 
 #include <motion_planning_libraries/ompl/validators/TravMapValidator.hpp>
 #include <motion_planning_libraries/ompl/objectives/TravGridObjective.hpp>
+#include <motion_planning_libraries/ompl/spaces/PooledStateSpaces.hpp>
 
 namespace ob = ompl::base;
 namespace og = ompl::geometric;
@@ -15,15 +14,25 @@ namespace motion_planning_libraries
 {
     
 // PUBLIC
-OmplEnvXY::OmplEnvXY(Config config) : Ompl(config) {
+OmplEnvXY::OmplEnvXY(Config const& config) : Ompl(config) {
 }
  
 bool OmplEnvXY::initialize(envire::TraversabilityGrid* trav_grid,
             boost::shared_ptr<TravData> grid_data) { 
 
     LOG_INFO("Create OMPL RealVector(2) environment");
+    // Allows to reuse the roadmap of the last environment in multi-query mode,
+    // the id of the shared preprocessed map is only calculated once per map.
+    mMapId.clear();
+    if(mConfig.mOmplMultiQuery) {
+        mMapId = getMapId(trav_grid, grid_data);
+    }
     
-    mpStateSpace = ob::StateSpacePtr(new ob::RealVectorStateSpace(2));
+    if(mConfig.mOmplPooledStates) {
+        mpStateSpace = ob::StateSpacePtr(new PooledRealVectorStateSpace(2));
+    } else {
+        mpStateSpace = ob::StateSpacePtr(new ob::RealVectorStateSpace(2));
+    }
     ob::RealVectorBounds bounds(2);
     bounds.setLow (0, 0);
     bounds.setHigh(0, trav_grid->getCellSizeX());
@@ -40,6 +49,7 @@ bool OmplEnvXY::initialize(envire::TraversabilityGrid* trav_grid,
     mpTravMapValidator = ob::StateValidityCheckerPtr(new TravMapValidator(
                 mpSpaceInformation, trav_grid, grid_data, mConfig));
     mpSpaceInformation->setStateValidityChecker(mpTravMapValidator);
+    setupFreeCellSampling(trav_grid, grid_data);
     // 1/mpStateSpace->getMaximumExtent() (max dist between two states) -> resolution of one meter.
     mpSpaceInformation->setStateValidityCheckingResolution (1/mpStateSpace->getMaximumExtent());
     mpSpaceInformation->setup();
@@ -53,23 +63,25 @@ bool OmplEnvXY::initialize(envire::TraversabilityGrid* trav_grid,
             trav_grid, grid_data, mConfig));
     mpProblemDefinition->setOptimizationObjective(getBalancedObjective(mpSpaceInformation));
 
-    if(mConfig.mSearchUntilFirstSolution) { // Not optimizing planner, 
-        mpPlanner = ob::PlannerPtr(new og::RRTConnect(mpSpaceInformation));
-    } else { // Optimizing planners use all the available time to improve the solution.
-        mpPlanner = ob::PlannerPtr(new og::RRTstar(mpSpaceInformation));
-        // Allows to configure the max allowed dist between two samples.
-        ompl::base::ParamSet param_set = mpPlanner->params();
-        param_set.setParam("range", "0.5");
+    mpPlanner = createPlanner();
+    if(!mpPlanner) {
+        return false;
     }
 
     // Set the problem instance for our planner to solve
     mpPlanner->setProblemDefinition(mpProblemDefinition);
     mpPlanner->setup(); // Calls mpSpaceInformation->setup() as well.
     
+    setupParallelPlanners();
+    
     return true;
 }
 
-bool OmplEnvXY::setStartGoal(struct State start_state, struct State goal_state) {
+bool OmplEnvXY::setStartGoal(struct State const& start_state, struct State const& goal_state) {
+    
+    clearQuery();
+    warmStartPlanners();
+    releaseUnusedStates();
     
     ob::ScopedState<> start_ompl(mpStateSpace);
     ob::ScopedState<> goal_ompl(mpStateSpace);
@@ -87,12 +99,6 @@ bool OmplEnvXY::setStartGoal(struct State start_state, struct State goal_state)
             
     mpProblemDefinition->setStartAndGoalStates(start_ompl, goal_ompl);
     
-    // Stop if the found solution is nearly a straight line.
-    double dist_start_goal = sqrt((start_x - goal_x) * (start_x - goal_x) + 
-            (start_y - goal_y) * (start_y - goal_y)) * 1.1;
-    LOG_INFO("Set cost threshold to %4.2f", dist_start_goal);
-    mpPathLengthOptimization->setCostThreshold(ob::Cost(dist_start_goal));
-    
     return true;
 }
 
@@ -124,6 +130,26 @@ bool OmplEnvXY::fillPath(std::vector<struct State>& path, bool& pos_defined_in_l
 }
 
 // PROTECTED
+ompl::base::PlannerPtr OmplEnvXY::createPlanner() {
+    ob::PlannerPtr planner = createGeometricPlanner(mpSpaceInformation);
+    // Default max allowed dist between two samples of the optimizing planner.
+    if(planner && mConfig.mPlanner == UNDEFINED_PLANNER && !mConfig.mSearchUntilFirstSolution &&
+            !(mConfig.mMaxAllowedSampleDist > 0) && planner->params().hasParam("range")) {
+        planner->params().setParam("range", "0.5");
+    }
+    return planner;
+}
+
+double OmplEnvXY::getCostLowerBound() {
+    if(!mpTravGridObjective) {
+        return 0.0;
+    }
+    TravGridObjective* trav_objective = static_cast<TravGridObjective*>(mpTravGridObjective.get());
+    // Path length and trav grid costs (both weighted with 1.0) of the straight 
+    // line, the trav grid costs are at least the lowest state cost per distance.
+    return getStartGoalDistance() * (1.0 + trav_objective->getMinStateCost());
+}
+
 ompl::base::OptimizationObjectivePtr OmplEnvXY::getBalancedObjective(
     const ompl::base::SpaceInformationPtr& si) {
 
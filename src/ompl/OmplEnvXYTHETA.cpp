@@ -1,10 +1,19 @@
 #include "OmplEnvXYTHETA.hpp"
 
 #include <ompl/base/objectives/PathLengthOptimizationObjective.h>
+#include <ompl/base/spaces/DubinsStateSpace.h>
+#include <ompl/base/spaces/ReedsSheppStateSpace.h>
+#include <ompl/geometric/PathGeometric.h>
+#include <ompl/config.h>
 #include <ompl/control/planners/rrt/RRT.h>
+#include <ompl/control/planners/kpiece/KPIECE1.h>
+#if OMPL_VERSION_VALUE >= 1001000
+#include <ompl/control/planners/sst/SST.h>
+#endif
 
 #include <motion_planning_libraries/ompl/validators/TravMapValidator.hpp>
 #include <motion_planning_libraries/ompl/objectives/TravGridObjective.hpp>
+#include <motion_planning_libraries/ompl/spaces/PooledStateSpaces.hpp>
 
 namespace ob = ompl::base;
 namespace og = ompl::geometric;
@@ -15,7 +24,7 @@ namespace motion_planning_libraries
 double OmplEnvXYTHETA::mCarLength = 2.0;   
     
 // PUBLIC
-OmplEnvXYTHETA::OmplEnvXYTHETA(Config config) : Ompl(config) {
+OmplEnvXYTHETA::OmplEnvXYTHETA(Config const& config) : Ompl(config) {
     double length = std::max(mConfig.mFootprintLengthMinMax.first, mConfig.mFootprintLengthMinMax.second);
     if(length == 0) {
         length = std::max(mConfig.mFootprintRadiusMinMax.first, 
@@ -33,10 +42,18 @@ OmplEnvXYTHETA::OmplEnvXYTHETA(Config config) : Ompl(config) {
 bool OmplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
             boost::shared_ptr<TravData> grid_data) {
   
+    if(mConfig.mOmplSteering != STEERING_CONTROL) {
+        return initializeGeometric(trav_grid, grid_data);
+    }
+    
     // Will define a control problem in SE2 (X, Y, THETA).
     LOG_INFO("Create OMPL SE2 environment");
     
-    mpStateSpace = ompl::base::StateSpacePtr(new ob::SE2StateSpace());
+    if(mConfig.mOmplPooledStates) {
+        mpStateSpace = ompl::base::StateSpacePtr(new PooledSE2StateSpace<>());
+    } else {
+        mpStateSpace = ompl::base::StateSpacePtr(new ob::SE2StateSpace());
+    }
     ob::RealVectorBounds bounds(2);
     bounds.setLow (0, 0);
     bounds.setHigh(0, trav_grid->getCellSizeX());
@@ -78,6 +95,9 @@ bool OmplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
                 mpControlSpaceInformation, trav_grid, grid_data, mConfig));
     mpControlSpaceInformation->setStateValidityChecker(mpTravMapValidator);
     mpControlSpaceInformation->setup();
+    // Used by the base class e.g. to order the intermediate solutions.
+    mpSpaceInformation = mpControlSpaceInformation;
+    setupFreeCellSampling(trav_grid, grid_data);
         
     // Create problem definition.        
     mpProblemDefinition = ob::ProblemDefinitionPtr(new ob::ProblemDefinition(mpControlSpaceInformation));
@@ -88,8 +108,10 @@ bool OmplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
             trav_grid, grid_data, mConfig));
     mpProblemDefinition->setOptimizationObjective(getBalancedObjective(mpControlSpaceInformation));
     
-    // Control based planner, optimization is not supported by OMPL.
-    mpPlanner = ob::PlannerPtr(new ompl::control::RRT(mpControlSpaceInformation));
+    mpPlanner = createPlanner();
+    if(!mpPlanner) {
+        return false;
+    }
 
     // Set the problem instance for our planner to solve
     mpPlanner->setProblemDefinition(mpProblemDefinition);
@@ -98,7 +120,11 @@ bool OmplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
     return true;
 }
 
-bool OmplEnvXYTHETA::setStartGoal(struct State start_state, struct State goal_state) {
+bool OmplEnvXYTHETA::setStartGoal(struct State const& start_state, struct State const& goal_state) {
+    
+    clearQuery();
+    warmStartPlanners();
+    releaseUnusedStates();
     
     ob::ScopedState<> start_ompl(mpStateSpace);
     ob::ScopedState<> goal_ompl(mpStateSpace);
@@ -128,6 +154,15 @@ bool OmplEnvXYTHETA::solve(double time) {
 }
     
 bool OmplEnvXYTHETA::fillPath(std::vector<struct State>& path, bool& pos_defined_in_local_grid) {
+    // The geometric path only contains the connected states, the curves 
+    // in between are sampled to get a driveable trajectory.
+    og::PathGeometric* path_geometric = dynamic_cast<og::PathGeometric*>(mpPathInGridOmpl.get());
+    if(mConfig.mOmplSteering != STEERING_CONTROL && path_geometric != NULL) {
+        fillSteeringPath(*path_geometric, path);
+        LOG_INFO("Trajectory contains %d states", (int)path.size()); 
+        return true;
+    }
+    
     std::vector<ompl::base::State*> path_states = getPathStates();
     std::vector<ompl::base::State*>::iterator it = path_states.begin();
 
@@ -152,6 +187,51 @@ bool OmplEnvXYTHETA::fillPath(std::vector<struct State>& path, bool& pos_defined
 }
 
 // PROTECTED
+ompl::base::PlannerPtr OmplEnvXYTHETA::createPlanner() {
+    if(mConfig.mOmplSteering != STEERING_CONTROL) {
+        return createGeometricPlanner(mpSpaceInformation);
+    }
+    
+    ob::PlannerPtr planner;
+    
+    switch(mConfig.mPlanner) {
+        case UNDEFINED_PLANNER: {
+            // Control based planner, optimization is not supported.
+            planner = ob::PlannerPtr(new ompl::control::RRT(mpControlSpaceInformation));
+            break;
+        }
+        case KPIECE: {
+            planner = ob::PlannerPtr(new ompl::control::KPIECE1(mpControlSpaceInformation));
+            break;
+        }
+#if OMPL_VERSION_VALUE >= 1001000
+        case SST: {
+            // Asymptotically near-optimal, uses the optimization objective.
+            planner = ob::PlannerPtr(new ompl::control::SST(mpControlSpaceInformation));
+            break;
+        }
+#endif
+        default: {
+            LOG_ERROR("Planner %d is not available for the OMPL control problem (ENV_XYTHETA)", 
+                    (int)mConfig.mPlanner);
+            return planner;
+        }
+    }
+    
+    setPlannerParams(planner);
+    return planner;
+}
+
+double OmplEnvXYTHETA::getCostLowerBound() {
+    if(!mpTravGridObjective) {
+        return 0.0;
+    }
+    TravGridObjective* trav_objective = static_cast<TravGridObjective*>(mpTravGridObjective.get());
+    // Path length and trav grid costs (both weighted with 1.0) of the shortest
+    // connection, the trav grid costs are at least the lowest state cost per distance.
+    return getStartGoalDistance() * (1.0 + trav_objective->getMinStateCost());
+}
+
 ompl::base::OptimizationObjectivePtr OmplEnvXYTHETA::getBalancedObjective(
     const ompl::base::SpaceInformationPtr& si) {
 
@@ -163,4 +243,158 @@ ompl::base::OptimizationObjectivePtr OmplEnvXYTHETA::getBalancedObjective(
     return mpMultiOptimization;
 }
 
+// PRIVATE
+bool OmplEnvXYTHETA::initializeGeometric(envire::TraversabilityGrid* trav_grid,
+            boost::shared_ptr<TravData> grid_data) {
+    
+    // The turning radius has to be defined in grid cells.
+    double radius = mConfig.mMobility.mMinTurningRadius;
+    if(radius <= 0) {
+        LOG_WARN("No min turning radius has been defined, use the length %4.2f instead", mCarLength);
+        radius = mCarLength;
+    }
+    double radius_grid = radius / std::min(trav_grid->getScaleX(), trav_grid->getScaleY());
+    
+    if(mConfig.mOmplSteering == STEERING_REEDS_SHEPP) {
+        LOG_INFO("Create OMPL Reeds-Shepp environment, turning radius %4.2f grid cells", radius_grid);
+        if(mConfig.mOmplPooledStates) {
+            mpStateSpace = ompl::base::StateSpacePtr(
+                    new PooledSE2StateSpace<ob::ReedsSheppStateSpace>(radius_grid));
+        } else {
+            mpStateSpace = ompl::base::StateSpacePtr(new ob::ReedsSheppStateSpace(radius_grid));
+        }
+    } else {
+        LOG_INFO("Create OMPL Dubins environment, turning radius %4.2f grid cells", radius_grid);
+        if(mConfig.mOmplPooledStates) {
+            mpStateSpace = ompl::base::StateSpacePtr(
+                    new PooledSE2StateSpace<ob::DubinsStateSpace>(radius_grid));
+        } else {
+            mpStateSpace = ompl::base::StateSpacePtr(new ob::DubinsStateSpace(radius_grid));
+        }
+    }
+    ob::RealVectorBounds bounds(2);
+    bounds.setLow (0, 0);
+    bounds.setHigh(0, trav_grid->getCellSizeX());
+    bounds.setLow (1, 0);
+    bounds.setHigh(1, trav_grid->getCellSizeY());
+    mpStateSpace->as<ob::SE2StateSpace>()->setBounds(bounds);
+    mpStateSpace->setLongestValidSegmentFraction(1/(double)trav_grid->getCellSizeX());
+    
+    mpControlSpaceInformation.reset();
+    mpSpaceInformation = ob::SpaceInformationPtr(new ob::SpaceInformation(mpStateSpace));
+    mpTravMapValidator = ob::StateValidityCheckerPtr(new TravMapValidator(
+                mpSpaceInformation, trav_grid, grid_data, mConfig));
+    mpSpaceInformation->setStateValidityChecker(mpTravMapValidator);
+    setupFreeCellSampling(trav_grid, grid_data);
+    mpSpaceInformation->setup();
+    
+    // Create problem definition.        
+    mpProblemDefinition = ob::ProblemDefinitionPtr(new ob::ProblemDefinition(mpSpaceInformation));
+    // The path length is measured along the curves.
+    mpPathLengthOptimization = ob::OptimizationObjectivePtr(
+        new ob::PathLengthOptimizationObjective(mpSpaceInformation));
+    mpTravGridObjective = ob::OptimizationObjectivePtr(new TravGridObjective(mpSpaceInformation, false,
+            trav_grid, grid_data, mConfig));
+    mpProblemDefinition->setOptimizationObjective(getBalancedObjective(mpSpaceInformation));
+    
+    mpPlanner = createPlanner();
+    if(!mpPlanner) {
+        return false;
+    }
+    
+    // Set the problem instance for our planner to solve
+    mpPlanner->setProblemDefinition(mpProblemDefinition);
+    mpPlanner->setup();
+    
+    setupParallelPlanners();
+    
+    return true;
+}
+
+void OmplEnvXYTHETA::fillSteeringPath(og::PathGeometric const& path_geometric, 
+        std::vector<struct State>& path) {
+    
+    const ob::ReedsSheppStateSpace* reeds_shepp = 
+            dynamic_cast<const ob::ReedsSheppStateSpace*>(mpStateSpace.get());
+    const ob::DubinsStateSpace* dubins = 
+            dynamic_cast<const ob::DubinsStateSpace*>(mpStateSpace.get());
+    
+    ob::State* sampled_state = mpStateSpace->allocState();
+    size_t num_states = path_geometric.getStateCount();
+    for(size_t i=0; i<num_states; ++i) {
+        const ob::State* from = path_geometric.getState(i);
+        
+        // Segments of the curve to the next state, a negative length
+        // describes a backward movement (Reeds-Shepp only).
+        double lengths[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+        bool straights[5] = {false, false, false, false, false};
+        unsigned int num_segments = 0;
+        unsigned int num_samples = 1;
+        if(i+1 < num_states) {
+            const ob::State* to = path_geometric.getState(i+1);
+            if(reeds_shepp != NULL) {
+                ob::ReedsSheppStateSpace::ReedsSheppPath rs_path = reeds_shepp->reedsShepp(from, to);
+                num_segments = 5;
+                for(unsigned int k=0; k<num_segments; ++k) {
+                    lengths[k] = rs_path.length_[k];
+                    straights[k] = rs_path.type_[k] == ob::ReedsSheppStateSpace::RS_STRAIGHT;
+                }
+            } else if(dubins != NULL) {
+                ob::DubinsStateSpace::DubinsPath dubins_path = dubins->dubins(from, to);
+                num_segments = 3;
+                for(unsigned int k=0; k<num_segments; ++k) {
+                    lengths[k] = dubins_path.length_[k];
+                    straights[k] = dubins_path.type_[k] == ob::DubinsStateSpace::DUBINS_STRAIGHT;
+                }
+            }
+            num_samples = std::max(1u, mpStateSpace->validSegmentCount(from, to));
+        }
+        double total_length = 0.0;
+        for(unsigned int k=0; k<num_segments; ++k) {
+            total_length += fabs(lengths[k]);
+        }
+        
+        for(unsigned int j=0; j<num_samples; ++j) {
+            double t = (double)j / num_samples;
+            if(j == 0) {
+                mpStateSpace->copyState(sampled_state, from);
+            } else {
+                mpStateSpace->interpolate(from, path_geometric.getState(i+1), t, sampled_state);
+            }
+            const ob::SE2StateSpace::StateType* state = 
+                    sampled_state->as<ob::SE2StateSpace::StateType>();
+            
+            base::samples::RigidBodyState grid_pose;
+            grid_pose.position[0] = state->getX();
+            grid_pose.position[1] = state->getY();
+            grid_pose.position[2] = 0;
+            grid_pose.orientation = Eigen::AngleAxis<double>(state->getYaw(), 
+                    base::Vector3d(0,0,1));
+            State path_state(grid_pose);
+            
+            // Segment of the sample, a state at the border starts the next one.
+            if(num_segments > 0) {
+                double dist = t * total_length;
+                double segment_end = 0.0;
+                unsigned int k = 0;
+                for(; k+1 < num_segments; ++k) {
+                    segment_end += fabs(lengths[k]);
+                    if(dist < segment_end) {
+                        break;
+                    }
+                }
+                bool backward = lengths[k] < 0;
+                if(straights[k]) {
+                    path_state.mMovType = backward ? MOV_BACKWARD : MOV_FORWARD;
+                } else {
+                    path_state.mMovType = backward ? MOV_BACKWARD_TURN : MOV_FORWARD_TURN;
+                }
+                path_state.mSpeed = backward ? -mConfig.mMobility.mSpeed : mConfig.mMobility.mSpeed;
+            }
+            path.push_back(path_state);
+        }
+    }
+    mpStateSpace->freeState(sampled_state);
+}
+
 } // namespace motion_planning_libraries
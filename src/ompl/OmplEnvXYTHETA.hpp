@@ -26,7 +26,7 @@ class OmplEnvXYTHETA : public Ompl
     static double mCarLength;  
       
  public: 
-    OmplEnvXYTHETA(Config config = Config());
+    OmplEnvXYTHETA(Config const& config = Config());
 
     /**
      * (Re-)creates the complete ompl environment.
@@ -37,7 +37,7 @@ class OmplEnvXYTHETA : public Ompl
     /**
      * Sets the global start and goal poses (in grid coordinates) in OMPL.
      */ 
-    virtual bool setStartGoal(struct State start_state, struct State goal_state);
+    virtual bool setStartGoal(struct State const& start_state, struct State const& goal_state);
     
     /**
      * Tries to find a valid path for \a time seconds.
@@ -51,6 +51,22 @@ class OmplEnvXYTHETA : public Ompl
     virtual bool fillPath(std::vector<struct State>& path, bool& pos_defined_in_local_grid);
     
  private:
+    /**
+     * Creates the geometric problem using the Dubins or Reeds-Shepp state space
+     * (mOmplSteering).
+     */
+    bool initializeGeometric(envire::TraversabilityGrid* trav_grid,
+            boost::shared_ptr<TravData> grid_data);
+    
+    /**
+     * Samples the Dubins or Reeds-Shepp curves between the connected states.
+     * Like the SBPL primitives each sampled state receives the movement type and 
+     * the speed of its curve segment, the speed is negative for the backward 
+     * segments of Reeds-Shepp curves. The last state keeps the default values.
+     */
+    void fillSteeringPath(ompl::geometric::PathGeometric const& path_geometric, 
+            std::vector<struct State>& path);
+    
     // Definition of the ODE for the kinematic car. Calculates the delta.
     static const void kinematicCarOde (const ompl::control::ODESolver::StateType& q, 
             const ompl::control::Control* control, 
@@ -99,6 +115,19 @@ class OmplEnvXYTHETA : public Ompl
     }
     
  protected:  
+    /**
+     * Lower bound of the balanced objective: distance between start and goal
+     * times the lowest costs per distance.
+     */
+    virtual double getCostLowerBound();
+    
+    /**
+     * Creates the control planner selected by mConfig.mPlanner: 
+     * RRT (UNDEFINED_PLANNER), KPIECE or SST. With Dubins or Reeds-Shepp steering
+     * the geometric planners are used, see createGeometricPlanner().
+     */
+    virtual ompl::base::PlannerPtr createPlanner();
+    
     /**
      * Creates a combined optimization objective which tries to minimize the
      * costs of the trav grid.
@@ -0,0 +1,396 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_GRID_NEAREST_NEIGHBORS_HPP_
+#define _MOTION_PLANNING_LIBRARIES_GRID_NEAREST_NEIGHBORS_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <ompl/base/State.h>
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/datastructures/NearestNeighbors.h>
+
+namespace motion_planning_libraries
+{
+
+/**
+ * Nearest neighbor structure for the planning spaces which are based on
+ * the 2D position within the grid (XY, SHERPA, SE2). The elements are stored
+ * within square buckets (hash grid) of their position, a query only visits
+ * the buckets around the query position. The bucket size follows the density
+ * of the elements and is adapted each time the number of elements has doubled.
+ *
+ * Requires that the distance function is never smaller than the euclidean
+ * distance of the positions (e.g. RealVector(2), SE2, Dubins, Reeds-Shepp or
+ * SHERPA with a footprint class weight of 0), the results are exact then.
+ *
+ * The Position policy extracts the position of an element:
+ * static void get(const T& data, double& x, double& y).
+ */
+template <typename T, class Position>
+class GridNearestNeighbors : public ompl::NearestNeighbors<T>
+{
+ public:
+    // Below this size the queries are answered by a linear search.
+    static const size_t LINEAR_SEARCH_SIZE = 32;
+    // Desired mean number of elements per bucket.
+    static const size_t ELEMENTS_PER_BUCKET = 4;
+
+    GridNearestNeighbors() : ompl::NearestNeighbors<T>(),
+            mBuckets(),
+            mCellSize(1.0),
+            mSize(0),
+            mRebuildSize(LINEAR_SEARCH_SIZE),
+            mMinCellX(0), mMaxCellX(-1), mMinCellY(0), mMaxCellY(-1),
+            mMinX(0), mMaxX(0), mMinY(0), mMaxY(0) {
+    }
+
+    virtual ~GridNearestNeighbors() {
+    }
+
+    virtual bool reportsSortedResults() const {
+        return true;
+    }
+
+    virtual void clear() {
+        mBuckets.clear();
+        mCellSize = 1.0;
+        mSize = 0;
+        mRebuildSize = LINEAR_SEARCH_SIZE;
+        mMinCellX = mMinCellY = 0;
+        mMaxCellX = mMaxCellY = -1;
+    }
+
+    using ompl::NearestNeighbors<T>::add;
+
+    virtual void add(const T& data) {
+        Entry entry(data);
+        if(mSize == 0) {
+            mMinX = mMaxX = entry.mX;
+            mMinY = mMaxY = entry.mY;
+        } else {
+            mMinX = std::min(mMinX, entry.mX);
+            mMaxX = std::max(mMaxX, entry.mX);
+            mMinY = std::min(mMinY, entry.mY);
+            mMaxY = std::max(mMaxY, entry.mY);
+        }
+        insert(entry);
+        mSize++;
+
+        if(mSize >= mRebuildSize) {
+            rebuild();
+            mRebuildSize = 2 * mSize;
+        }
+    }
+
+    virtual bool remove(const T& data) {
+        Entry entry(data);
+        typename BucketMap::iterator it = mBuckets.find(getKey(getCell(entry.mX), getCell(entry.mY)));
+        if(it == mBuckets.end()) {
+            return false;
+        }
+        std::vector<Entry>& bucket = it->second;
+        for(unsigned int i=0; i<bucket.size(); ++i) {
+            if(bucket[i].mData == data) {
+                bucket[i] = bucket.back();
+                bucket.pop_back();
+                if(bucket.empty()) {
+                    mBuckets.erase(it);
+                }
+                mSize--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    virtual T nearest(const T& data) const {
+        std::vector<T> nbh;
+        nearestK(data, 1, nbh);
+        if(nbh.empty()) {
+            throw std::runtime_error("GridNearestNeighbors: No elements available");
+        }
+        return nbh[0];
+    }
+
+    virtual void nearestK(const T& data, std::size_t k, std::vector<T>& nbh) const {
+        nbh.clear();
+        if(k == 0 || mSize == 0) {
+            return;
+        }
+
+        // Max heap of the k closest elements found so far.
+        std::vector<Neighbor> heap;
+        heap.reserve(std::min(k, mSize) + 1);
+
+        if(mSize <= LINEAR_SEARCH_SIZE) {
+            typename BucketMap::const_iterator it = mBuckets.begin();
+            for(; it != mBuckets.end(); ++it) {
+                addCandidates(data, it->second, k, heap);
+            }
+        } else {
+            Entry query(data);
+            int cell_x = getCell(query.mX);
+            int cell_y = getCell(query.mY);
+            int max_ring = std::max(std::max(cell_x - mMinCellX, mMaxCellX - cell_x),
+                    std::max(cell_y - mMinCellY, mMaxCellY - cell_y));
+            for(int ring=0; ring<=max_ring; ++ring) {
+                visitRing(data, cell_x, cell_y, ring, k, heap);
+                // All elements of the following rings are further away than ring * mCellSize.
+                if(heap.size() == k && heap.front().first <= ring * mCellSize) {
+                    break;
+                }
+            }
+        }
+
+        std::sort_heap(heap.begin(), heap.end(), compareNeighbors);
+        nbh.reserve(heap.size());
+        for(unsigned int i=0; i<heap.size(); ++i) {
+            nbh.push_back(*heap[i].second);
+        }
+    }
+
+    virtual void nearestR(const T& data, double radius, std::vector<T>& nbh) const {
+        nbh.clear();
+        if(mSize == 0 || radius < 0) {
+            return;
+        }
+
+        std::vector<Neighbor> neighbors;
+        Entry query(data);
+        // Clamped before the conversion, the radius may be huge.
+        int min_x = (int)std::max<double>(mMinCellX, std::floor((query.mX - radius) / mCellSize));
+        int max_x = (int)std::min<double>(mMaxCellX, std::floor((query.mX + radius) / mCellSize));
+        int min_y = (int)std::max<double>(mMinCellY, std::floor((query.mY - radius) / mCellSize));
+        int max_y = (int)std::min<double>(mMaxCellY, std::floor((query.mY + radius) / mCellSize));
+        double num_cells = (max_x - min_x + 1.0) * (max_y - min_y + 1.0);
+
+        if(max_x < min_x || max_y < min_y) {
+            return;
+        } else if(num_cells > mBuckets.size()) {
+            // Visiting all buckets is cheaper than looking up the cells.
+            typename BucketMap::const_iterator it = mBuckets.begin();
+            for(; it != mBuckets.end(); ++it) {
+                addCandidates(data, it->second, radius, neighbors);
+            }
+        } else {
+            for(int x=min_x; x<=max_x; ++x) {
+                for(int y=min_y; y<=max_y; ++y) {
+                    typename BucketMap::const_iterator it = mBuckets.find(getKey(x, y));
+                    if(it != mBuckets.end()) {
+                        addCandidates(data, it->second, radius, neighbors);
+                    }
+                }
+            }
+        }
+
+        std::sort(neighbors.begin(), neighbors.end(), compareNeighbors);
+        nbh.reserve(neighbors.size());
+        for(unsigned int i=0; i<neighbors.size(); ++i) {
+            nbh.push_back(*neighbors[i].second);
+        }
+    }
+
+    virtual std::size_t size() const {
+        return mSize;
+    }
+
+    virtual void list(std::vector<T>& data) const {
+        data.clear();
+        data.reserve(mSize);
+        typename BucketMap::const_iterator it = mBuckets.begin();
+        for(; it != mBuckets.end(); ++it) {
+            for(unsigned int i=0; i<it->second.size(); ++i) {
+                data.push_back(it->second[i].mData);
+            }
+        }
+    }
+
+    inline double getCellSize() const {
+        return mCellSize;
+    }
+
+ private:
+    struct Entry {
+        Entry(const T& data) : mData(data), mX(0), mY(0) {
+            Position::get(data, mX, mY);
+        }
+        T mData;
+        double mX;
+        double mY;
+    };
+
+    typedef boost::unordered_map<boost::uint64_t, std::vector<Entry> > BucketMap;
+    // Distance and element.
+    typedef std::pair<double, const T*> Neighbor;
+
+    BucketMap mBuckets;
+    double mCellSize;
+    size_t mSize;
+    // Number of elements for the next bucket size adaption.
+    size_t mRebuildSize;
+    // Bounding boxes of the used cells and of the positions.
+    int mMinCellX, mMaxCellX, mMinCellY, mMaxCellY;
+    double mMinX, mMaxX, mMinY, mMaxY;
+
+    static bool compareNeighbors(const Neighbor& n1, const Neighbor& n2) {
+        return n1.first < n2.first;
+    }
+
+    inline int getCell(double pos) const {
+        return (int)std::floor(pos / mCellSize);
+    }
+
+    static inline boost::uint64_t getKey(int cell_x, int cell_y) {
+        return ((boost::uint64_t)(boost::uint32_t)cell_x << 32) | (boost::uint32_t)cell_y;
+    }
+
+    void insert(const Entry& entry) {
+        int cell_x = getCell(entry.mX);
+        int cell_y = getCell(entry.mY);
+        if(mMaxCellX < mMinCellX) { // First entry.
+            mMinCellX = mMaxCellX = cell_x;
+            mMinCellY = mMaxCellY = cell_y;
+        } else {
+            mMinCellX = std::min(mMinCellX, cell_x);
+            mMaxCellX = std::max(mMaxCellX, cell_x);
+            mMinCellY = std::min(mMinCellY, cell_y);
+            mMaxCellY = std::max(mMaxCellY, cell_y);
+        }
+        mBuckets[getKey(cell_x, cell_y)].push_back(entry);
+    }
+
+    /**
+     * Adapts the bucket size to the density of the elements within their
+     * bounding box and reinserts all elements.
+     */
+    void rebuild() {
+        // Keeps degenerated boxes (e.g. all states on a line) from creating tiny buckets.
+        double min_extent = std::max(mMaxX - mMinX, mMaxY - mMinY) / std::sqrt((double)mSize);
+        double width = std::max(mMaxX - mMinX, min_extent);
+        double height = std::max(mMaxY - mMinY, min_extent);
+        double cell_size = std::sqrt(width * height * ELEMENTS_PER_BUCKET / mSize);
+        if(!(cell_size > 0)) {
+            return; // All elements share the same position.
+        }
+
+        std::vector<Entry> entries;
+        entries.reserve(mSize);
+        typename BucketMap::iterator it = mBuckets.begin();
+        for(; it != mBuckets.end(); ++it) {
+            entries.insert(entries.end(), it->second.begin(), it->second.end());
+        }
+        mBuckets.clear();
+        mCellSize = cell_size;
+        mMinCellX = mMinCellY = 0;
+        mMaxCellX = mMaxCellY = -1;
+        for(unsigned int i=0; i<entries.size(); ++i) {
+            insert(entries[i]);
+        }
+    }
+
+    void visitRing(const T& data, int cell_x, int cell_y, int ring,
+            size_t k, std::vector<Neighbor>& heap) const {
+        if(ring == 0) {
+            visitCell(data, cell_x, cell_y, k, heap);
+            return;
+        }
+        for(int x=cell_x-ring; x<=cell_x+ring; ++x) {
+            visitCell(data, x, cell_y - ring, k, heap);
+            visitCell(data, x, cell_y + ring, k, heap);
+        }
+        for(int y=cell_y-ring+1; y<=cell_y+ring-1; ++y) {
+            visitCell(data, cell_x - ring, y, k, heap);
+            visitCell(data, cell_x + ring, y, k, heap);
+        }
+    }
+
+    inline void visitCell(const T& data, int cell_x, int cell_y,
+            size_t k, std::vector<Neighbor>& heap) const {
+        if(cell_x < mMinCellX || cell_x > mMaxCellX || cell_y < mMinCellY || cell_y > mMaxCellY) {
+            return;
+        }
+        typename BucketMap::const_iterator it = mBuckets.find(getKey(cell_x, cell_y));
+        if(it != mBuckets.end()) {
+            addCandidates(data, it->second, k, heap);
+        }
+    }
+
+    /**
+     * Keeps the k closest elements within the max heap.
+     */
+    void addCandidates(const T& data, const std::vector<Entry>& bucket,
+            size_t k, std::vector<Neighbor>& heap) const {
+        for(unsigned int i=0; i<bucket.size(); ++i) {
+            double dist = this->distFun_(data, bucket[i].mData);
+            if(heap.size() < k) {
+                heap.push_back(Neighbor(dist, &bucket[i].mData));
+                std::push_heap(heap.begin(), heap.end(), compareNeighbors);
+            } else if(dist < heap.front().first) {
+                std::pop_heap(heap.begin(), heap.end(), compareNeighbors);
+                heap.back() = Neighbor(dist, &bucket[i].mData);
+                std::push_heap(heap.begin(), heap.end(), compareNeighbors);
+            }
+        }
+    }
+
+    /**
+     * Collects all elements within the radius.
+     */
+    void addCandidates(const T& data, const std::vector<Entry>& bucket,
+            double radius, std::vector<Neighbor>& neighbors) const {
+        for(unsigned int i=0; i<bucket.size(); ++i) {
+            double dist = this->distFun_(data, bucket[i].mData);
+            if(dist <= radius) {
+                neighbors.push_back(Neighbor(dist, &bucket[i].mData));
+            }
+        }
+    }
+};
+
+/**
+ * Position of the elements of the OMPL planners (Motion*) within a RealVector space.
+ */
+struct RealVectorPosition {
+    template <typename T>
+    static inline void get(const T& data, double& x, double& y) {
+        const double* values = data->state->template
+                as<ompl::base::RealVectorStateSpace::StateType>()->values;
+        x = values[0];
+        y = values[1];
+    }
+};
+
+/**
+ * Position of the elements of the OMPL planners (Motion*) within a compound space
+ * which starts with a RealVector position (SHERPA, SE2).
+ */
+struct CompoundPosition {
+    template <typename T>
+    static inline void get(const T& data, double& x, double& y) {
+        const double* values = data->state->template as<ompl::base::CompoundState>()->
+                components[0]->template as<ompl::base::RealVectorStateSpace::StateType>()->values;
+        x = values[0];
+        y = values[1];
+    }
+};
+
+// Single parameter templates which can be passed to Planner::setNearestNeighbors<NN>().
+template <typename T>
+class XYGridNearestNeighbors : public GridNearestNeighbors<T, RealVectorPosition>
+{
+};
+
+template <typename T>
+class CompoundXYGridNearestNeighbors : public GridNearestNeighbors<T, CompoundPosition>
+{
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_GRID_NEAREST_NEIGHBORS_HPP_
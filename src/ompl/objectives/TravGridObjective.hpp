@@ -39,7 +39,7 @@ class TravGridObjective :  public ompl::base::StateCostIntegralObjective {
      */
     TravGridObjective(const ompl::base::SpaceInformationPtr& si, 
                         bool enable_motion_cost_interpolation,
-                        Config config) : 
+                        Config const& config) : 
                 ompl::base::StateCostIntegralObjective(si, enable_motion_cost_interpolation), 
                 mpTravGrid(NULL), 
                 mpTravData(),
@@ -50,7 +50,7 @@ class TravGridObjective :  public ompl::base::StateCostIntegralObjective {
                         bool enable_motion_cost_interpolation,
                         envire::TraversabilityGrid* trav_grid,
                         boost::shared_ptr<TravData> trav_data,
-                        Config config) : 
+                        Config const& config) : 
                 ompl::base::StateCostIntegralObjective(si, enable_motion_cost_interpolation), 
                 mpTravGrid(trav_grid), 
                 mpTravData(trav_data),
@@ -132,6 +132,38 @@ class TravGridObjective :  public ompl::base::StateCostIntegralObjective {
         return ompl::base::Cost(cost);
     }
     
+    /**
+     * Lower bound of stateCost(): Cost of the best driveable cell of the map
+     * (using the largest footprint for ENV_SHERPA).
+     */
+    double getMinStateCost() const {
+        if(mpTravGrid == NULL || mConfig.mMobility.mSpeed == 0) {
+            return 0.0;
+        }
+        
+        std::vector<bool> used_classes(256, false);
+        const uint8_t* cells = mpTravData->data();
+        for(size_t i=0; i<mpTravData->num_elements(); ++i) {
+            used_classes[cells[i]] = true;
+        }
+        double max_driveability = 0.0;
+        for(unsigned int i=0; i<used_classes.size(); ++i) {
+            if(used_classes[i]) {
+                max_driveability = std::max(max_driveability, 
+                        mpTravGrid->getTraversabilityClass(i).getDrivability());
+            }
+        }
+        if(max_driveability == 0.0) {
+            return 0.0;
+        }
+        
+        double cost = (mpTravGrid->getScaleX() / mConfig.mMobility.mSpeed) / max_driveability;
+        if(mConfig.mEnvType == ENV_SHERPA) {
+            cost /= mConfig.mNumFootprintClasses / ((double)mConfig.mNumFootprintClasses+1);
+        }
+        return cost;
+    }
+    
     ompl::base::Cost motionCost(const ompl::base::State *s1, const ompl::base::State *s2) const {
         // Uses the base motionCost() to calculate the cost to traverse from s1 to s2 
         // (mean costs of s1 and s2 and the distance (x,y,theta/2.0) between the states,
@@ -0,0 +1,112 @@
+#include "WarmStartRRTstar.hpp"
+
+#include <limits>
+
+#include <ompl/base/Goal.h>
+
+#include <base-logging/Logging.hpp>
+
+#if OMPL_VERSION_VALUE >= 1001000
+
+namespace motion_planning_libraries
+{
+
+// PUBLIC
+WarmStartRRTstar::WarmStartRRTstar(const ompl::base::SpaceInformationPtr& si) : 
+        ompl::geometric::RRTstar(si),
+        mSeedStates() {
+    setName("WarmStartRRTstar");
+}
+
+WarmStartRRTstar::~WarmStartRRTstar() {
+    freeSeedStates();
+}
+
+void WarmStartRRTstar::setSeedPath(const std::vector<ompl::base::State*>& states) {
+    freeSeedStates();
+    for(unsigned int i=0; i<states.size(); ++i) {
+        mSeedStates.push_back(si_->cloneState(states[i]));
+    }
+}
+
+ompl::base::PlannerStatus WarmStartRRTstar::solve(const ompl::base::PlannerTerminationCondition& ptc) {
+    checkValidity();
+    if(nn_ && nn_->size() == 0 && !mSeedStates.empty()) {
+        unsigned int num_added = insertSeedPath();
+        LOG_INFO("Tree has been seeded with %d of %d states of the last solution", 
+                num_added, (int)mSeedStates.size());
+        freeSeedStates();
+    }
+    return ompl::geometric::RRTstar::solve(ptc);
+}
+
+// PRIVATE
+unsigned int WarmStartRRTstar::insertSeedPath() {
+    // The start motion is created here, RRTstar::solve() only adds the remaining starts.
+    const ompl::base::State* start = pis_.nextStart();
+    if(start == NULL) {
+        return 0;
+    }
+    Motion* start_motion = new Motion(si_);
+    si_->copyState(start_motion->state, start);
+    start_motion->cost = opt_->identityCost();
+    nn_->add(start_motion);
+    startMotions_.push_back(start_motion);
+    
+    // Connects the (possibly moved) start to the closest reachable seed state.
+    int first_index = -1;
+    double min_dist = std::numeric_limits<double>::max();
+    for(unsigned int i=0; i<mSeedStates.size(); ++i) {
+        double dist = si_->distance(start, mSeedStates[i]);
+        if(dist < min_dist && si_->isValid(mSeedStates[i]) && 
+                si_->checkMotion(start, mSeedStates[i])) {
+            min_dist = dist;
+            first_index = i;
+        }
+    }
+    if(first_index < 0) {
+        return 0;
+    }
+    
+    // Invalid states and motions are skipped, the next reachable state is connected.
+    Motion* last_motion = start_motion;
+    unsigned int num_added = 0;
+    for(unsigned int i=first_index; i<mSeedStates.size(); ++i) {
+        if(si_->equalStates(last_motion->state, mSeedStates[i]) ||
+                !si_->isValid(mSeedStates[i]) ||
+                !si_->checkMotion(last_motion->state, mSeedStates[i])) {
+            continue;
+        }
+        Motion* motion = new Motion(si_);
+        si_->copyState(motion->state, mSeedStates[i]);
+        motion->parent = last_motion;
+        motion->incCost = opt_->motionCost(last_motion->state, motion->state);
+        motion->cost = opt_->combineCosts(last_motion->cost, motion->incCost);
+        last_motion->children.push_back(motion);
+        nn_->add(motion);
+        last_motion = motion;
+        num_added++;
+    }
+    
+    // A seed which still reaches the goal bounds the costs of the search.
+    double dist_to_goal = 0.0;
+    if(num_added > 0 && pdef_->getGoal()->isSatisfied(last_motion->state, &dist_to_goal)) {
+        last_motion->inGoal = true;
+        goalMotions_.push_back(last_motion);
+        bestGoalMotion_ = last_motion;
+        bestCost_ = last_motion->cost;
+        LOG_INFO("Seeded solution with cost %4.2f", bestCost_.value());
+    }
+    return num_added;
+}
+
+void WarmStartRRTstar::freeSeedStates() {
+    for(unsigned int i=0; i<mSeedStates.size(); ++i) {
+        si_->freeState(mSeedStates[i]);
+    }
+    mSeedStates.clear();
+}
+
+} // end namespace motion_planning_libraries
+
+#endif // OMPL_VERSION_VALUE >= 1001000
@@ -0,0 +1,57 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_WARM_START_RRTSTAR_HPP_
+#define _MOTION_PLANNING_LIBRARIES_WARM_START_RRTSTAR_HPP_
+
+#include <vector>
+
+#include <ompl/config.h>
+#include <ompl/geometric/planners/rrt/RRTstar.h>
+
+// Writes the tree members of RRT* (nn_, startMotions_, goalMotions_, 
+// bestGoalMotion_ and bestCost_) which are available since OMPL 1.1.
+#if OMPL_VERSION_VALUE >= 1001000
+
+namespace motion_planning_libraries
+{
+
+/**
+ * RRT* which inserts a seed path (usually the solution of the last planning run)
+ * into its empty tree before the search starts. If the seeded branch reaches the
+ * goal, the planner begins with a finite cost bound and only tries to 
+ * improve it (pruning, informed sampling).
+ * Invalid parts of the seed are repaired by skipping the invalid states and 
+ * connecting the next reachable state. The new start is connected to the closest
+ * reachable seed state, so small start changes keep the rest of the path.
+ */
+class WarmStartRRTstar : public ompl::geometric::RRTstar
+{
+ public:
+    WarmStartRRTstar(const ompl::base::SpaceInformationPtr& si);
+    virtual ~WarmStartRRTstar();
+    
+    /**
+     * Copies the states, they are inserted within the next solve() call 
+     * which starts with an empty tree (e.g. after clear()).
+     */
+    void setSeedPath(const std::vector<ompl::base::State*>& states);
+    
+    using ompl::geometric::RRTstar::solve;
+    
+    virtual ompl::base::PlannerStatus solve(const ompl::base::PlannerTerminationCondition& ptc);
+    
+ private:
+    std::vector<ompl::base::State*> mSeedStates;
+    
+    /**
+     * Adds the start and the repaired seed path to the tree.
+     * Returns the number of added seed states.
+     */
+    unsigned int insertSeedPath();
+    
+    void freeSeedStates();
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // OMPL_VERSION_VALUE >= 1001000
+
+#endif // _MOTION_PLANNING_LIBRARIES_WARM_START_RRTSTAR_HPP_
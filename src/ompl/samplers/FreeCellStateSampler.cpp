@@ -0,0 +1,237 @@
+#include "FreeCellStateSampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/base/spaces/SE2StateSpace.h>
+
+#include <base/Logging.hpp>
+
+#include <motion_planning_libraries/Helpers.hpp>
+#include <motion_planning_libraries/Parallel.hpp>
+#include <motion_planning_libraries/State.hpp>
+#include <motion_planning_libraries/ompl/spaces/SherpaStateSpace.hpp>
+
+namespace motion_planning_libraries
+{
+
+// PUBLIC
+FreeCellTable::FreeCellTable() : mCellsX(),
+        mCellsY(),
+        mProbabilities(),
+        mAliases(),
+        mMaxFootprintClasses() {
+}
+
+bool FreeCellTable::create(const ompl::base::SpaceInformationPtr& si, 
+        envire::TraversabilityGrid* trav_grid, 
+        boost::shared_ptr<TravData> grid_data,
+        Config const& config,
+        boost::shared_ptr<const PreprocessedMap> preprocessed_map) {
+    
+    // Valid cells and their weights per row, merged in row order.
+    std::vector< std::vector< std::pair<int, double> > > rows(trav_grid->getCellSizeY());
+    ParallelFor parallel_for(config.mNumThreads);
+    parallel_for.run(rows.size(), boost::bind(&FreeCellTable::checkRow, 
+            si, trav_grid, grid_data, config.mEnvType, _1, &rows));
+    
+    mCellsX.clear();
+    mCellsY.clear();
+    std::vector<double> weights;
+    for(unsigned int y=0; y<rows.size(); ++y) {
+        for(unsigned int i=0; i<rows[y].size(); ++i) {
+            mCellsX.push_back(rows[y][i].first);
+            mCellsY.push_back(y);
+            weights.push_back(rows[y][i].second);
+        }
+    }
+    createAliasTable(weights);
+    if(config.mEnvType == ENV_SHERPA) {
+        createMaxFootprintClasses(trav_grid, grid_data, config, preprocessed_map);
+    }
+    
+    LOG_INFO("%d of %d cells can be sampled", (int)mCellsX.size(), 
+            (int)(trav_grid->getCellSizeX() * trav_grid->getCellSizeY()));
+    return !mCellsX.empty();
+}
+
+// PRIVATE
+void FreeCellTable::checkRow(const ompl::base::SpaceInformationPtr& si,
+        envire::TraversabilityGrid* trav_grid, 
+        boost::shared_ptr<TravData> grid_data,
+        enum EnvType env_type, size_t y, 
+        std::vector< std::vector< std::pair<int, double> > >* rows) {
+    
+    ompl::base::State* state = si->allocState();
+    if(env_type == ENV_SHERPA) {
+        // Smallest footprint.
+        state->as<SherpaStateSpace::StateType>()->setFootprintClass(0);
+    } else if(env_type == ENV_XYTHETA) {
+        state->as<ompl::base::SE2StateSpace::StateType>()->setYaw(0.0);
+    }
+    
+    std::vector< std::pair<int, double> >& row = (*rows)[y];
+    for(unsigned int x=0; x<trav_grid->getCellSizeX(); ++x) {
+        double driveability = trav_grid->getTraversabilityClass(
+                (*grid_data)[y][x]).getDrivability();
+        if(driveability <= 0) {
+            continue;
+        }
+        FreeCellStateSampler::setPosition(env_type, state, x + 0.5, y + 0.5);
+        if(si->isValid(state)) {
+            row.push_back(std::pair<int, double>(x, driveability));
+        }
+    }
+    si->freeState(state);
+}
+
+void FreeCellTable::createAliasTable(const std::vector<double>& weights) {
+    size_t n = weights.size();
+    mProbabilities.assign(n, 1.0);
+    mAliases.resize(n);
+    if(n == 0) {
+        return;
+    }
+    
+    double sum = 0.0;
+    for(unsigned int i=0; i<n; ++i) {
+        sum += weights[i];
+    }
+    
+    // Scaled to a mean of 1, splits into the cells below and above the mean.
+    std::vector<double> scaled(n);
+    std::vector<unsigned int> small;
+    std::vector<unsigned int> large;
+    for(unsigned int i=0; i<n; ++i) {
+        mAliases[i] = i;
+        scaled[i] = weights[i] * n / sum;
+        if(scaled[i] < 1.0) {
+            small.push_back(i);
+        } else {
+            large.push_back(i);
+        }
+    }
+    
+    // Each small cell is filled up by a large one.
+    while(!small.empty() && !large.empty()) {
+        unsigned int s = small.back();
+        small.pop_back();
+        unsigned int l = large.back();
+        mProbabilities[s] = scaled[s];
+        mAliases[s] = l;
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        if(scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Remaining cells (numerical inaccuracies) keep a probability of 1.
+}
+
+void FreeCellTable::createMaxFootprintClasses(envire::TraversabilityGrid* trav_grid, 
+        boost::shared_ptr<TravData> grid_data,
+        Config const& config,
+        boost::shared_ptr<const PreprocessedMap> preprocessed_map) {
+    // Footprint radius in cells as used by the validator.
+    double min_scale = std::min(trav_grid->getScaleX(), trav_grid->getScaleY());
+    std::vector<double> radii;
+    for(unsigned int i=0; i<config.mNumFootprintClasses; ++i) {
+        State state;
+        if(config.mNumFootprintClasses > 1) {
+            state.setFootprintRadius(config.mFootprintRadiusMinMax.first,
+                    config.mFootprintRadiusMinMax.second, config.mNumFootprintClasses, i);
+        } else {
+            state.setFootprintRadius(config.mFootprintRadiusMinMax.first);
+        }
+        radii.push_back(std::ceil(state.getFootprintRadius() / min_scale));
+    }
+    
+    // The distance field does not depend on the footprint, so it can be shared.
+    boost::shared_ptr<const std::vector<float> > distances;
+    if(preprocessed_map) {
+        distances = preprocessed_map->getObstacleDistances();
+    } else {
+        distances.reset(new std::vector<float>(
+                GridCalculations::createObstacleDistances(trav_grid, grid_data)));
+    }
+    mMaxFootprintClasses.assign(mCellsX.size(), 0);
+    for(unsigned int i=0; i<mCellsX.size(); ++i) {
+        float dist = (*distances)[mCellsY[i] * trav_grid->getCellSizeX() + mCellsX[i]];
+        // The footprint cells are truncated, so they may lie up to sqrt(2) cells further away.
+        unsigned int max_class = 0;
+        while(max_class + 1 < radii.size() && radii[max_class + 1] + M_SQRT2 < dist) {
+            max_class++;
+        }
+        mMaxFootprintClasses[i] = max_class;
+    }
+}
+
+// PUBLIC
+FreeCellStateSampler::FreeCellStateSampler(const ompl::base::StateSpace* space, 
+        enum EnvType env_type,
+        boost::shared_ptr<const FreeCellTable> free_cells) : 
+        ompl::base::StateSampler(space),
+        mEnvType(env_type),
+        mpFreeCells(free_cells),
+        mpDefaultSampler(space->allocDefaultStateSampler()) {
+}
+
+void FreeCellStateSampler::sampleUniform(ompl::base::State* state) {
+    unsigned int cell = mpFreeCells->sampleCell(rng_);
+    setPosition(mEnvType, state, 
+            mpFreeCells->getCellX(cell) + rng_.uniform01(), 
+            mpFreeCells->getCellY(cell) + rng_.uniform01());
+    
+    if(mEnvType == ENV_XYTHETA) {
+        state->as<ompl::base::SE2StateSpace::StateType>()->setYaw(rng_.uniformReal(-M_PI, M_PI));
+    } else if(mEnvType == ENV_SHERPA) {
+        int max_class = mpFreeCells->getMaxFootprintClass(cell);
+        state->as<SherpaStateSpace::StateType>()->setFootprintClass(
+                std::max(rng_.uniformInt(0, max_class), rng_.uniformInt(0, max_class)));
+    }
+}
+
+void FreeCellStateSampler::sampleUniformNear(ompl::base::State* state, 
+        const ompl::base::State* near, const double distance) {
+    mpDefaultSampler->sampleUniformNear(state, near, distance);
+}
+
+void FreeCellStateSampler::sampleGaussian(ompl::base::State* state, 
+        const ompl::base::State* mean, const double std_dev) {
+    mpDefaultSampler->sampleGaussian(state, mean, std_dev);
+}
+
+ompl::base::StateSamplerPtr FreeCellStateSampler::alloc(const ompl::base::StateSpace* space,
+        enum EnvType env_type,
+        boost::shared_ptr<const FreeCellTable> free_cells) {
+    return ompl::base::StateSamplerPtr(new FreeCellStateSampler(space, env_type, free_cells));
+}
+
+void FreeCellStateSampler::setPosition(enum EnvType env_type, ompl::base::State* state, 
+        double x, double y) {
+    switch(env_type) {
+        case ENV_XY: {
+            double* values = state->as<ompl::base::RealVectorStateSpace::StateType>()->values;
+            values[0] = x;
+            values[1] = y;
+            break;
+        }
+        case ENV_XYTHETA: {
+            state->as<ompl::base::SE2StateSpace::StateType>()->setXY(x, y);
+            break;
+        }
+        case ENV_SHERPA: {
+            state->as<SherpaStateSpace::StateType>()->setXY(x, y);
+            break;
+        }
+        default: {
+            throw std::runtime_error("FreeCellStateSampler received an unknown environment");
+        }
+    }
+}
+
+} // end namespace motion_planning_libraries
@@ -0,0 +1,152 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_FREE_CELL_STATE_SAMPLER_HPP_
+#define _MOTION_PLANNING_LIBRARIES_FREE_CELL_STATE_SAMPLER_HPP_
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ompl/base/SpaceInformation.h>
+#include <ompl/base/StateSampler.h>
+#include <ompl/util/RandomNumbers.h>
+
+#include <envire/maps/TraversabilityGrid.hpp>
+
+#include <motion_planning_libraries/Config.hpp>
+#include <motion_planning_libraries/PreprocessedMap.hpp>
+
+namespace motion_planning_libraries
+{
+
+typedef envire::TraversabilityGrid::ArrayType TravData;
+
+/**
+ * Alias table (Vose's method) over the valid cells of the traversability grid,
+ * weighted by their driveability. A cell is drawn in O(1).
+ * The validity is checked once for the center of each cell, the validator
+ * only regards the cell of a state, so all states within a valid cell are valid.
+ * For ENV_SHERPA the largest footprint class which fits into each cell is 
+ * stored as well, derived from the distance to the closest obstacle.
+ */
+class FreeCellTable
+{
+ public:
+    FreeCellTable();
+    
+    /**
+     * Checks all cells with the validator of the space information, the 
+     * smallest footprint class is used for ENV_SHERPA. The rows are processed 
+     * in parallel (mNumThreads). Returns false if there is no valid cell.
+     * If a preprocessed map is passed its obstacle distances are used.
+     */
+    bool create(const ompl::base::SpaceInformationPtr& si, 
+            envire::TraversabilityGrid* trav_grid, 
+            boost::shared_ptr<TravData> grid_data,
+            Config const& config,
+            boost::shared_ptr<const PreprocessedMap> preprocessed_map = 
+                    boost::shared_ptr<const PreprocessedMap>());
+    
+    /**
+     * Returns the index of a random cell, see getCellX() and getCellY().
+     */
+    inline unsigned int sampleCell(ompl::RNG& rng) const {
+        unsigned int i = rng.uniformInt(0, mProbabilities.size() - 1);
+        return rng.uniform01() < mProbabilities[i] ? i : mAliases[i];
+    }
+    
+    inline int getCellX(unsigned int cell) const {
+        return mCellsX[cell];
+    }
+    
+    inline int getCellY(unsigned int cell) const {
+        return mCellsY[cell];
+    }
+    
+    inline size_t getNumCells() const {
+        return mCellsX.size();
+    }
+    
+    /**
+     * ENV_SHERPA: Largest footprint class which is valid within the cell.
+     */
+    inline unsigned int getMaxFootprintClass(unsigned int cell) const {
+        return mMaxFootprintClasses[cell];
+    }
+    
+ private:
+    std::vector<int> mCellsX;
+    std::vector<int> mCellsY;
+    // Probability to keep the drawn cell instead of using its alias.
+    std::vector<double> mProbabilities;
+    std::vector<unsigned int> mAliases;
+    std::vector<unsigned char> mMaxFootprintClasses;
+    
+    /**
+     * Checks the cells of one row, used by the parallel creation.
+     */
+    static void checkRow(const ompl::base::SpaceInformationPtr& si,
+            envire::TraversabilityGrid* trav_grid, 
+            boost::shared_ptr<TravData> grid_data,
+            enum EnvType env_type, size_t y, 
+            std::vector< std::vector< std::pair<int, double> > >* rows);
+    
+    /**
+     * Creates the alias table for the passed weights.
+     */
+    void createAliasTable(const std::vector<double>& weights);
+    
+    /**
+     * ENV_SHERPA: Assigns the largest footprint class to each cell whose footprint
+     * does not reach the closest obstacle, at least the smallest class.
+     */
+    void createMaxFootprintClasses(envire::TraversabilityGrid* trav_grid, 
+            boost::shared_ptr<TravData> grid_data,
+            Config const& config,
+            boost::shared_ptr<const PreprocessedMap> preprocessed_map);
+};
+
+/**
+ * Draws the position of uniform samples from a FreeCellTable with a random offset
+ * within the cell, so every sample is valid without any rejection. 
+ * The yaw is sampled uniformly. The SHERPA footprint class is sampled from the
+ * classes which fit into the cell, biased towards the larger (cheaper) classes:
+ * The maximum of two uniform draws is used, so class c is chosen with a 
+ * probability proportional to 2c+1.
+ * Samples near a state and gaussian samples are passed to the default sampler 
+ * of the space.
+ */
+class FreeCellStateSampler : public ompl::base::StateSampler
+{
+ public:
+    FreeCellStateSampler(const ompl::base::StateSpace* space, 
+            enum EnvType env_type,
+            boost::shared_ptr<const FreeCellTable> free_cells);
+    
+    virtual void sampleUniform(ompl::base::State* state);
+    
+    virtual void sampleUniformNear(ompl::base::State* state, 
+            const ompl::base::State* near, const double distance);
+    
+    virtual void sampleGaussian(ompl::base::State* state, 
+            const ompl::base::State* mean, const double std_dev);
+    
+    /**
+     * Can be passed to StateSpace::setStateSamplerAllocator() using boost::bind.
+     */
+    static ompl::base::StateSamplerPtr alloc(const ompl::base::StateSpace* space,
+            enum EnvType env_type,
+            boost::shared_ptr<const FreeCellTable> free_cells);
+    
+    /**
+     * Sets the grid position of a XY, SE2 or SHERPA state.
+     */
+    static void setPosition(enum EnvType env_type, ompl::base::State* state, double x, double y);
+    
+ private:
+    enum EnvType mEnvType;
+    boost::shared_ptr<const FreeCellTable> mpFreeCells;
+    ompl::base::StateSamplerPtr mpDefaultSampler;
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_FREE_CELL_STATE_SAMPLER_HPP_
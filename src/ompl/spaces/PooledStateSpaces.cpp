@@ -0,0 +1,37 @@
+#include "PooledStateSpaces.hpp"
+
+namespace motion_planning_libraries
+{
+
+namespace {
+typedef ompl::base::RealVectorStateSpace::StateType RealVectorStateType;
+
+// Layout: StateType | values[dim]
+inline size_t valuesOffset() {
+    return StatePool::align(sizeof(RealVectorStateType));
+}
+}
+
+// PUBLIC
+PooledRealVectorStateSpace::PooledRealVectorStateSpace(unsigned int dim) : 
+        ompl::base::RealVectorStateSpace(dim),
+        PooledStates(valuesOffset() + dim * sizeof(double)) {
+}
+
+PooledRealVectorStateSpace::~PooledRealVectorStateSpace() {
+}
+
+ompl::base::State* PooledRealVectorStateSpace::allocState() const {
+    char* block = static_cast<char*>(mStatePool.allocate());
+    RealVectorStateType* state = new (block) RealVectorStateType();
+    state->values = reinterpret_cast<double*>(block + valuesOffset());
+    return state;
+}
+
+void PooledRealVectorStateSpace::freeState(ompl::base::State* state) const {
+    RealVectorStateType* rv_state = static_cast<RealVectorStateType*>(state);
+    rv_state->~RealVectorStateType();
+    mStatePool.deallocate(rv_state);
+}
+
+} // end namespace motion_planning_libraries
@@ -0,0 +1,100 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_POOLED_STATE_SPACES_HPP_
+#define _MOTION_PLANNING_LIBRARIES_POOLED_STATE_SPACES_HPP_
+
+#include <new>
+
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/base/spaces/SE2StateSpace.h>
+#include <ompl/base/spaces/SO2StateSpace.h>
+
+#include <motion_planning_libraries/ompl/spaces/StatePool.hpp>
+
+namespace motion_planning_libraries
+{
+
+/**
+ * RealVectorStateSpace which places each state and its values within one 
+ * block of a StatePool. The dimension must not be changed after construction 
+ * (addDimension()).
+ */
+class PooledRealVectorStateSpace : public ompl::base::RealVectorStateSpace, public PooledStates
+{
+ public:
+    PooledRealVectorStateSpace(unsigned int dim = 0);
+    virtual ~PooledRealVectorStateSpace();
+    
+    virtual ompl::base::State* allocState() const;
+    virtual void freeState(ompl::base::State* state) const;
+};
+
+/**
+ * SE2StateSpace or one of its subclasses (DubinsStateSpace, ReedsSheppStateSpace)
+ * which places each state and its components (position, yaw) within one 
+ * block of a StatePool.
+ */
+template <class SE2Space = ompl::base::SE2StateSpace>
+class PooledSE2StateSpace : public SE2Space, public PooledStates
+{
+ public:
+    typedef ompl::base::SE2StateSpace::StateType StateType;
+    typedef ompl::base::RealVectorStateSpace::StateType PositionStateType;
+    typedef ompl::base::SO2StateSpace::StateType YawStateType;
+    
+    PooledSE2StateSpace() : SE2Space(), PooledStates(getStateBlockSize()) {
+    }
+    
+    /**
+     * For DubinsStateSpace and ReedsSheppStateSpace.
+     */
+    explicit PooledSE2StateSpace(double turning_radius) : SE2Space(turning_radius), 
+            PooledStates(getStateBlockSize()) {
+    }
+    
+    virtual ~PooledSE2StateSpace() {
+    }
+    
+    virtual ompl::base::State* allocState() const {
+        char* block = static_cast<char*>(mStatePool.allocate());
+        StateType* state = new (block) StateType();
+        state->components = reinterpret_cast<ompl::base::State**>(block + componentsOffset());
+        PositionStateType* position = new (block + positionOffset()) PositionStateType();
+        position->values = reinterpret_cast<double*>(block + valuesOffset());
+        state->components[0] = position;
+        state->components[1] = new (block + yawOffset()) YawStateType();
+        return state;
+    }
+    
+    virtual void freeState(ompl::base::State* state) const {
+        StateType* se2_state = static_cast<StateType*>(state);
+        se2_state->components[0]->template as<PositionStateType>()->~PositionStateType();
+        se2_state->components[1]->template as<YawStateType>()->~YawStateType();
+        se2_state->~StateType();
+        mStatePool.deallocate(se2_state);
+    }
+    
+ private:
+    // Layout: StateType | components[2] | position | position values[2] | yaw
+    static size_t componentsOffset() {
+        return StatePool::align(sizeof(StateType));
+    }
+    
+    static size_t positionOffset() {
+        return componentsOffset() + StatePool::align(2 * sizeof(ompl::base::State*));
+    }
+    
+    static size_t valuesOffset() {
+        return positionOffset() + StatePool::align(sizeof(PositionStateType));
+    }
+    
+    static size_t yawOffset() {
+        return valuesOffset() + StatePool::align(2 * sizeof(double));
+    }
+    
+    static size_t getStateBlockSize() {
+        return yawOffset() + sizeof(YawStateType);
+    }
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_POOLED_STATE_SPACES_HPP_
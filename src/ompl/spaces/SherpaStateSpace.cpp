@@ -3,19 +3,64 @@
 #include "ompl/base/spaces/SE2StateSpace.h"
 #include "ompl/tools/config/MagicConstants.h"
 #include <cstring>
+#include <new>
 
 namespace motion_planning_libraries {
 
+namespace {
+typedef ompl::base::RealVectorStateSpace::StateType PositionStateType;
+typedef ompl::base::DiscreteStateSpace::StateType FootprintClassStateType;
+
+// Layout of a pooled state: 
+// StateType | components[2] | position | position values[2] | footprint class
+inline size_t componentsOffset() {
+    return StatePool::align(sizeof(SherpaStateSpace::StateType));
+}
+
+inline size_t positionOffset() {
+    return componentsOffset() + StatePool::align(2 * sizeof(ompl::base::State*));
+}
+
+inline size_t valuesOffset() {
+    return positionOffset() + StatePool::align(sizeof(PositionStateType));
+}
+
+inline size_t footprintClassOffset() {
+    return valuesOffset() + StatePool::align(2 * sizeof(double));
+}
+}
+
 ompl::base::State* SherpaStateSpace::allocState(void) const
 {
-    StateType *state = new StateType();
-    allocStateComponents(state);
+    if(!mConfig.mOmplPooledStates) {
+        StateType *state = new StateType();
+        allocStateComponents(state);
+        return state;
+    }
+    
+    char* block = static_cast<char*>(mStatePool.allocate());
+    StateType* state = new (block) StateType();
+    state->components = reinterpret_cast<ompl::base::State**>(block + componentsOffset());
+    PositionStateType* position = new (block + positionOffset()) PositionStateType();
+    position->values = reinterpret_cast<double*>(block + valuesOffset());
+    state->components[0] = position;
+    state->components[1] = new (block + footprintClassOffset()) FootprintClassStateType();
     return state;
 }
 
 void SherpaStateSpace::freeState(ompl::base::State *state) const
 {
-    ompl::base::CompoundStateSpace::freeState(state);
+    if(!mConfig.mOmplPooledStates) {
+        ompl::base::CompoundStateSpace::freeState(state);
+        return;
+    }
+    
+    // The components do not own any memory, the whole block is returned to the pool.
+    StateType* sherpa_state = static_cast<StateType*>(state);
+    sherpa_state->components[0]->as<PositionStateType>()->~PositionStateType();
+    sherpa_state->components[1]->as<FootprintClassStateType>()->~FootprintClassStateType();
+    sherpa_state->~StateType();
+    mStatePool.deallocate(sherpa_state);
 }
 
 void SherpaStateSpace::registerProjections(void)
@@ -51,4 +96,10 @@ void SherpaStateSpace::registerProjections(void)
     registerDefaultProjection(ompl::base::ProjectionEvaluatorPtr(dynamic_cast<ompl::base::ProjectionEvaluator*>(new SherpaDefaultProjection(this))));
 }
 
+// PRIVATE
+size_t SherpaStateSpace::getStateBlockSize()
+{
+    return footprintClassOffset() + sizeof(FootprintClassStateType);
+}
+
 } // end namespace motion_planning_libraries
@@ -7,10 +7,15 @@
 #include <ompl/base/spaces/DiscreteStateSpace.h>
 
 #include <motion_planning_libraries/Config.hpp>
+#include <motion_planning_libraries/ompl/spaces/StatePool.hpp>
 
 namespace motion_planning_libraries {
 
-class SherpaStateSpace : public ompl::base::CompoundStateSpace
+/**
+ * If mOmplPooledStates is set, each state is placed together with its 
+ * components within one block of the StatePool.
+ */
+class SherpaStateSpace : public ompl::base::CompoundStateSpace, public PooledStates
 {
 protected: 
     Config mConfig;
@@ -67,7 +72,8 @@ public:
         }
     };
 
-    SherpaStateSpace(Config config = Config()) : ompl::base::CompoundStateSpace(),
+    SherpaStateSpace(Config const& config = Config()) : ompl::base::CompoundStateSpace(),
+            PooledStates(getStateBlockSize()),
             mConfig(config)
     {
         setName("Sherpa" + getName());
@@ -99,7 +105,13 @@ public:
     virtual void freeState(ompl::base::State *state) const;
 
     virtual void registerProjections(void);
-
+    
+ private:
+    /**
+     * Size of the block which contains the state, the component array 
+     * and the components.
+     */
+    static size_t getStateBlockSize();
 };
 
 } // end namespace motion_planning_libraries
@@ -0,0 +1,171 @@
+#include "StatePool.hpp"
+
+#include <algorithm>
+#include <map>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace motion_planning_libraries
+{
+
+const size_t StatePool::DEFAULT_BLOCKS_PER_ARENA;
+const size_t StatePool::NUM_SUB_POOLS;
+
+namespace {
+// Size of the sub-pool id in front of each block.
+inline size_t headerSize() {
+    return StatePool::align(sizeof(size_t));
+}
+}
+
+// PUBLIC
+StatePool::StatePool(size_t block_size, size_t blocks_per_arena) :
+        mBlockSize(0),
+        mSlotSize(0),
+        mBlocksPerArena(std::max<size_t>(1, blocks_per_arena)),
+        mSubPools() {
+    // Each block has to be able to store the free list pointer and has
+    // to keep the following blocks aligned.
+    mBlockSize = align(std::max(block_size, sizeof(FreeBlock)));
+    mSlotSize = headerSize() + mBlockSize;
+    for(size_t i=0; i<NUM_SUB_POOLS; ++i) {
+        mSubPools.push_back(new SubPool());
+    }
+}
+
+StatePool::~StatePool() {
+    for(unsigned int i=0; i<mSubPools.size(); ++i) {
+        for(unsigned int a=0; a<mSubPools[i]->mArenas.size(); ++a) {
+            delete[] mSubPools[i]->mArenas[a];
+        }
+        delete mSubPools[i];
+    }
+}
+
+void* StatePool::allocate() {
+    size_t sub_pool_id = getThreadSubPoolId();
+    SubPool& sub_pool = *mSubPools[sub_pool_id];
+    boost::lock_guard<boost::mutex> lock(sub_pool.mMutex);
+    if(sub_pool.mpFreeList == NULL) {
+        addArena(sub_pool_id);
+    }
+    FreeBlock* block = sub_pool.mpFreeList;
+    sub_pool.mpFreeList = block->mpNext;
+    sub_pool.mNumAllocatedBlocks++;
+    return block;
+}
+
+void StatePool::deallocate(void* block) {
+    if(block == NULL) {
+        return;
+    }
+    // Blocks freed by another thread (e.g. clearing the planner) go back
+    // to their own sub-pool.
+    size_t sub_pool_id = *reinterpret_cast<size_t*>(static_cast<char*>(block) - headerSize());
+    SubPool& sub_pool = *mSubPools[sub_pool_id];
+    boost::lock_guard<boost::mutex> lock(sub_pool.mMutex);
+    FreeBlock* free_block = static_cast<FreeBlock*>(block);
+    free_block->mpNext = sub_pool.mpFreeList;
+    sub_pool.mpFreeList = free_block;
+    sub_pool.mNumAllocatedBlocks--;
+}
+
+size_t StatePool::releaseUnusedArenas() {
+    size_t num_released = 0;
+    for(unsigned int i=0; i<mSubPools.size(); ++i) {
+        num_released += releaseUnusedArenas(*mSubPools[i]);
+    }
+    return num_released;
+}
+
+size_t StatePool::getNumAllocatedBlocks() const {
+    size_t num_blocks = 0;
+    for(unsigned int i=0; i<mSubPools.size(); ++i) {
+        boost::lock_guard<boost::mutex> lock(mSubPools[i]->mMutex);
+        num_blocks += mSubPools[i]->mNumAllocatedBlocks;
+    }
+    return num_blocks;
+}
+
+size_t StatePool::getNumArenas() const {
+    size_t num_arenas = 0;
+    for(unsigned int i=0; i<mSubPools.size(); ++i) {
+        boost::lock_guard<boost::mutex> lock(mSubPools[i]->mMutex);
+        num_arenas += mSubPools[i]->mArenas.size();
+    }
+    return num_arenas;
+}
+
+// PRIVATE
+void StatePool::addArena(size_t sub_pool_id) {
+    SubPool& sub_pool = *mSubPools[sub_pool_id];
+    char* arena = new char[mSlotSize * mBlocksPerArena];
+    sub_pool.mArenas.push_back(arena);
+    // Pushed in reverse order, so the blocks are handed out in memory order.
+    for(size_t i=mBlocksPerArena; i>0; --i) {
+        char* slot = arena + (i-1) * mSlotSize;
+        *reinterpret_cast<size_t*>(slot) = sub_pool_id;
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(slot + headerSize());
+        block->mpNext = sub_pool.mpFreeList;
+        sub_pool.mpFreeList = block;
+    }
+}
+
+size_t StatePool::releaseUnusedArenas(SubPool& sub_pool) {
+    boost::lock_guard<boost::mutex> lock(sub_pool.mMutex);
+    if(sub_pool.mArenas.empty()) {
+        return 0;
+    }
+    
+    // Counts the free blocks of each arena, the arenas are found by their start address.
+    std::map<char*, size_t> arena_ids;
+    for(unsigned int i=0; i<sub_pool.mArenas.size(); ++i) {
+        arena_ids[sub_pool.mArenas[i]] = i;
+    }
+    std::vector<size_t> num_free_blocks(sub_pool.mArenas.size(), 0);
+    std::vector<size_t> block_arena_ids;
+    for(FreeBlock* block = sub_pool.mpFreeList; block != NULL; block = block->mpNext) {
+        std::map<char*, size_t>::iterator it = arena_ids.upper_bound((char*)block);
+        --it; // The block lies within the arena with the next lower start address.
+        num_free_blocks[it->second]++;
+        block_arena_ids.push_back(it->second);
+    }
+    
+    // Rebuilds the free list (same order) without the blocks of the released arenas.
+    FreeBlock* new_free_list = NULL;
+    FreeBlock** next = &new_free_list;
+    size_t block_id = 0;
+    for(FreeBlock* block = sub_pool.mpFreeList; block != NULL; block = block->mpNext, ++block_id) {
+        if(num_free_blocks[block_arena_ids[block_id]] < mBlocksPerArena) {
+            *next = block;
+            next = &block->mpNext;
+        }
+    }
+    *next = NULL;
+    sub_pool.mpFreeList = new_free_list;
+    
+    std::vector<char*> arenas;
+    size_t num_released = 0;
+    for(unsigned int i=0; i<sub_pool.mArenas.size(); ++i) {
+        if(num_free_blocks[i] == mBlocksPerArena) {
+            delete[] sub_pool.mArenas[i];
+            num_released++;
+        } else {
+            arenas.push_back(sub_pool.mArenas[i]);
+        }
+    }
+    sub_pool.mArenas.swap(arenas);
+    return num_released;
+}
+
+size_t StatePool::getThreadSubPoolId() {
+    static boost::thread_specific_ptr<size_t> thread_sub_pool_id;
+    static boost::atomic<size_t> next_sub_pool_id(0);
+    if(thread_sub_pool_id.get() == NULL) {
+        thread_sub_pool_id.reset(new size_t(next_sub_pool_id++ % NUM_SUB_POOLS));
+    }
+    return *thread_sub_pool_id;
+}
+
+} // end namespace motion_planning_libraries
@@ -0,0 +1,131 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_STATE_POOL_HPP_
+#define _MOTION_PLANNING_LIBRARIES_STATE_POOL_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace motion_planning_libraries
+{
+
+/**
+ * Allocates memory blocks of a fixed size from large arenas.
+ * Used by the state spaces to place a state and all its components 
+ * (compound components, value arrays) into one contiguous block, so allocating
+ * and freeing a state does not require any heap operation once the
+ * arenas have grown to the working set of the planner.
+ * Freed blocks are kept in a free list, releaseUnusedArenas() returns arenas
+ * which do not contain any allocated block to the heap (e.g. after the planner
+ * has been cleared). All arenas are released on destruction, so all blocks
+ * have to be deallocated before.
+ * Thread-safe, the parallel planners share the state space. Each thread 
+ * allocates from its own sub-pool (NUM_SUB_POOLS, assigned round robin), so 
+ * the planner threads do not compete for one lock. A block is always returned 
+ * to the sub-pool it has been taken from.
+ */
+class StatePool : private boost::noncopyable
+{
+ public:
+    static const size_t DEFAULT_BLOCKS_PER_ARENA = 4096;
+    // More threads share the sub-pools.
+    static const size_t NUM_SUB_POOLS = 8;
+    
+    /**
+     * \param block_size Size of each block in bytes, rounded up to keep 
+     * the blocks aligned for doubles and pointers.
+     */
+    StatePool(size_t block_size, size_t blocks_per_arena = DEFAULT_BLOCKS_PER_ARENA);
+    ~StatePool();
+    
+    void* allocate();
+    
+    void deallocate(void* block);
+    
+    /**
+     * Releases all arenas without any allocated block.
+     * Returns the number of released arenas.
+     */
+    size_t releaseUnusedArenas();
+    
+    /**
+     * Rounds up to the alignment of the blocks, used to place 
+     * several objects within one block.
+     */
+    static inline size_t align(size_t size) {
+        const size_t alignment = sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*);
+        return ((size + alignment - 1) / alignment) * alignment;
+    }
+    
+    inline size_t getBlockSize() const {
+        return mBlockSize;
+    }
+    
+    size_t getNumAllocatedBlocks() const;
+    
+    size_t getNumArenas() const;
+    
+ private:
+    // Stored within the free blocks.
+    struct FreeBlock {
+        FreeBlock* mpNext;
+    };
+    
+    /**
+     * Arenas and free list of one or more threads.
+     */
+    struct SubPool {
+        std::vector<char*> mArenas;
+        FreeBlock* mpFreeList;
+        size_t mNumAllocatedBlocks;
+        mutable boost::mutex mMutex;
+        
+        SubPool() : mArenas(), mpFreeList(NULL), mNumAllocatedBlocks(0), mMutex() {
+        }
+    };
+    
+    // Each slot starts with the id of its sub-pool, followed by the block.
+    size_t mBlockSize;
+    size_t mSlotSize;
+    size_t mBlocksPerArena;
+    std::vector<SubPool*> mSubPools;
+    
+    /**
+     * Adds a new arena to the sub-pool and pushes all its blocks to its free list.
+     */
+    void addArena(size_t sub_pool_id);
+    
+    size_t releaseUnusedArenas(SubPool& sub_pool);
+    
+    /**
+     * Id of the sub-pool of the calling thread.
+     */
+    static size_t getThreadSubPoolId();
+};
+
+/**
+ * Base class of the state spaces which allocate their states from a StatePool.
+ */
+class PooledStates
+{
+ public:
+    PooledStates(size_t block_size) : mStatePool(block_size) {
+    }
+    
+    virtual ~PooledStates() {
+    }
+    
+    inline StatePool& getStatePool() const {
+        return mStatePool;
+    }
+    
+ protected:
+    // Modified within the const allocState() and freeState() of the spaces.
+    mutable StatePool mStatePool;
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_STATE_POOL_HPP_
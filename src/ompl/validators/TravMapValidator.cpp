@@ -11,24 +11,31 @@ namespace motion_planning_libraries
 {
 
 TravMapValidator::TravMapValidator(const ompl::base::SpaceInformationPtr& si,
-            Config config) : 
+            Config const& config) : 
             ompl::base::StateValidityChecker(si),
             mpSpaceInformation(si),
+            mpTravGrid(NULL),
+            mpTravData(),
             mConfig(config), 
-            mGridCalc() {
+            mGridCalc(),
+            mFootprintXYTheta(),
+            mFootprintsSherpa() {
 }
 
 TravMapValidator::TravMapValidator(const ompl::base::SpaceInformationPtr& si,
             envire::TraversabilityGrid* trav_grid,
             boost::shared_ptr<TravData> grid_data,
-            Config config) : 
+            Config const& config) : 
             ompl::base::StateValidityChecker(si),
             mpSpaceInformation(si),
             mpTravGrid(trav_grid),
             mpTravData(grid_data),
             mConfig(config), 
-            mGridCalc() {
+            mGridCalc(),
+            mFootprintXYTheta(),
+            mFootprintsSherpa() {
     mGridCalc.setTravGrid(trav_grid, grid_data);
+    createFootprints();
 }
 
 TravMapValidator::~TravMapValidator() {
@@ -39,6 +46,7 @@ void TravMapValidator::setTravGrid(envire::TraversabilityGrid* trav_grid,
     mpTravGrid = trav_grid;
     mpTravData = trav_data;
     mGridCalc.setTravGrid(trav_grid, trav_data);
+    createFootprints();
 }
     
 bool TravMapValidator::isValid(const ompl::base::State* state) const
@@ -84,15 +92,8 @@ bool TravMapValidator::isValid(const ompl::base::State* state) const
             double y_grid = state_se2->as<ompl::base::RealVectorStateSpace::StateType>(0)->values[1];
             double yaw_grid = state_se2->as<ompl::base::SO2StateSpace::StateType>(1)->value;
             
-            double max_fp = std::max(mConfig.mFootprintRadiusMinMax.first, mConfig.mFootprintRadiusMinMax.second);
-            // We use the smaller scale value to check a larger area (actually they should be the same).
-            double min_scale = std::min(mpTravGrid->getScaleX(), mpTravGrid->getScaleY());              
-            
-            mGridCalc.setFootprintCircleInGrid(0);
-            mGridCalc.setFootprintCircleInGrid((int)std::ceil(max_fp / min_scale));
-            mGridCalc.setFootprintPoseInGrid(x_grid, y_grid, yaw_grid);
-                   
-            return mGridCalc.isValid();
+            return mGridCalc.isValid(mFootprintXYTheta, 
+                    GridCalculations::createFootprintPose(x_grid, y_grid, yaw_grid));
         }
         case ENV_SHERPA: {
             const SherpaStateSpace::StateType* state_sherpa = state->as<SherpaStateSpace::StateType>();
@@ -103,18 +104,13 @@ bool TravMapValidator::isValid(const ompl::base::State* state) const
             double yaw_grid = state_sherpa->as<ompl::base::SO2StateSpace::StateType>(1)->value;
             int fp_class = state_sherpa->getFootprintClass();            
             
-            // Use method in State to calculate the radius.
-            State state;
-            state.setFootprintRadius(mConfig.mFootprintRadiusMinMax.first,
-                mConfig.mFootprintRadiusMinMax.second,
-                mConfig.mNumFootprintClasses,
-                fp_class);
-            // Used to calculate the number of grids.
-            double min_scale = std::min(mpTravGrid->getScaleX(), mpTravGrid->getScaleY());
-            
-            mGridCalc.setFootprintCircleInGrid(std::ceil(state.getFootprintRadius()/min_scale), false);
-            mGridCalc.setFootprintPoseInGrid(x_grid, y_grid, yaw_grid);
-            return mGridCalc.isValid();
+            Eigen::Affine3d footprint2grid = 
+                    GridCalculations::createFootprintPose(x_grid, y_grid, yaw_grid);
+            if(fp_class >= 0 && fp_class < (int)mFootprintsSherpa.size()) {
+                return mGridCalc.isValid(mFootprintsSherpa[fp_class], footprint2grid);
+            } else {
+                return mGridCalc.isValid(createSherpaFootprint(fp_class), footprint2grid);
+            }
         }
         default: {
             throw std::runtime_error("TravMapValidator received an unknown environment");
@@ -123,5 +119,44 @@ bool TravMapValidator::isValid(const ompl::base::State* state) const
    
 }
 
+// PRIVATE
+void TravMapValidator::createFootprints() {
+    mFootprintXYTheta.clear();
+    mFootprintsSherpa.clear();
+    
+    if(mpTravGrid == NULL) {
+        return;
+    }
+    
+    switch(mConfig.mEnvType) {
+        case ENV_XYTHETA: {
+            double max_fp = std::max(mConfig.mFootprintRadiusMinMax.first, mConfig.mFootprintRadiusMinMax.second);
+            // We use the smaller scale value to check a larger area (actually they should be the same).
+            double min_scale = std::min(mpTravGrid->getScaleX(), mpTravGrid->getScaleY());
+            mFootprintXYTheta = GridCalculations::createFootprintCircle((int)std::ceil(max_fp / min_scale));
+            break;
+        }
+        case ENV_SHERPA: {
+            for(unsigned int i=0; i<mConfig.mNumFootprintClasses; ++i) {
+                mFootprintsSherpa.push_back(createSherpaFootprint(i));
+            }
+            break;
+        }
+        default: break;
+    }
+}
+
+std::vector< base::Vector3d > TravMapValidator::createSherpaFootprint(int fp_class) const {
+    // Use method in State to calculate the radius.
+    State state;
+    state.setFootprintRadius(mConfig.mFootprintRadiusMinMax.first,
+        mConfig.mFootprintRadiusMinMax.second,
+        mConfig.mNumFootprintClasses,
+        fp_class);
+    // Used to calculate the number of grids.
+    double min_scale = std::min(mpTravGrid->getScaleX(), mpTravGrid->getScaleY());
+    return GridCalculations::createFootprintCircle(std::ceil(state.getFootprintRadius()/min_scale), false);
+}
+
 } // end namespace motion_planning_libraries
 
@@ -32,22 +32,36 @@ class TravMapValidator:  public ompl::base::StateValidityChecker {
     envire::TraversabilityGrid* mpTravGrid; // To request the driveability values.
     boost::shared_ptr<TravData> mpTravData;
     Config mConfig;
-    mutable GridCalculations mGridCalc;
+    // Only used read-only within isValid(), so the validator can be shared
+    // by planners running in parallel.
+    GridCalculations mGridCalc;
+    // Precalculated footprints: the filled circle for ENV_XYTHETA and
+    // one outline per footprint class for ENV_SHERPA.
+    std::vector< base::Vector3d > mFootprintXYTheta;
+    std::vector< std::vector< base::Vector3d > > mFootprintsSherpa;
     
  public:
     TravMapValidator(const ompl::base::SpaceInformationPtr& si,
-            Config config);
+            Config const& config);
  
     TravMapValidator(const ompl::base::SpaceInformationPtr& si,
             envire::TraversabilityGrid* trav_grid,
             boost::shared_ptr<TravData> grid_data,
-            Config config);
+            Config const& config);
     
     ~TravMapValidator();
     
     void setTravGrid(envire::TraversabilityGrid* trav_grid, boost::shared_ptr<TravData> trav_data);
     
     bool isValid(const ompl::base::State* state) const;
+    
+ private:
+    /**
+     * Creates the footprints for the current grid resolution.
+     */
+    void createFootprints();
+    
+    std::vector< base::Vector3d > createSherpaFootprint(int fp_class) const;
 };
 
 } // end namespace motion_planning_libraries
@@ -1,25 +1,37 @@
 #include "Sbpl.hpp"
 
+#include <algorithm>
 #include <exception>
 
+#include <base/Time.hpp>
+
 #include <envire/operators/SimpleTraversability.hpp>
 
+#include <sbpl/headers.h>
 #include <sbpl/sbpl_exception.h>
 
 namespace motion_planning_libraries
 {
 
+// Planning time in seconds per replan() call if improved solutions are reported.
+const double Sbpl::SBPL_TIME_SLICE = 0.05;
+
 // PUBLIC
-Sbpl::Sbpl(Config config) : AbstractMotionPlanningLibrary(config),
+Sbpl::Sbpl(Config const& config) : AbstractMotionPlanningLibrary(config),
         mpSBPLEnv(),
         mpSBPLPlanner(),
         mSBPLWaypointIDs(),
         mpSBPLMapData(NULL),
         mSBPLNumElementsMap(0),
+        mpSharedSBPLMap(),
         mLastSolutionCost(0),
         mStartGrid(),
         mGoalGrid(),
-        mEpsilon(0.0) {
+        mEpsilon(0.0),
+        mNumExpansions(-1),
+        mForwardSearch(config.mSBPLForwardSearch),
+        mStartID(-1),
+        mGoalID(-1) {
             
     LOG_DEBUG("SBPL constructor");
 }
@@ -30,12 +42,19 @@ bool Sbpl::solve(double time) {
     
     mSBPLWaypointIDs.clear();
     
+    // Improved solutions and the progress can only be reported and a cancel 
+    // request can only be regarded if the planning time is divided.
+    if(mImprovedSolutionCallback || mProgressCallback) {
+        return solveTimeSliced(time);
+    }
+    
     bool ret = false;
     try {
         // Current conclusion: Better not touch each planners epsilon.
         ret = mpSBPLPlanner->replan(time, &mSBPLWaypointIDs, &mLastSolutionCost);
         mPathCost = mLastSolutionCost;
         mEpsilon = mpSBPLPlanner->get_solution_eps();
+        mNumExpansions = collectNumExpansions();
     } catch (...) {
         LOG_ERROR("Replanning failed");
         return false;
@@ -49,11 +68,49 @@ bool Sbpl::solve(double time) {
     }
 }
 
+bool Sbpl::setForwardSearch(bool forward) {
+    if(forward == mForwardSearch) {
+        return true;
+    }
+    
+    if(mConfig.mPlanner != UNDEFINED_PLANNER && mConfig.mPlanner != ANYTIME_DSTAR) {
+        LOG_WARN("Search direction can only be changed for AD*");
+        return false;
+    }
+    
+    LOG_INFO("Change search direction to %s search", forward ? "forward" : "backward");
+    mForwardSearch = forward;
+    
+    if(mpSBPLEnv == NULL) {
+        // Will be used as soon as the planner is created.
+        return true;
+    }
+    
+    // The search tree of the old planner cannot be reused.
+    mSBPLWaypointIDs.clear();
+    mEpsilon = 0.0;
+    if(!createSBPLPlanner()) {
+        return false;
+    }
+    if(mStartID >= 0 && mGoalID >= 0) {
+        return setStartGoalIDs(mStartID, mGoalID);
+    }
+    return true;
+}
+
 void Sbpl::createSBPLMap(envire::TraversabilityGrid* trav_grid,
         boost::shared_ptr<TravData> trav_data) {
     
     LOG_DEBUG("SBPL createSBPLMap");
     
+    // A shared map is converted only once for all planners.
+    boost::shared_ptr<const PreprocessedMap> preprocessed_map = getPreprocessedMap(trav_data);
+    if(preprocessed_map) {
+        mpSharedSBPLMap = preprocessed_map->getCostMap(SBPL_MAX_COST);
+        return;
+    }
+    mpSharedSBPLMap.reset();
+    
     // Create a new sbpl map if it has not been created yet or the number 
     // of elements have changed.
     if(mpSBPLMapData != NULL) {
@@ -108,6 +165,13 @@ void Sbpl::createSBPLMap(envire::TraversabilityGrid* trav_grid,
     }
 }
 
+const unsigned char* Sbpl::getSBPLMapData() {
+    if(mpSharedSBPLMap) {
+        return &(*mpSharedSBPLMap)[0];
+    }
+    return mpSBPLMapData;
+}
+
 std::vector<sbpl_2Dpt_t> Sbpl::createFootprint(double robot_width, double robot_length) {
 
     LOG_DEBUG("SBPL createFootprint");
@@ -133,13 +197,142 @@ std::vector<sbpl_2Dpt_t> Sbpl::createFootprint(double robot_width, double robot_
     return footprint;
 }
 
+int Sbpl::getNumExpansions() {
+    return mNumExpansions;
+}
+
+double Sbpl::getEpsilon() {
+    return mEpsilon;
+}
+
 bool Sbpl::foundFinalSolution() {
     LOG_INFO("Current epsilon is %4.2f", mEpsilon);
     return (mEpsilon == 1.0);
 }
 
 unsigned char Sbpl::driveability2sbpl_cost(double driveability) {
-    return SBPL_MAX_COST - (int)(driveability * (double)SBPL_MAX_COST) + 1.0;
+    return PreprocessedMap::driveability2cost(driveability, SBPL_MAX_COST);
+}
+
+// PROTECTED
+bool Sbpl::createSBPLPlanner() {
+    switch(mConfig.mPlanner) {
+        case UNDEFINED_PLANNER: 
+        case ANYTIME_DSTAR: {
+            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new ADPlanner(mpSBPLEnv.get(), 
+                    mForwardSearch));
+            break;
+        }
+        case ANYTIME_NONPARAMETRIC_ASTAR: {
+            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new anaPlanner(mpSBPLEnv.get(), 
+                    mForwardSearch));
+            break;
+        }
+        case ANYTIME_ASTAR: {
+            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new ARAPlanner(mpSBPLEnv.get(), 
+                    mForwardSearch));
+            break;
+        }
+        default: {
+            LOG_ERROR("Planner %d is not available for this environment", (int)mConfig.mPlanner);
+            return false;
+        }
+    }
+    mpSBPLPlanner->set_search_mode(mConfig.mSearchUntilFirstSolution); 
+    return true;
+}
+
+bool Sbpl::setStartGoalIDs(int start_id, int goal_id) {
+    // AD* keeps its search tree if the search goal (backward search: the start) 
+    // changes, setting an unchanged state is ignored by the planners.
+    if (mpSBPLPlanner->set_start(start_id) == 0) {
+        LOG_ERROR("Failed to set start state");
+        return false;
+    }
+    mStartID = start_id;
+
+    if (mpSBPLPlanner->set_goal(goal_id) == 0) {
+        LOG_ERROR("Failed to set goal state");
+        return false;
+    }
+    mGoalID = goal_id;
+    return true;
+}
+
+bool Sbpl::solveTimeSliced(double time) {
+    
+    // SBPL does not offer a callback for improved solutions. Instead replan() 
+    // is called repeatedly with a fraction of the planning time, the anytime planners 
+    // (ARA*, AD*) continue their search with the decreased epsilon of the last call.
+    std::vector<int> waypoint_ids;
+    int solution_cost = 0;
+    double last_reported_epsilon = -1.0;
+    bool solution_found = false;
+    int num_expansions = -1;
+    base::Time start_time = base::Time::now();
+    double remaining_time = time;
+    mNumExpansions = num_expansions;
+    
+    while(remaining_time > 0 && !isCancelRequested()) {
+        bool ret = false;
+        waypoint_ids.clear();
+        try {
+            ret = mpSBPLPlanner->replan(std::min(remaining_time, SBPL_TIME_SLICE), 
+                    &waypoint_ids, &solution_cost);
+        } catch (...) {
+            LOG_ERROR("Replanning failed");
+            return false;
+        }
+        
+        int expansions = collectNumExpansions();
+        if(expansions >= 0) {
+            num_expansions = (num_expansions < 0) ? expansions : num_expansions + expansions;
+        }
+        
+        // Allows the callbacks to report the current search effort.
+        mNumExpansions = num_expansions;
+        notifyProgress();
+        
+        if(ret) {
+            solution_found = true;
+            double epsilon = mpSBPLPlanner->get_solution_eps();
+            if(epsilon != last_reported_epsilon) {
+                mSBPLWaypointIDs = waypoint_ids;
+                mLastSolutionCost = solution_cost;
+                mPathCost = mLastSolutionCost;
+                mEpsilon = epsilon;
+                last_reported_epsilon = epsilon;
+                LOG_INFO("Improved solution with epsilon %4.2f contains %d waypoints", 
+                        mEpsilon, (int)mSBPLWaypointIDs.size());
+                notifyImprovedSolution();
+            }
+            if(mEpsilon == 1.0 || mConfig.mSearchUntilFirstSolution) {
+                break;
+            }
+        }
+        remaining_time = time - (base::Time::now() - start_time).toSeconds();
+    }
+    if(isCancelRequested()) {
+        LOG_INFO("Planning has been canceled");
+    }
+    return solution_found;
+}
+
+int Sbpl::collectNumExpansions() {
+    std::vector<PlannerStats> stats;
+    try {
+        mpSBPLPlanner->get_search_stats(&stats);
+    } catch (...) {
+        // Not all SBPL planners provide search statistics.
+        return -1;
+    }
+    
+    int num_expansions = 0;
+    std::vector<PlannerStats>::iterator it = stats.begin();
+    for(; it != stats.end(); it++) {
+        num_expansions += it->expands;
+    }
+    return num_expansions;
 }
 
 } // namespace motion_planning_libraries
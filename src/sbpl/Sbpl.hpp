@@ -27,34 +27,68 @@ class Sbpl : public AbstractMotionPlanningLibrary
     // Driveability 0.0 to 1.0 will be mapped to SBPL_MAX_COST + 1 to 1 
     // with obstacle threshold of SBPL_MAX_COST + 1.
     static const unsigned char SBPL_MAX_COST = 20;
+    // Planning time per replan() call if an improved solution or progress callback has been set.
+    static const double SBPL_TIME_SLICE;
     
     boost::shared_ptr<DiscreteSpaceInformation> mpSBPLEnv;
     boost::shared_ptr<SBPLPlanner> mpSBPLPlanner;
     std::vector<int> mSBPLWaypointIDs;
     unsigned char* mpSBPLMapData;
     size_t mSBPLNumElementsMap;
+    // Cost map of the attached preprocessed map, used instead of mpSBPLMapData.
+    boost::shared_ptr<const std::vector<unsigned char> > mpSharedSBPLMap;
     int mLastSolutionCost;
     // Discrete start and goal state(x,y,theta), can be used to check 
     // - after planning have failed - whether the states intersect with an obstacle.
     Eigen::Vector3i mStartGrid, mGoalGrid;
     double mEpsilon;
+    // Number of expanded states during the last call of solve(), -1 if unknown.
+    int mNumExpansions;
+    // Current search direction, initialized with mConfig.mSBPLForwardSearch.
+    bool mForwardSearch;
+    // Last start and goal state ids, used to reset them if the planner is recreated.
+    int mStartID, mGoalID;
         
  public: 
-    Sbpl(Config config = Config());
+    Sbpl(Config const& config = Config());
     
     /**
      * Clears the waypoint-id-list and replans.
+     * If an improved solution callback is registered the planning time
+     * is divided into slices to report each epsilon step.
      */
     virtual bool solve(double time);    
    
+    /**
+     * Changes the search direction of the planner. Only supported by AD*
+     * which keeps its search tree if the search goal changes. So searching 
+     * backwards (from the goal to the robot) only moves the query point if a 
+     * new start pose is received. The planner is recreated using the 
+     * last start and goal.
+     */
+    virtual bool setForwardSearch(bool forward);
+    
+    inline bool isForwardSearch() {
+        return mForwardSearch;
+    }
+    
     /**
      * Converts the trav map to a sbpl map using the driveability value.
      * Driveability 0.0 to 1.0 is mapped to costs SBPL_MAX_COST + 1  to 1 with obstacle threshold SBPL_MAX_COST + 1.
      * (+1 because costs of 0 should be avoided).
+     * The cost map of an attached preprocessed map is shared instead.
+     * Only the conversion is shared: InitializeEnv() of the SBPL environments 
+     * copies the passed map into its own grid, so each SBPL planner still holds 
+     * one byte per cell.
      */
     void createSBPLMap(envire::TraversabilityGrid* trav_grid, 
             boost::shared_ptr<TravData> trav_data);
     
+    /**
+     * Returns the cost map created by createSBPLMap().
+     */
+    const unsigned char* getSBPLMapData();
+    
     /**
      * The footprint has to be defined in meter.
      */
@@ -66,7 +100,43 @@ class Sbpl : public AbstractMotionPlanningLibrary
      */
     bool foundFinalSolution();
     
+    /**
+     * Returns the number of states which have been expanded during all 
+     * search iterations of the last solve() call.
+     */
+    int getNumExpansions();
+    
+    /**
+     * Epsilon of the last solution, 1.0 identifies the optimal solution.
+     */
+    double getEpsilon();
+    
     unsigned char driveability2sbpl_cost(double driveability);
+    
+ protected:
+    /**
+     * Creates the planner defined in mConfig.mPlanner (default AD*) 
+     * using the current search direction.
+     */
+    bool createSBPLPlanner();
+    
+    /**
+     * Passes the start and goal id to the planner and stores them.
+     */
+    bool setStartGoalIDs(int start_id, int goal_id);
+    
+    /**
+     * Calls replan() repeatedly with SBPL_TIME_SLICE and notifies each
+     * solution with a decreased epsilon. Stops after the current slice
+     * if cancel() has been called.
+     */
+    bool solveTimeSliced(double time);
+    
+    /**
+     * Sums up the expansions of the search statistics of the planner.
+     * Returns -1 if the planner does not offer statistics.
+     */
+    int collectNumExpansions();
 };
     
 } // end namespace motion_planning_libraries
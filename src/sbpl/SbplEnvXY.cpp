@@ -6,7 +6,7 @@ namespace motion_planning_libraries
 {
 
 // PUBLIC
-SbplEnvXY::SbplEnvXY(Config config) : Sbpl(config) {
+SbplEnvXY::SbplEnvXY(Config const& config) : Sbpl(config) {
     LOG_DEBUG("SBPLEnvXY constructor");
 }
 
@@ -32,7 +32,7 @@ bool SbplEnvXY::initialize(envire::TraversabilityGrid* trav_grid,
             LOG_INFO("Create SBPL EnvironmentNAV2D environment");
             boost::shared_ptr<EnvironmentNAV2D> env_xy =
                     boost::dynamic_pointer_cast<EnvironmentNAV2D>(mpSBPLEnv);
-            env_xy->InitializeEnv(grid_width, grid_height, mpSBPLMapData, SBPL_MAX_COST + 1);
+            env_xy->InitializeEnv(grid_width, grid_height, getSBPLMapData(), SBPL_MAX_COST + 1);
         }
     } catch (SBPL_Exception* e) {
         LOG_ERROR("SBPL environment '%s' could not be loaded (%s)", 
@@ -43,29 +43,9 @@ bool SbplEnvXY::initialize(envire::TraversabilityGrid* trav_grid,
     } 
       
     // Create planner.
-    switch(mConfig.mPlanner) {
-        case UNDEFINED_PLANNER: {
-        }
-        case ANYTIME_DSTAR: {
-            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new ADPlanner(mpSBPLEnv.get(), 
-                    mConfig.mSBPLForwardSearch));
-            break;
-        }
-        case ANYTIME_NONPARAMETRIC_ASTAR: {
-            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new anaPlanner(mpSBPLEnv.get(), 
-                    mConfig.mSBPLForwardSearch));
-            break;
-        }
-        case ANYTIME_ASTAR: {
-            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new ARAPlanner(mpSBPLEnv.get(), 
-                    mConfig.mSBPLForwardSearch));
-        }
-        default: {
-            LOG_ERROR("Planner %d is not available for this environment", (int)mConfig.mPlanner);
-            return false;
-        }
+    if(!createSBPLPlanner()) {
+        return false;
     }
-    mpSBPLPlanner->set_search_mode(mConfig.mSearchUntilFirstSolution); 
     
     // If available use the start and goal defined in the SBPL environment.
     if(!mConfig.mSBPLEnvFile.empty()) {
@@ -78,13 +58,7 @@ bool SbplEnvXY::initialize(envire::TraversabilityGrid* trav_grid,
         }
            
         std::cout << "SBPL: About to set start and goal, startid" << mdp_cfg.startstateid << std::endl;
-        if (mpSBPLPlanner->set_start(mdp_cfg.startstateid) == 0) {
-            LOG_ERROR("Failed to set start state");
-            return false;
-        }
-
-        if (mpSBPLPlanner->set_goal(mdp_cfg.goalstateid) == 0) {
-            LOG_ERROR("Failed to set goal state");
+        if(!setStartGoalIDs(mdp_cfg.startstateid, mdp_cfg.goalstateid)) {
             return false;
         }
     }
@@ -112,7 +86,7 @@ bool SbplEnvXY::partialMapUpdate(std::vector<CellUpdate>& cell_updates) {
     return true;
 }
 
-bool SbplEnvXY::setStartGoal(struct State start_state, struct State goal_state) {
+bool SbplEnvXY::setStartGoal(struct State const& start_state, struct State const& goal_state) {
     
     LOG_DEBUG("SBPLEnvXY setStartGoal");
     
@@ -127,13 +101,7 @@ bool SbplEnvXY::setStartGoal(struct State start_state, struct State goal_state)
     goal_id = env_xy->SetGoal(goal_state.getPose().position[0], 
             goal_state.getPose().position[1]);
 
-    if (mpSBPLPlanner->set_start(start_id) == 0) {
-        LOG_ERROR("Failed to set start state");
-        return false;
-    }
-
-    if (mpSBPLPlanner->set_goal(goal_id) == 0) {
-        LOG_ERROR("Failed to set goal state");
+    if(!setStartGoalIDs(start_id, goal_id)) {
         return false;
     }
       
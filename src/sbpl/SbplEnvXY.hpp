@@ -10,7 +10,7 @@ class SbplEnvXY : public Sbpl
 {      
    
  public: 
-    SbplEnvXY(Config config = Config());
+    SbplEnvXY(Config const& config = Config());
  
     /**
      * 
@@ -23,7 +23,7 @@ class SbplEnvXY : public Sbpl
     /**
      * 
      */
-    virtual bool setStartGoal(struct State start_state, struct State goal_state);
+    virtual bool setStartGoal(struct State const& start_state, struct State const& goal_state);
       
     /**
      * 
@@ -1,4 +1,5 @@
 #include "SbplEnvXYTHETA.hpp"
+#include "SbplGoalRegionEnv.hpp"
 
 #include <exception>
 
@@ -9,7 +10,7 @@ namespace motion_planning_libraries
 {
 
 // PUBLIC
-SbplEnvXYTHETA::SbplEnvXYTHETA(Config config) : Sbpl(config), 
+SbplEnvXYTHETA::SbplEnvXYTHETA(Config const& config) : Sbpl(config), 
         mSBPLScaleX(0), mSBPLScaleY(0), mPrims(NULL), mGoalLocal() {
     LOG_DEBUG("SbplEnvXYTHETA constructor");
 }
@@ -36,8 +37,9 @@ bool SbplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
     }
        
     // Create and fill SBPL environment.
-    mpSBPLEnv = boost::shared_ptr<EnvironmentNAVXYTHETAMLEVLAT>(
-            new EnvironmentNAVXYTHETAMLEVLAT());
+    // Extends EnvironmentNAVXYTHETAMLEVLAT by the goal tolerance region.
+    boost::shared_ptr<SbplGoalRegionEnv> goal_region_env(new SbplGoalRegionEnv());
+    mpSBPLEnv = goal_region_env;
 
 
     // Use the sbpl-env file if path is given.
@@ -65,6 +67,11 @@ bool SbplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
         if(mprim_file.empty()) {
             LOG_INFO("No sbpl mprim file specified, it will be generated");
             assert(scale_x == scale_y);
+            if(!MotionPrimitivesConfig::isSupportedNumAngles(mConfig.mNumAngles)) {
+                LOG_ERROR("%d discrete angles are not supported, use 8, 16, 32 or 64", 
+                        mConfig.mNumAngles);
+                return false;
+            }
             mprim_file = "sbpl_motion_primitives.mprim";
             MotionPrimitivesConfig mprim_config(mConfig, grid_width, grid_height, scale_x);
             mPrims = new struct SbplMotionPrimitives(mprim_config);
@@ -112,10 +119,11 @@ bool SbplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
             std::vector<sbpl_2Dpt_t> fp_vec = createFootprint(robot_width, robot_length);
             base::Time start_t = base::Time::now();
             env_xytheta->InitializeEnv(grid_width, grid_height, 
-                mpSBPLMapData, // initial map
+                getSBPLMapData(), // initial map
                 0,0,0, //mStartGrid.position.x(), mStartGrid.position.y(), mStartGrid.getYaw(), 
                 0,0,0, //mGoalGrid.position.x(), mGoalGrid.position.y(), mGoalGrid.getYaw(),
-                0.1, 0.1, 0.1, // tolerance x,y,yaw, ignored
+                mConfig.mGoalPosTolerance, mConfig.mGoalPosTolerance, 
+                mConfig.mGoalYawTolerance, // tolerance x,y,yaw, ignored by SBPL, see below
                 fp_vec, 
                 scale_x,  // Size of a cell in meter => in SBPL cells have to be quadrats
                 speed, 
@@ -135,30 +143,13 @@ bool SbplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
         }
     }
  
+    // The tolerances passed to InitializeEnv() are not used by SBPL.
+    goal_region_env->setGoalTolerance(mConfig.mGoalPosTolerance, mConfig.mGoalYawTolerance);
+ 
     // Create planner.
-    switch(mConfig.mPlanner) {
-        case UNDEFINED_PLANNER: {
-        }
-        case ANYTIME_DSTAR: {
-            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new ADPlanner(mpSBPLEnv.get(), 
-                    mConfig.mSBPLForwardSearch));
-            break;
-        }
-        case ANYTIME_NONPARAMETRIC_ASTAR: {
-            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new anaPlanner(mpSBPLEnv.get(), 
-                    mConfig.mSBPLForwardSearch));
-            break;
-        }
-        case ANYTIME_ASTAR: {
-            mpSBPLPlanner = boost::shared_ptr<SBPLPlanner>(new ARAPlanner(mpSBPLEnv.get(), 
-                    mConfig.mSBPLForwardSearch));
-        }
-        default: {
-            LOG_ERROR("Planner %d is not available for this environment", (int)mConfig.mPlanner);
-            return false;
-        }
+    if(!createSBPLPlanner()) {
+        return false;
     }
-    mpSBPLPlanner->set_search_mode(mConfig.mSearchUntilFirstSolution); 
     
     // If available use the start and goal defined in the SBPL environment.
     if(!mConfig.mSBPLEnvFile.empty()) {
@@ -170,20 +161,17 @@ bool SbplEnvXYTHETA::initialize(envire::TraversabilityGrid* trav_grid,
             return false;
         }
            
-        if (mpSBPLPlanner->set_start(mdp_cfg.startstateid) == 0) {
-            LOG_ERROR("Failed to set start state");
-            return false;
-        }
-
-        if (mpSBPLPlanner->set_goal(mdp_cfg.goalstateid) == 0) {
-            LOG_ERROR("Failed to set goal state");
+        if(!setStartGoalIDs(mdp_cfg.startstateid, mdp_cfg.goalstateid)) {
             return false;
         }
     }
 
-    // Print primitive informations.
+    // Print primitive informations (not available if a mprim file has been loaded).
     //std::cout << "Primitives: " << std::endl << mPrims->toString() << std::endl;
-    LOG_INFO("Primitives:\n%s", mPrims->toString().c_str());
+    if(mPrims != NULL) {
+        LOG_INFO("Primitives:\n%s", mPrims->toString().c_str());
+    }
+    LOG_INFO("Lattice uses %d discrete angles", getNumThetaDirs());
 
     return true;
 }
@@ -208,7 +196,7 @@ bool SbplEnvXYTHETA::partialMapUpdate(std::vector<CellUpdate>& cell_updates) {
     return true;
 }
 
-bool SbplEnvXYTHETA::setStartGoal(struct State start_state, struct State goal_state) {
+bool SbplEnvXYTHETA::setStartGoal(struct State const& start_state, struct State const& goal_state) {
     
     LOG_DEBUG("SBPL setStartGoal");
     
@@ -232,13 +220,7 @@ bool SbplEnvXYTHETA::setStartGoal(struct State start_state, struct State goal_st
     start_id = env_xytheta->SetStart(start_x, start_y, start_yaw);
     goal_id = env_xytheta->SetGoal(goal_x, goal_y, goal_yaw);
 
-    if (mpSBPLPlanner->set_start(start_id) == 0) {
-        LOG_ERROR("Failed to set start state");
-        return false;
-    }
-
-    if (mpSBPLPlanner->set_goal(goal_id) == 0) {
-        LOG_ERROR("Failed to set goal state");
+    if(!setStartGoalIDs(start_id, goal_id)) {
         return false;
     }
     
@@ -250,10 +232,12 @@ bool SbplEnvXYTHETA::setStartGoal(struct State start_state, struct State goal_st
     // Stores discrete start and goal pose to check for validity.
     mStartGrid[0] = start_state.getPose().position[0];
     mStartGrid[1] = start_state.getPose().position[1];
-    mStartGrid[2] = mPrims->calcDiscreteEndOrientation(start_state.getPose().getYaw());
+    // The discrete angles are requested from the environment, mPrims is not 
+    // available if a mprim file is used.
+    mStartGrid[2] = ContTheta2Disc(start_yaw, getNumThetaDirs());
     mGoalGrid[0] = goal_state.getPose().position[0];
     mGoalGrid[1] = goal_state.getPose().position[1];
-    mGoalGrid[2] = mPrims->calcDiscreteEndOrientation(goal_state.getPose().getYaw());
+    mGoalGrid[2] = ContTheta2Disc(goal_yaw, getNumThetaDirs());
       
     return true;
 }
@@ -273,10 +257,25 @@ bool SbplEnvXYTHETA::fillPath(std::vector<struct State>& path, bool& pos_defined
     
     std::vector<int> path_ids;
     std::vector<sbpl_xy_theta_pt_t> path_xytheta;
+    int num_theta_dirs = getNumThetaDirs();
+    
+    // If the goal region has been reached the last transition is a virtual one
+    // (without a motion primitive) and is removed, the path ends within the region.
+    std::vector<int> waypoint_ids = mSBPLWaypointIDs;
+    bool goal_region_reached = false;
+    boost::shared_ptr<SbplGoalRegionEnv> goal_region_env =
+            boost::dynamic_pointer_cast<SbplGoalRegionEnv>(mpSBPLEnv);
+    if(goal_region_env != NULL && waypoint_ids.size() >= 2 && 
+            goal_region_env->isVirtualGoalTransition(waypoint_ids[waypoint_ids.size()-2], 
+            waypoint_ids.back())) {
+        waypoint_ids.pop_back();
+        goal_region_reached = true;
+        LOG_INFO("Path ends within the goal region");
+    }
     
     // Just fill the path with the motion primitive poses (in grid coordinates).
-    std::vector<int>::iterator it = mSBPLWaypointIDs.begin();
-    for(; it != mSBPLWaypointIDs.end(); it++) {
+    std::vector<int>::iterator it = waypoint_ids.begin();
+    for(; it != waypoint_ids.end(); it++) {
         // Fill path with the found solution.
         boost::shared_ptr<EnvironmentNAVXYTHETAMLEVLAT> env_xytheta =
                 boost::dynamic_pointer_cast<EnvironmentNAVXYTHETAMLEVLAT>(mpSBPLEnv);
@@ -284,11 +283,11 @@ bool SbplEnvXYTHETA::fillPath(std::vector<struct State>& path, bool& pos_defined
         env_xytheta->GetCoordFromState(*it, x_discrete, y_discrete, theta_discrete);
 
         // MotionPlanningLibraries expects grid coordinates, but a real angle in rad,
-        // not the discrete one! (0-15), adapts to OMPL angles with (-PI,PI]
+        // not the discrete one! (0 to num_theta_dirs-1), adapts to OMPL angles with (-PI,PI]
         state.mPose.position = base::Vector3d((double)x_discrete, (double)y_discrete, 0);
-        double theta_rad = DiscTheta2Cont(theta_discrete, NAVXYTHETALAT_THETADIRS);
+        double theta_rad = DiscTheta2Cont(theta_discrete, num_theta_dirs);
         // Converts [0,2*M_PI) to (-PI,PI].
-        if(theta_rad > 180) {
+        if(theta_rad > M_PI) {
             theta_rad -= 2*M_PI;
         }
         state.mPose.orientation =  Eigen::AngleAxis<double>(theta_rad, base::Vector3d(0,0,1));
@@ -327,9 +326,19 @@ bool SbplEnvXYTHETA::fillPath(std::vector<struct State>& path, bool& pos_defined
             path.push_back(state);
         }
         // The goal pose is not part of the received path, so we add it manually.
-        state.mPose.position = base::Vector3d(mGoalLocal[0], mGoalLocal[1], 0.0);
-        state.mPose.orientation =  Eigen::AngleAxis<double>(mGoalLocal[2], base::Vector3d(0,0,1));
-        path.push_back(state);
+        // Within the goal region the last reached pose is used instead.
+        if(goal_region_reached) {
+            int x_end = 0, y_end = 0, theta_end = 0;
+            env_xytheta->GetCoordFromState(waypoint_ids.back(), x_end, y_end, theta_end);
+            state.mPose.position = base::Vector3d(x_end * mSBPLScaleX, y_end * mSBPLScaleY, 0.0);
+            state.mPose.orientation =  Eigen::AngleAxis<double>(
+                    DiscTheta2Cont(theta_end, num_theta_dirs), base::Vector3d(0,0,1));
+            path.push_back(state);
+        } else {
+            state.mPose.position = base::Vector3d(mGoalLocal[0], mGoalLocal[1], 0.0);
+            state.mPose.orientation =  Eigen::AngleAxis<double>(mGoalLocal[2], base::Vector3d(0,0,1));
+            path.push_back(state);
+        }
     }
     
     // Request and assign prim id and speed values.
@@ -341,8 +350,7 @@ bool SbplEnvXYTHETA::fillPath(std::vector<struct State>& path, bool& pos_defined
     std::vector<struct State>::iterator it_state = path.begin();
     unsigned int prim_id = 0;
     
-    LOG_INFO("Path consist of %d poses / %d primitives (each primitive contains %d poses)", 
-            path.size(), action_list.size(), mPrims->mConfig.mNumPosesPerPrim);
+    LOG_INFO("Path consist of %d poses / %d primitives", (int)path.size(), (int)action_list.size());
     
     
     // Runs through all states and assigns prim id, speed values and movement type to 
@@ -383,6 +391,15 @@ bool SbplEnvXYTHETA::fillPath(std::vector<struct State>& path, bool& pos_defined
     return true;
 }
 
+int SbplEnvXYTHETA::getNumThetaDirs() {
+    boost::shared_ptr<EnvironmentNAVXYTHETAMLEVLAT> env_xytheta =
+        boost::dynamic_pointer_cast<EnvironmentNAVXYTHETAMLEVLAT>(mpSBPLEnv);
+    if(env_xytheta == NULL) {
+        return mConfig.mNumAngles;
+    }
+    return env_xytheta->GetEnvNavConfig()->NumThetaDirs;
+}
+
 enum MplErrors SbplEnvXYTHETA::isStartGoalValid() {
     boost::shared_ptr<EnvironmentNAVXYTHETAMLEVLAT> env_xytheta =
         boost::dynamic_pointer_cast<EnvironmentNAVXYTHETAMLEVLAT>(mpSBPLEnv);
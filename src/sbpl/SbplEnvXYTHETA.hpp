@@ -19,7 +19,7 @@ class SbplEnvXYTHETA : public Sbpl
     base::Vector3d mGoalLocal;
 
  public: 
-    SbplEnvXYTHETA(Config config = Config());
+    SbplEnvXYTHETA(Config const& config = Config());
  
     /**
      * 
@@ -32,7 +32,7 @@ class SbplEnvXYTHETA : public Sbpl
     /**
      * 
      */
-    virtual bool setStartGoal(struct State start_state, struct State goal_state);
+    virtual bool setStartGoal(struct State const& start_state, struct State const& goal_state);
         
     virtual bool solve(double time);    
         
@@ -48,6 +48,13 @@ class SbplEnvXYTHETA : public Sbpl
     }
     
     enum MplErrors isStartGoalValid();
+    
+    /**
+     * Returns the number of discrete angles used by the loaded lattice.
+     * This is either mConfig.mNumAngles or the number defined within 
+     * the passed mprim file.
+     */
+    int getNumThetaDirs();
 };
     
 } // end namespace motion_planning_libraries
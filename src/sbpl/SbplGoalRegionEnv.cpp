@@ -0,0 +1,124 @@
+#include "SbplGoalRegionEnv.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <base-logging/Logging.hpp>
+
+namespace motion_planning_libraries
+{
+
+const int SbplGoalRegionEnv::VIRTUAL_GOAL_COST;
+
+// PUBLIC
+SbplGoalRegionEnv::SbplGoalRegionEnv() : EnvironmentNAVXYTHETAMLEVLAT(),
+        mPosToleranceCells(0.0),
+        mYawToleranceDirs(0),
+        mHeuristicReduction(0) {
+}
+
+void SbplGoalRegionEnv::setGoalTolerance(double pos_tolerance_m, double yaw_tolerance_rad) {
+    const EnvNAVXYTHETALATConfig_t* cfg = GetEnvNavConfig();
+
+    mPosToleranceCells = std::max(0.0, pos_tolerance_m / cfg->cellsize_m);
+    mYawToleranceDirs = (int)floor(std::max(0.0, yaw_tolerance_rad) /
+            (2.0 * M_PI / cfg->NumThetaDirs));
+    // Same conversion which is used by the lattice heuristics (distance to time in ms).
+    mHeuristicReduction = (int)(NAVXYTHETALAT_COSTMULT_MTOMM *
+            std::max(0.0, pos_tolerance_m) / cfg->nominalvel_mpersecs);
+
+    LOG_INFO("Goal region: %4.2f cells, %d discrete angles",
+            mPosToleranceCells, mYawToleranceDirs);
+}
+
+bool SbplGoalRegionEnv::isWithinGoalRegion(int x, int y, int theta) {
+    const EnvNAVXYTHETALATConfig_t* cfg = GetEnvNavConfig();
+
+    double dx = x - cfg->EndX_c;
+    double dy = y - cfg->EndY_c;
+    if(dx * dx + dy * dy > mPosToleranceCells * mPosToleranceCells) {
+        return false;
+    }
+
+    int dtheta = abs(theta - cfg->EndTheta) % cfg->NumThetaDirs;
+    dtheta = std::min(dtheta, cfg->NumThetaDirs - dtheta);
+    return dtheta <= mYawToleranceDirs;
+}
+
+bool SbplGoalRegionEnv::isVirtualGoalTransition(int source_state_id, int target_state_id) {
+    if(!goalRegionActive() ||
+            target_state_id != EnvNAVXYTHETALAT.goalstateid ||
+            source_state_id == target_state_id) {
+        return false;
+    }
+
+    // Requesting the actions hides the virtual transitions.
+    std::vector<int> succ_ids;
+    std::vector<int> costs;
+    std::vector<EnvNAVXYTHETALATAction_t*> actions;
+    GetSuccs(source_state_id, &succ_ids, &costs, &actions);
+    for(unsigned int i=0; i<succ_ids.size(); ++i) {
+        if(succ_ids[i] == target_state_id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SbplGoalRegionEnv::GetSuccs(int SourceStateID, std::vector<int>* SuccIDV,
+        std::vector<int>* CostV, std::vector<EnvNAVXYTHETALATAction_t*>* actionindexV) {
+
+    EnvironmentNAVXYTHETAMLEVLAT::GetSuccs(SourceStateID, SuccIDV, CostV, actionindexV);
+
+    if(actionindexV != NULL || !goalRegionActive() ||
+            SourceStateID == EnvNAVXYTHETALAT.goalstateid) {
+        return;
+    }
+
+    int x = 0, y = 0, theta = 0;
+    GetCoordFromState(SourceStateID, x, y, theta);
+    if(isWithinGoalRegion(x, y, theta)) {
+        SuccIDV->push_back(EnvNAVXYTHETALAT.goalstateid);
+        CostV->push_back(VIRTUAL_GOAL_COST);
+    }
+}
+
+void SbplGoalRegionEnv::GetPreds(int TargetStateID, std::vector<int>* PredIDV,
+        std::vector<int>* CostV) {
+
+    EnvironmentNAVXYTHETAMLEVLAT::GetPreds(TargetStateID, PredIDV, CostV);
+
+    if(!goalRegionActive() || TargetStateID != EnvNAVXYTHETALAT.goalstateid) {
+        return;
+    }
+
+    // Backward search: All valid region states are predecessors of the goal.
+    const EnvNAVXYTHETALATConfig_t* cfg = GetEnvNavConfig();
+    int radius = (int)floor(mPosToleranceCells);
+    for(int x = cfg->EndX_c - radius; x <= cfg->EndX_c + radius; ++x) {
+        for(int y = cfg->EndY_c - radius; y <= cfg->EndY_c + radius; ++y) {
+            for(int theta = 0; theta < cfg->NumThetaDirs; ++theta) {
+                if(!isWithinGoalRegion(x, y, theta) || !IsValidConfiguration(x, y, theta)) {
+                    continue;
+                }
+                int state_id = GetStateFromCoord(x, y, theta);
+                if(state_id == TargetStateID) {
+                    continue;
+                }
+                PredIDV->push_back(state_id);
+                CostV->push_back(VIRTUAL_GOAL_COST);
+            }
+        }
+    }
+}
+
+int SbplGoalRegionEnv::GetGoalHeuristic(int stateID) {
+    int h = EnvironmentNAVXYTHETAMLEVLAT::GetGoalHeuristic(stateID);
+    if(!goalRegionActive()) {
+        return h;
+    }
+    return std::max(0, h - mHeuristicReduction);
+}
+
+} // namespace motion_planning_libraries
@@ -0,0 +1,76 @@
+#ifndef _MOTION_PLANNING_LIBRARIES_SBPL_GOAL_REGION_ENV_HPP_
+#define _MOTION_PLANNING_LIBRARIES_SBPL_GOAL_REGION_ENV_HPP_
+
+#include <vector>
+
+#include <sbpl/config.h> // here #define DEBUG 0, causes a lot of trouble
+#include <sbpl/discrete_space_information/environment_navxythetamlevlat.h>
+#undef DEBUG
+
+namespace motion_planning_libraries
+{
+
+/**
+ * EnvironmentNAVXYTHETAMLEVLAT ignores the goal tolerances passed to InitializeEnv(),
+ * so the search has to reach the exact discrete goal (x, y, theta).
+ * This environment adds a virtual transition from each valid state within the goal
+ * region (position and heading tolerance) to the goal state. So the search ends
+ * as soon as the region has been reached.
+ * The virtual transitions are only visible to the planners (GetSuccs() without an
+ * action vector and GetPreds()), the path conversion methods of SBPL request
+ * the actions and only see the real motion primitives.
+ * With tolerances of 0 the environment behaves like EnvironmentNAVXYTHETAMLEVLAT.
+ */
+class SbplGoalRegionEnv : public EnvironmentNAVXYTHETAMLEVLAT
+{
+ public:
+    // Cost of the virtual transition into the goal state.
+    static const int VIRTUAL_GOAL_COST = 1;
+
+    SbplGoalRegionEnv();
+
+    /**
+     * \param pos_tolerance_m Max distance in meter between the reached and the goal position.
+     * \param yaw_tolerance_rad Max difference in rad between the reached and the goal heading.
+     * Has to be called after the environment has been initialized.
+     */
+    void setGoalTolerance(double pos_tolerance_m, double yaw_tolerance_rad);
+
+    inline bool goalRegionActive() {
+        return mPosToleranceCells > 0 || mYawToleranceDirs > 0;
+    }
+
+    /**
+     * Returns true if the state lies within the tolerance region of the current goal.
+     */
+    bool isWithinGoalRegion(int x, int y, int theta);
+
+    /**
+     * Returns true if the transition has been added by this environment
+     * and is not backed by a motion primitive. Used to strip the last
+     * transition of a found path.
+     */
+    bool isVirtualGoalTransition(int source_state_id, int target_state_id);
+
+    using EnvironmentNAVXYTHETAMLEVLAT::GetSuccs;
+
+    virtual void GetSuccs(int SourceStateID, std::vector<int>* SuccIDV, std::vector<int>* CostV,
+            std::vector<EnvNAVXYTHETALATAction_t*>* actionindexV = NULL);
+
+    virtual void GetPreds(int TargetStateID, std::vector<int>* PredIDV, std::vector<int>* CostV);
+
+    /**
+     * The heuristic is reduced by the costs to traverse the position tolerance,
+     * otherwise it would overestimate the costs of the states close to the region.
+     */
+    virtual int GetGoalHeuristic(int stateID);
+
+ private:
+    double mPosToleranceCells;
+    int mYawToleranceDirs;
+    int mHeuristicReduction;
+};
+
+} // end namespace motion_planning_libraries
+
+#endif // _MOTION_PLANNING_LIBRARIES_SBPL_GOAL_REGION_ENV_HPP_
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iomanip> // std::setprecision
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <map>
 
@@ -73,18 +74,20 @@ struct MotionPrimitivesConfig {
             mMapWidth(100),
             mMapHeight(100),
             mGridSize(0.1),
-            mPrimAccuracy(0.25) {   
+            mPrimAccuracy(0.25),
+            mNumThreads(0) {   
     }
     
-    MotionPrimitivesConfig(Config config, int trav_map_width, int trav_map_height, double grid_size) :
+    MotionPrimitivesConfig(Config const& config, int trav_map_width, int trav_map_height, double grid_size) :
         mMobility(config.mMobility),
         mNumPrimPartition(config.mNumPrimPartition),
         mNumPosesPerPrim(config.mNumIntermediatePoints + 2), // intermediate points + start pose + end pose
-        mNumAngles(16),
+        mNumAngles(config.mNumAngles),
         mMapWidth(trav_map_width),
         mMapHeight(trav_map_height),
         mGridSize(grid_size),
-        mPrimAccuracy(config.mPrimAccuracy) {   
+        mPrimAccuracy(config.mPrimAccuracy),
+        mNumThreads(config.mNumThreads) {   
     }   
     
   public:
@@ -92,12 +95,21 @@ struct MotionPrimitivesConfig {
     double mNumPrimPartition;
     
     unsigned int mNumPosesPerPrim; // Number of points a primitive consists of.
-    unsigned int mNumAngles; // Number of discrete angles (in general 2*M_PI / 16)
+    unsigned int mNumAngles; // Number of discrete angles (in general 2*M_PI / 16), 8, 16, 32 or 64.
     
     unsigned int mMapWidth;
     unsigned int mMapHeight;
     double mGridSize; // Width/length of a grid cell in meter.
     double mPrimAccuracy;
+    unsigned int mNumThreads; // Threads used to create the primitives, 0 uses all cores.
+    
+    /**
+     * SBPL only supports lattices whose number of angles is a power of two,
+     * the generator has been tested with 8, 16, 32 and 64 discrete angles.
+     */
+    static bool isSupportedNumAngles(unsigned int num_angles) {
+        return num_angles == 8 || num_angles == 16 || num_angles == 32 || num_angles == 64;
+    }
 };
 
 /**
@@ -173,11 +185,11 @@ struct Primitive {
         mEndPose[2] = discrete_theta;
     }
         
-    int getDiscreteEndOrientationNotTruncated() {
+    int getDiscreteEndOrientationNotTruncated() const {
         return mDiscreteEndOrientationNotTruncated;
     }
     
-    std::string toString() {
+    std::string toString() const {
         std::stringstream ss;
         std::string mov_type_name = "Unknown";
         if((int)mMovType < MOV_NUM_TYPES) {
@@ -236,13 +248,30 @@ struct SbplMotionPrimitives {
      */
     std::vector<struct Primitive> createMPrims(std::vector<struct Primitive> prims_angle_0);
     
+    /**
+     * Creates the discrete primitives for a single start angle. Does not 
+     * access any members except the configuration, so all angles can be
+     * processed in parallel. The debug output is written to the passed stream.
+     */
+    void createMPrimsForAngle(const std::vector<struct Primitive>& prims_angle_0, 
+            unsigned int angle,
+            std::vector<struct Primitive>& prims,
+            std::vector<struct PrimIDInfo>& prim_id_infos,
+            std::stringstream& ss);
+    
     /**
      * Runs through all the discrete motion primitives and adds the
      * non discrete intermediate poses. This is done with the non truncated
      * end orientation stored within the primitive structure.
+     * The primitives are processed in parallel.
      */
     void createIntermediatePoses(std::vector<struct Primitive>& discrete_mprims);
     
+    /**
+     * Adds the intermediate poses to a single primitive.
+     */
+    void createIntermediatePosesForPrim(struct Primitive& prim, std::stringstream& ss);
+    
     void storeToFile(std::string path);
     
     /**
@@ -300,6 +329,18 @@ struct SbplMotionPrimitives {
      * Prints all primitive informations including the assigned speed.
      */
     std::string toString();
+    
+ private:
+    // Task functions used by ParallelFor, write into the buffers of the passed index.
+    void createMPrimsForAngleTask(size_t angle,
+            const std::vector<struct Primitive>& prims_angle_0,
+            std::vector< std::vector<struct Primitive> >& prims_per_angle,
+            std::vector< std::vector<struct PrimIDInfo> >& infos_per_angle,
+            std::vector< std::string >& logs_per_angle);
+    
+    void createIntermediatePosesTask(size_t prim_idx,
+            std::vector<struct Primitive>& discrete_mprims,
+            std::vector< std::string >& logs_per_prim);
 };
 
 } // end namespace motion_planning_libraries
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <base/Time.hpp>
+
+#include <motion_planning_libraries/ompl/datastructures/GridNearestNeighbors.hpp>
+
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/datastructures/NearestNeighborsGNAT.h>
+
+using namespace motion_planning_libraries;
+
+// Element type of the benchmark, like the Motion of the OMPL planners.
+struct NNMotion {
+    ompl::base::State* state;
+};
+
+double nnMotionDistance(const ompl::base::StateSpacePtr& space, NNMotion* const& m1, NNMotion* const& m2) {
+    return space->distance(m1->state, m2->state);
+}
+
+/**
+ * Adds the motions and runs the k-nearest and radius queries which are used by RRT*.
+ * Returns the sum of the neighbor distances to compare the results.
+ */
+double runNearestNeighbors(ompl::NearestNeighbors<NNMotion*>& nn, 
+        const ompl::base::StateSpacePtr& space,
+        std::vector<NNMotion*>& motions, std::vector<NNMotion*>& queries, 
+        double& add_time, double& query_time) {
+    nn.setDistanceFunction(boost::bind(&nnMotionDistance, space, _1, _2));
+    base::Time start_time = base::Time::now();
+    for(unsigned int i=0; i<motions.size(); ++i) {
+        nn.add(motions[i]);
+    }
+    add_time = (base::Time::now() - start_time).toSeconds();
+    
+    double dist_sum = 0.0;
+    std::vector<NNMotion*> nbh;
+    start_time = base::Time::now();
+    for(unsigned int i=0; i<queries.size(); ++i) {
+        nn.nearestK(queries[i], 10, nbh);
+        for(unsigned int n=0; n<nbh.size(); ++n) {
+            dist_sum += space->distance(queries[i]->state, nbh[n]->state);
+        }
+        nn.nearestR(queries[i], 1.0, nbh);
+        for(unsigned int n=0; n<nbh.size(); ++n) {
+            dist_sum += space->distance(queries[i]->state, nbh[n]->state);
+        }
+    }
+    query_time = (base::Time::now() - start_time).toSeconds();
+    return dist_sum;
+}
+
+/**
+ * Compares the bucket grid with GNAT (OMPL default) on uniformly distributed 
+ * states within a 100x100 grid.
+ */
+int main(int argc, char** argv)
+{
+    ompl::base::StateSpacePtr space(new ompl::base::RealVectorStateSpace(2));
+    ompl::base::RealVectorBounds bounds(2);
+    bounds.setLow(0);
+    bounds.setHigh(100);
+    space->as<ompl::base::RealVectorStateSpace>()->setBounds(bounds);
+    ompl::base::StateSamplerPtr sampler = space->allocStateSampler();
+    
+    const unsigned int num_queries = 1000;
+    unsigned int sizes[] = {10000, 100000, 1000000};
+    for(unsigned int i=0; i<3; ++i) {
+        std::vector<NNMotion*> motions(sizes[i]);
+        std::vector<NNMotion*> queries(num_queries);
+        for(unsigned int m=0; m<motions.size(); ++m) {
+            motions[m] = new NNMotion();
+            motions[m]->state = space->allocState();
+            sampler->sampleUniform(motions[m]->state);
+        }
+        for(unsigned int q=0; q<queries.size(); ++q) {
+            queries[q] = new NNMotion();
+            queries[q]->state = space->allocState();
+            sampler->sampleUniform(queries[q]->state);
+        }
+        
+        double gnat_add = 0, gnat_query = 0, grid_add = 0, grid_query = 0;
+        ompl::NearestNeighborsGNAT<NNMotion*> gnat;
+        double gnat_sum = runNearestNeighbors(gnat, space, motions, queries, gnat_add, gnat_query);
+        XYGridNearestNeighbors<NNMotion*> grid;
+        double grid_sum = runNearestNeighbors(grid, space, motions, queries, grid_add, grid_query);
+        
+        std::cout << sizes[i] << " vertices, add / " << num_queries << " queries: GNAT " << 
+                gnat_add << " / " << gnat_query << " sec, grid " << 
+                grid_add << " / " << grid_query << " sec, distance sums " << 
+                gnat_sum << " / " << grid_sum << std::endl;
+        
+        for(unsigned int m=0; m<motions.size(); ++m) {
+            space->freeState(motions[m]->state);
+            delete motions[m];
+        }
+        for(unsigned int q=0; q<queries.size(); ++q) {
+            space->freeState(queries[q]->state);
+            delete queries[q];
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+#include <new>
+
+#include <boost/atomic.hpp>
+
+#include <motion_planning_libraries/MotionPlanningLibraries.hpp>
+
+#include <envire/core/Environment.hpp>
+#include <envire/maps/TraversabilityGrid.hpp>
+
+using namespace motion_planning_libraries;
+
+// Counts the heap allocations of this test binary, used to check that the
+// replanning cycle does not allocate memory. Kept in its own binary, so 
+// the other tests run with the default allocator.
+static boost::atomic<unsigned long> gNumAllocations(0);
+
+void* operator new(std::size_t size) {
+    ++gNumAllocations;
+    void* p = malloc(size ? size : 1);
+    if(p == NULL) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) throw() {
+    free(p);
+}
+
+void operator delete[](void* p) throw() {
+    free(p);
+}
+
+struct AllocationFixture {
+    AllocationFixture(){
+        env = new  envire::Environment();
+        trav = new envire::TraversabilityGrid(100, 100, 0.1, 0.1);
+        trav->setTraversabilityClass(0, envire::TraversabilityClass(0.5)); // driveability of unknown
+        trav->setTraversabilityClass(1, envire::TraversabilityClass(0.0)); // driveability of obstacles
+        trav->setUniqueId("/trav_map");
+        env->attachItem(trav);
+        envire::FrameNode* frame_node = new envire::FrameNode();
+        env->getRootNode()->addChild(frame_node);
+        trav->setFrameNode(frame_node);
+
+        rbs_start.setPose(base::Pose(base::Position(1,1,0), base::Orientation::Identity()));
+        rbs_goal.setPose(base::Pose(base::Position(9,9,0), base::Orientation::Identity()));
+    }
+    
+    ~AllocationFixture() { 
+        delete env;
+    }
+    envire::Environment* env;
+    envire::TraversabilityGrid* trav;
+    Config conf;
+    base::samples::RigidBodyState rbs_start;
+    base::samples::RigidBodyState rbs_goal;
+};
+
+BOOST_FIXTURE_TEST_SUITE( allocations, AllocationFixture )
+
+BOOST_AUTO_TEST_CASE(sbpl_xy_allocation_free_replanning_cycle)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XY;
+    conf.mSearchUntilFirstSolution = false;
+    MotionPlanningLibraries sbpl(conf);
+    BOOST_REQUIRE(sbpl.setTravGrid(env, "/trav_map"));
+    BOOST_CHECK(sbpl.setStartState(State(rbs_start)));
+    BOOST_CHECK(sbpl.setGoalState(State(rbs_goal)));
+    double cost = 0.0;
+    BOOST_REQUIRE(sbpl.plan(10.0, cost));
+    BOOST_REQUIRE(sbpl.foundFinalSolution());
+    
+    // Warm-up, the output buffers reach the path size.
+    std::vector<base::Waypoint> waypoints;
+    std::vector<struct State> states;
+    sbpl.getPathInWorld(waypoints);
+    sbpl.getStatesInWorld(states);
+    
+    // New start pose (within the start cell), replanning check and path output.
+    // plan() returns before the search, see sbpl_xy_replanning_across_cells.
+    base::samples::RigidBodyState rbs_robot = rbs_start;
+    unsigned long num_allocations = gNumAllocations.load();
+    for(unsigned int i=0; i<10; ++i) {
+        rbs_robot.position.x() = rbs_start.position.x() + i * 0.005;
+        BOOST_CHECK(sbpl.setStartState(State(rbs_robot)));
+        BOOST_CHECK(!sbpl.plan(10.0, cost));
+        BOOST_CHECK_EQUAL(sbpl.getError(), MPL_ERR_REPLANNING_NOT_REQUIRED);
+        sbpl.getPathInWorld(waypoints);
+        sbpl.getStatesInWorld(states);
+    }
+    BOOST_CHECK_EQUAL(gNumAllocations.load() - num_allocations, 0u);
+    BOOST_CHECK_EQUAL(waypoints.size(), sbpl.getCompactPathInWorld().size());
+    BOOST_CHECK_EQUAL(states.size(), sbpl.getCompactPathInWorld().size());
+}
+
+// The searches of SBPL (e.g. the successor vectors of each expansion and the 
+// extracted state id path) allocate internally, so a plan() which really plans 
+// is not allocation-free. Only the code of this library is checked: Setting
+// a start pose within another cell and the path output.
+BOOST_AUTO_TEST_CASE(sbpl_xy_replanning_across_cells)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XY;
+    conf.mSearchUntilFirstSolution = false;
+    conf.mReplanning.mReplanOnNewStartPose = true;
+    MotionPlanningLibraries sbpl(conf);
+    BOOST_REQUIRE(sbpl.setTravGrid(env, "/trav_map"));
+    BOOST_CHECK(sbpl.setStartState(State(rbs_start)));
+    BOOST_CHECK(sbpl.setGoalState(State(rbs_goal)));
+    double cost = 0.0;
+    BOOST_REQUIRE(sbpl.plan(10.0, cost));
+    
+    // Warm-up, the robot moves towards the goal so the following paths are shorter.
+    std::vector<base::Waypoint> waypoints;
+    std::vector<struct State> states;
+    sbpl.getPathInWorld(waypoints);
+    sbpl.getStatesInWorld(states);
+    
+    base::samples::RigidBodyState rbs_robot = rbs_start;
+    unsigned long num_allocations_mpl = 0;
+    for(unsigned int i=1; i<=10; ++i) {
+        // One cell (0.1 m) further in x and y.
+        rbs_robot.position.x() = rbs_start.position.x() + i * 0.1;
+        rbs_robot.position.y() = rbs_start.position.y() + i * 0.1;
+        unsigned long num_allocations = gNumAllocations.load();
+        BOOST_CHECK(sbpl.setStartState(State(rbs_robot)));
+        num_allocations_mpl += gNumAllocations.load() - num_allocations;
+        
+        BOOST_CHECK(sbpl.plan(10.0, cost));
+        BOOST_CHECK_EQUAL(sbpl.getError(), MPL_ERR_NONE);
+        
+        num_allocations = gNumAllocations.load();
+        sbpl.getPathInWorld(waypoints);
+        sbpl.getStatesInWorld(states);
+        num_allocations_mpl += gNumAllocations.load() - num_allocations;
+    }
+    BOOST_CHECK_EQUAL(num_allocations_mpl, 0u);
+    BOOST_CHECK_EQUAL(waypoints.size(), sbpl.getCompactPathInWorld().size());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
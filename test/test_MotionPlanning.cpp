@@ -1,11 +1,29 @@
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
+
+#include <boost/bind.hpp>
 
 #include <motion_planning_libraries/MotionPlanningLibraries.hpp>
 #include <motion_planning_libraries/Helpers.hpp>
+#include <motion_planning_libraries/CompactPath.hpp>
+#include <motion_planning_libraries/Mailbox.hpp>
+#include <motion_planning_libraries/Parallel.hpp>
+#include <motion_planning_libraries/PreprocessedMap.hpp>
 #include <motion_planning_libraries/sbpl/SbplMotionPrimitives.hpp>
+#include <motion_planning_libraries/ompl/spaces/SherpaStateSpace.hpp>
+#include <motion_planning_libraries/ompl/datastructures/GridNearestNeighbors.hpp>
+#include <motion_planning_libraries/ompl/samplers/FreeCellStateSampler.hpp>
+#include <motion_planning_libraries/ompl/planners/WarmStartRRTstar.hpp>
+#include <motion_planning_libraries/ompl/validators/TravMapValidator.hpp>
+
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/base/ScopedState.h>
+#include <ompl/base/objectives/PathLengthOptimizationObjective.h>
+#include <ompl/datastructures/NearestNeighborsLinear.h>
 
 #include <envire/core/Environment.hpp>
 #include <envire/maps/TraversabilityGrid.hpp>
@@ -36,6 +54,46 @@ struct Fixture {
     ~Fixture() { 
         delete env;
     }
+    
+    /**
+     * Passes the map, start and goal to the planner.
+     */
+    void setupQuery(MotionPlanningLibraries& mpl) {
+        mpl.setTravGrid(env, "/trav_map");
+        mpl.setStartState(State(rbs_start));
+        mpl.setGoalState(State(rbs_goal));
+    }
+    
+    /**
+     * Blocks a 1 x 1 m square in the center of the map.
+     */
+    void addCenterObstacle() {
+        GridCalculations calc;
+        calc.setTravGrid(trav, trav_data);
+        calc.setFootprintRectangleInGrid(10, 10); // length, width
+        calc.setFootprintPoseInGrid(50, 50, 0); // x, y, theta
+        calc.setValue(1); // obstacle
+    }
+    
+    /**
+     * Checks the cells along the path (world equals the grid frame) in steps of 
+     * half a cell for obstacles.
+     */
+    bool isPathFree(std::vector<base::Waypoint> const& path) {
+        for(unsigned int i=1; i<path.size(); ++i) {
+            base::Vector3d diff = path[i].position - path[i-1].position;
+            int num_steps = std::max(1, (int)(diff.head(2).norm() / 0.05));
+            for(int j=0; j<=num_steps; ++j) {
+                base::Vector3d pos = path[i-1].position + diff * ((double)j / num_steps);
+                size_t x = 0, y = 0;
+                if(!trav->toGrid(pos.x(), pos.y(), x, y) || (*trav_data)[y][x] == 1) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    
     envire::Environment* env;
     envire::TraversabilityGrid* trav;
     boost::shared_ptr<TravData> trav_data;
@@ -44,6 +102,83 @@ struct Fixture {
     base::samples::RigidBodyState rbs_goal;
 };
 
+struct SolutionCollector {
+    std::vector<double> mCosts;
+    size_t mLastPathSize;
+    double mLastPathLength;
+    base::Time mFirstSolutionTime;
+    
+    SolutionCollector() : mCosts(), mLastPathSize(0), mLastPathLength(0.0), 
+            mFirstSolutionTime() {
+    }
+    
+    void callback(const std::vector<struct State>& path_in_world, double cost) {
+        if(mCosts.empty()) {
+            mFirstSolutionTime = base::Time::now();
+        }
+        mCosts.push_back(cost);
+        mLastPathSize = path_in_world.size();
+        mLastPathLength = 0.0;
+        for(unsigned int i=1; i<path_in_world.size(); ++i) {
+            mLastPathLength += (path_in_world[i].getPose().position - 
+                    path_in_world[i-1].getPose().position).norm();
+        }
+    }
+    
+    /**
+     * An optimizing planner must only report improved solutions.
+     */
+    bool isImproving() const {
+        for(unsigned int i=1; i<mCosts.size(); ++i) {
+            if(mCosts[i] > mCosts[i-1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * Task of the state pool test, allocates num_blocks blocks within a worker thread.
+ */
+void allocatePoolBlocks(StatePool* pool, std::vector< std::vector<void*> >* blocks, 
+        size_t num_blocks, size_t task_id) {
+    for(size_t i=0; i<num_blocks; ++i) {
+        (*blocks)[task_id].push_back(pool->allocate());
+    }
+}
+
+// Element type of the nearest neighbor test, like the Motion of the OMPL planners.
+struct NNMotion {
+    ompl::base::State* state;
+};
+
+double nnMotionDistance(const ompl::base::StateSpacePtr& space, NNMotion* const& m1, NNMotion* const& m2) {
+    return space->distance(m1->state, m2->state);
+}
+
+/**
+ * Sorted distances of the found neighbors to the query.
+ */
+std::vector<double> nnDistances(const ompl::base::StateSpacePtr& space, NNMotion* query, 
+        const std::vector<NNMotion*>& nbh) {
+    std::vector<double> distances;
+    for(unsigned int n=0; n<nbh.size(); ++n) {
+        distances.push_back(space->distance(query->state, nbh[n]->state));
+    }
+    std::sort(distances.begin(), distances.end());
+    return distances;
+}
+
+/**
+ * Producer of the mailbox test, posts 1..num_values.
+ */
+void postMailboxValues(Mailbox<std::pair<int,int> >* mailbox, int num_values) {
+    for(int i=1; i<=num_values; ++i) {
+        mailbox->post(std::pair<int,int>(i, -i));
+    }
+}
+
 BOOST_FIXTURE_TEST_SUITE( s, Fixture )
 
 BOOST_AUTO_TEST_CASE(sbpl_mprims)
@@ -71,7 +206,1156 @@ BOOST_AUTO_TEST_CASE(sbpl_mprims)
     mprims.createPrimitives();
     mprims.storeToFile("test.mprim");
 }
+
+// The parallel primitive generation has to create the same primitives 
+// (same order) like the sequential one.
+BOOST_AUTO_TEST_CASE(sbpl_mprims_parallel)
+{
+    struct MotionPrimitivesConfig config;
+    config.mMobility.mSpeed = 1.0;
+    config.mMobility.mTurningSpeed = 0.1;
+    config.mMobility.mMinTurningRadius = 1.0;
+    config.mMobility.mMultiplierForward = 1;
+    config.mMobility.mMultiplierBackward = 2;
+    config.mMobility.mMultiplierForwardTurn = 4;
+    config.mMobility.mMultiplierPointTurn = 5;
+    config.mNumPrimPartition = 4;
+    config.mNumPosesPerPrim = 20;
+    config.mNumAngles = 32;
+    
+    config.mNumThreads = 1;
+    SbplMotionPrimitives mprims_seq(config);
+    base::Time start_time = base::Time::now();
+    mprims_seq.createPrimitives();
+    double time_seq = (base::Time::now() - start_time).toSeconds();
+    
+    config.mNumThreads = 4;
+    SbplMotionPrimitives mprims_par(config);
+    start_time = base::Time::now();
+    mprims_par.createPrimitives();
+    double time_par = (base::Time::now() - start_time).toSeconds();
+    
+    std::cout << "Primitive generation sequential " << time_seq << 
+            " sec, 4 threads " << time_par << " sec" << std::endl;
+    
+    BOOST_REQUIRE_EQUAL(mprims_seq.mListPrimitives.size(), mprims_par.mListPrimitives.size());
+    BOOST_CHECK_EQUAL(mprims_seq.mPrimIDInfos.size(), mprims_par.mPrimIDInfos.size());
+    for(unsigned int i=0; i<mprims_seq.mListPrimitives.size(); ++i) {
+        struct Primitive& seq = mprims_seq.mListPrimitives[i];
+        struct Primitive& par = mprims_par.mListPrimitives[i];
+        BOOST_CHECK_EQUAL(seq.mId, par.mId);
+        BOOST_CHECK_EQUAL(seq.mStartAngle, par.mStartAngle);
+        BOOST_CHECK(seq.mEndPose == par.mEndPose);
+        BOOST_REQUIRE_EQUAL(seq.mIntermediatePoses.size(), par.mIntermediatePoses.size());
+        for(unsigned int j=0; j<seq.mIntermediatePoses.size(); ++j) {
+            BOOST_CHECK(seq.mIntermediatePoses[j] == par.mIntermediatePoses[j]);
+        }
+    }
+}
+
+// Each epsilon step of the SBPL anytime planner has to be reported.
+BOOST_AUTO_TEST_CASE(sbpl_xytheta_solution_callback)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XYTHETA;
+    conf.mSearchUntilFirstSolution = false;
+    conf.mMobility.mSpeed = 1.0;
+    conf.mMobility.mTurningSpeed = 0.5;
+    conf.mMobility.mMinTurningRadius = 0.5;
+    conf.mMobility.mMultiplierForward = 1;
+    conf.mMobility.mMultiplierForwardTurn = 2;
+    conf.mMobility.mMultiplierPointTurn = 4;
+    conf.mFootprintLengthMinMax = std::pair<double,double>(0.3, 0.3);
+    conf.mFootprintWidthMinMax = std::pair<double,double>(0.3, 0.3);
+    
+    MotionPlanningLibraries sbpl(conf);
+    sbpl.setTravGrid(env, "/trav_map");
+    sbpl.setStartState(State(rbs_start));
+    sbpl.setGoalState(State(rbs_goal));
+    
+    SolutionCollector collector;
+    double cost = 0.0;
+    BOOST_CHECK(sbpl.plan(2.0, cost, boost::bind(&SolutionCollector::callback, &collector, _1, _2)));
+    BOOST_REQUIRE(collector.mCosts.size() > 0);
+    BOOST_CHECK(collector.mLastPathSize > 0);
+    BOOST_CHECK_EQUAL(collector.mCosts.back(), cost);
+    std::cout << collector.mCosts.size() << " improved solutions have been reported" << std::endl;
+}
+
+// A moving robot with a fixed goal should switch AD* to backward search.
+BOOST_AUTO_TEST_CASE(sbpl_xy_auto_search_direction)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XY;
+    conf.mPlanner = ANYTIME_DSTAR;
+    conf.mSBPLAutoSearchDirection = true;
+    conf.mReplanning.mReplanOnNewStartPose = true;
+    conf.mReplanning.mReplanOnNewGoalPose = true;
+    conf.mFootprintRadiusMinMax = std::pair<double,double>(0.2, 0.2);
+    
+    MotionPlanningLibraries sbpl(conf);
+    sbpl.setTravGrid(env, "/trav_map");
+    sbpl.setGoalState(State(rbs_goal));
+    BOOST_CHECK(sbpl.isForwardSearch());
+    
+    // Moving robot: Searches from the goal to the robot.
+    double cost = 0.0;
+    for(int i=0; i<10; ++i) {
+        rbs_start.position = base::Position(1 + i * 0.3, 1, 0);
+        sbpl.setStartState(State(rbs_start));
+        BOOST_CHECK(sbpl.plan(1.0, cost));
+        std::cout << "Start " << rbs_start.position.transpose() << ", cost " << cost << 
+                ", expansions " << sbpl.getNumExpansions() << std::endl;
+    }
+    BOOST_CHECK(!sbpl.isForwardSearch());
+    
+    // Moving goal: Back to the forward search.
+    for(int i=0; i<10; ++i) {
+        rbs_goal.position = base::Position(9, 9 - i * 0.3, 0);
+        sbpl.setGoalState(State(rbs_goal));
+        BOOST_CHECK(sbpl.plan(1.0, cost));
+    }
+    BOOST_CHECK(sbpl.isForwardSearch());
+}
+
+// A goal region has to reduce the number of expansions and the path
+// has to end within the tolerances.
+BOOST_AUTO_TEST_CASE(sbpl_xytheta_goal_tolerance)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XYTHETA;
+    conf.mMobility.mSpeed = 1.0;
+    conf.mMobility.mTurningSpeed = 0.5;
+    conf.mMobility.mMinTurningRadius = 0.5;
+    conf.mMobility.mMultiplierForward = 1;
+    conf.mMobility.mMultiplierForwardTurn = 2;
+    conf.mMobility.mMultiplierPointTurn = 4;
+    conf.mFootprintLengthMinMax = std::pair<double,double>(0.3, 0.3);
+    conf.mFootprintWidthMinMax = std::pair<double,double>(0.3, 0.3);
+    rbs_goal.orientation = Eigen::AngleAxis<double>(M_PI/2.0, base::Vector3d::UnitZ());
+    
+    double tolerances[] = {0.0, 0.3};
+    for(unsigned int i=0; i<2; ++i) {
+        conf.mGoalPosTolerance = tolerances[i];
+        conf.mGoalYawTolerance = tolerances[i] > 0 ? M_PI/4.0 : 0.0;
+        
+        MotionPlanningLibraries sbpl(conf);
+        sbpl.setTravGrid(env, "/trav_map");
+        sbpl.setStartState(State(rbs_start));
+        sbpl.setGoalState(State(rbs_goal));
+        
+        double cost = 0.0;
+        BOOST_REQUIRE(sbpl.plan(10, cost));
+        std::vector<base::Waypoint> path = sbpl.getPathInWorld();
+        BOOST_REQUIRE(path.size() > 0);
+        double dist = (path.back().position - rbs_goal.position).head(2).norm();
+        BOOST_CHECK(dist <= 0.2 + conf.mGoalPosTolerance);
+        std::cout << "Goal tolerance " << conf.mGoalPosTolerance << " m: expansions " << 
+                sbpl.getNumExpansions() << ", cost " << cost << 
+                ", distance to goal " << dist << std::endl;
+    }
+}
+
+// Compares planning time, expansions and path quality of the different 
+// angular resolutions of the generated SBPL primitives.
+BOOST_AUTO_TEST_CASE(sbpl_xytheta_num_angles_benchmark)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XYTHETA;
+    conf.mMobility.mSpeed = 1.0;
+    conf.mMobility.mTurningSpeed = 0.5;
+    conf.mMobility.mMinTurningRadius = 0.5;
+    conf.mMobility.mMultiplierForward = 1;
+    conf.mMobility.mMultiplierBackward = 2;
+    conf.mMobility.mMultiplierForwardTurn = 2;
+    conf.mMobility.mMultiplierPointTurn = 4;
+    conf.mFootprintLengthMinMax = std::pair<double,double>(0.3, 0.3);
+    conf.mFootprintWidthMinMax = std::pair<double,double>(0.3, 0.3);
+    
+    unsigned int num_angles[] = {8, 16, 32, 64};
+    for(unsigned int i=0; i<4; ++i) {
+        conf.mNumAngles = num_angles[i];
+        
+        MotionPlanningLibraries sbpl(conf);
+        sbpl.setTravGrid(env, "/trav_map");
+        sbpl.setStartState(State(rbs_start));
+        sbpl.setGoalState(State(rbs_goal));
+        
+        double cost = 0.0;
+        base::Time start_time = base::Time::now();
+        bool solved = sbpl.plan(10, cost);
+        double planning_time = (base::Time::now() - start_time).toSeconds();
+        BOOST_CHECK(solved);
+        
+        std::vector<base::Waypoint> path = sbpl.getPathInWorld();
+        double path_length = 0.0;
+        for(unsigned int j=1; j<path.size(); ++j) {
+            path_length += (path[j].position - path[j-1].position).norm();
+        }
+        
+        std::cout << conf.mNumAngles << " angles: time " << planning_time << 
+                " sec, expansions " << sbpl.getNumExpansions() << 
+                ", cost " << cost << ", path length " << path_length << 
+                " m, waypoints " << path.size() << std::endl;
+    }
+}
+    
+// The parallel planners have to find a solution around the obstacle and
+// must only report improvements of the shared best solution.
+BOOST_AUTO_TEST_CASE(ompl_xy_parallel_planners)
+{
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_XY;
+    conf.mSearchUntilFirstSolution = false;
+    addCenterObstacle();
+    
+    unsigned int num_planners[] = {1, 4};
+    for(unsigned int i=0; i<2; ++i) {
+        conf.mOmplNumParallelPlanners = num_planners[i];
+        
+        MotionPlanningLibraries ompl(conf);
+        setupQuery(ompl);
+        
+        SolutionCollector collector;
+        double cost = 0.0;
+        BOOST_CHECK(ompl.plan(0.5, cost, boost::bind(&SolutionCollector::callback, &collector, _1, _2)));
+        BOOST_REQUIRE(collector.mCosts.size() > 0);
+        BOOST_CHECK(collector.isImproving());
+        BOOST_CHECK(cost <= collector.mCosts.front());
+        BOOST_CHECK(ompl.getPathInWorld().size() > 1);
+    }
+}
+
+// Each selectable geometric OMPL planner has to be created and has to 
+// solve the query within a short time, the optimizing ones must only 
+// report improvements.
+BOOST_AUTO_TEST_CASE(ompl_xy_planners)
+{
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_XY;
+    conf.mSearchUntilFirstSolution = false;
+    conf.mMaxAllowedSampleDist = 5.0;
+    conf.mOmplGoalBias = 0.1;
+    
+    enum Planners planners[] = {RRT_STAR, INFORMED_RRT_STAR, BIT_STAR, RRT_SHARP, 
+            PRM_STAR, LAZY_PRM_STAR, KPIECE};
+    for(unsigned int i=0; i<7; ++i) {
+        conf.mPlanner = planners[i];
+        
+        MotionPlanningLibraries ompl(conf);
+        setupQuery(ompl);
+        
+        SolutionCollector collector;
+        double cost = 0.0;
+        BOOST_CHECK_MESSAGE(ompl.plan(0.3, cost, boost::bind(&SolutionCollector::callback, &collector, _1, _2)), 
+                "Planner " << planners[i] << " has not found a solution");
+        BOOST_CHECK(ompl.getPathInWorld().size() > 1);
+        BOOST_CHECK(collector.isImproving());
+    }
+}
+
+// After the first query has built the roadmap, the following queries on the 
+// same map continue it. A stored roadmap is loaded for the same map.
+BOOST_AUTO_TEST_CASE(ompl_xy_multi_query)
+{
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_XY;
+    conf.mOmplMultiQuery = true;
+    char roadmap_file[] = "/tmp/mpl_test_roadmap_XXXXXX";
+    int fd = mkstemp(roadmap_file);
+    BOOST_REQUIRE(fd != -1);
+    close(fd);
+    conf.mOmplRoadmapFile = roadmap_file;
+    
+    MotionPlanningLibraries ompl(conf);
+    ompl.setTravGrid(env, "/trav_map");
+    
+    double cost = 0.0;
+    unsigned int num_vertices = 0;
+    for(int i=0; i<5; ++i) {
+        rbs_start.position = base::Position(1 + i, 1, 0);
+        rbs_goal.position = base::Position(9 - i, 9, 0);
+        ompl.setStartState(State(rbs_start));
+        ompl.setGoalState(State(rbs_goal));
+        
+        BOOST_CHECK(ompl.plan(2.0, cost));
+        // The roadmap is not cleared between the queries.
+        BOOST_CHECK(ompl.getNumRoadmapVertices() >= num_vertices);
+        num_vertices = ompl.getNumRoadmapVertices();
+    }
+    BOOST_REQUIRE(num_vertices > 0);
+    BOOST_CHECK(ompl.saveRoadmap());
+    
+    // A new map with the same content reuses the roadmap of the planner,
+    // a new roadmap would not contain any vertices before the first query.
+    ompl.setTravGrid(env, "/trav_map");
+    BOOST_CHECK(ompl.getNumRoadmapVertices() > 0);
+    
+    // The stored roadmap belongs to the same map and is loaded.
+    MotionPlanningLibraries ompl_loaded(conf);
+    ompl_loaded.setTravGrid(env, "/trav_map");
+    BOOST_CHECK(ompl_loaded.getNumRoadmapVertices() > 0);
+    ompl_loaded.setStartState(State(rbs_start));
+    ompl_loaded.setGoalState(State(rbs_goal));
+    BOOST_CHECK(ompl_loaded.plan(2.0, cost));
+    
+    remove(roadmap_file);
+    remove((std::string(roadmap_file) + ".mapid").c_str());
+}
+
+// After a small start change the warm started RRT* has to find a solution 
+// again and must only report improvements.
+BOOST_AUTO_TEST_CASE(ompl_xy_warm_start)
+{
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_XY;
+    conf.mSearchUntilFirstSolution = false;
+    conf.mOmplWarmStart = true;
+    
+    MotionPlanningLibraries ompl(conf);
+    setupQuery(ompl);
+    double cost = 0.0;
+    BOOST_REQUIRE(ompl.plan(0.5, cost));
+    
+    rbs_start.position += base::Position(0.3, 0.2, 0);
+    ompl.setStartState(State(rbs_start));
+    
+    SolutionCollector collector;
+    BOOST_CHECK(ompl.plan(0.5, cost, boost::bind(&SolutionCollector::callback, &collector, _1, _2)));
+    BOOST_REQUIRE(collector.mCosts.size() > 0);
+    BOOST_CHECK(collector.isImproving());
+}
+
+#if OMPL_VERSION_VALUE >= 1001000
+// A seed path which reaches the goal bounds the costs of the search, 
+// the solution must not be worse than the seed.
+BOOST_AUTO_TEST_CASE(ompl_warm_start_rrtstar_seed_cost)
+{
+    ompl::base::StateSpacePtr space(new ompl::base::RealVectorStateSpace(2));
+    ompl::base::RealVectorBounds bounds(2);
+    bounds.setLow(0);
+    bounds.setHigh(10);
+    space->as<ompl::base::RealVectorStateSpace>()->setBounds(bounds);
+    ompl::base::SpaceInformationPtr si(new ompl::base::SpaceInformation(space));
+    si->setStateValidityChecker(ompl::base::StateValidityCheckerPtr(
+            new ompl::base::AllValidStateValidityChecker(si)));
+    si->setup();
+    
+    ompl::base::ScopedState<> start(space), goal(space), corner(space);
+    start[0] = 1; start[1] = 1;
+    goal[0] = 9; goal[1] = 9;
+    corner[0] = 1; corner[1] = 9;
+    ompl::base::ProblemDefinitionPtr pdef(new ompl::base::ProblemDefinition(si));
+    pdef->setStartAndGoalStates(start, goal);
+    pdef->setOptimizationObjective(ompl::base::OptimizationObjectivePtr(
+            new ompl::base::PathLengthOptimizationObjective(si)));
+    
+    // Detour along the border of the map with costs 16.
+    std::vector<ompl::base::State*> seed;
+    seed.push_back(start.get());
+    seed.push_back(corner.get());
+    seed.push_back(goal.get());
+    double seed_cost = 16.0;
+    
+    WarmStartRRTstar planner(si);
+    planner.setProblemDefinition(pdef);
+    planner.setup();
+    planner.setSeedPath(seed);
+    BOOST_REQUIRE(planner.solve(0.1));
+    BOOST_REQUIRE(pdef->hasExactSolution());
+    double cost = pdef->getSolutionPath()->cost(pdef->getOptimizationObjective()).value();
+    BOOST_CHECK(cost <= seed_cost + 1e-6);
+}
+#endif
+
+// The closed-form Dubins and Reeds-Shepp steering has to reach the goal 
+// pose within a short time, the ODE based control problem has to provide its 
+// path states as well.
+BOOST_AUTO_TEST_CASE(ompl_xytheta_steering)
+{
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_XYTHETA;
+    conf.mMobility.mSpeed = 1.0;
+    conf.mMobility.mTurningSpeed = 0.5;
+    conf.mMobility.mMinTurningRadius = 0.5;
+    conf.mFootprintRadiusMinMax = std::pair<double,double>(0.2, 0.2);
+    rbs_goal.orientation = Eigen::AngleAxis<double>(M_PI/2.0, base::Vector3d::UnitZ());
+    
+    enum OmplSteeringType steerings[] = {STEERING_CONTROL, STEERING_DUBINS, STEERING_REEDS_SHEPP};
+    for(unsigned int i=0; i<3; ++i) {
+        conf.mOmplSteering = steerings[i];
+        
+        MotionPlanningLibraries ompl(conf);
+        setupQuery(ompl);
+        
+        double cost = 0.0;
+        bool solved = ompl.plan(1.0, cost);
+        if(steerings[i] == STEERING_CONTROL) {
+            // Approximate solutions are possible within the short time.
+            if(solved) {
+                BOOST_CHECK(ompl.getPathInWorld().size() > 1);
+            }
+            continue;
+        }
+        BOOST_REQUIRE(solved);
+        std::vector<base::Waypoint> path = ompl.getPathInWorld();
+        BOOST_REQUIRE(path.size() > 1);
+        // Interpolated curve instead of the straight connection.
+        BOOST_CHECK(path.size() > 2);
+        BOOST_CHECK_SMALL((path.back().position - rbs_goal.position).head(2).norm(), 0.5);
+    }
+}
+
+// A goal behind the robot with the same heading is reached by driving backwards
+// with Reeds-Shepp, the backward parts receive a negative speed. Dubins only
+// drives forward.
+BOOST_AUTO_TEST_CASE(ompl_xytheta_reeds_shepp_backward)
+{
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_XYTHETA;
+    conf.mMobility.mSpeed = 1.0;
+    conf.mMobility.mTurningSpeed = 0.5;
+    conf.mMobility.mMinTurningRadius = 0.5;
+    conf.mFootprintRadiusMinMax = std::pair<double,double>(0.2, 0.2);
+    rbs_start.position = base::Position(5, 5, 0);
+    rbs_goal.position = base::Position(3, 5, 0);
     
+    enum OmplSteeringType steerings[] = {STEERING_DUBINS, STEERING_REEDS_SHEPP};
+    for(unsigned int i=0; i<2; ++i) {
+        conf.mOmplSteering = steerings[i];
+        
+        MotionPlanningLibraries ompl(conf);
+        setupQuery(ompl);
+        
+        double cost = 0.0;
+        BOOST_REQUIRE(ompl.plan(1.0, cost));
+        std::vector<struct State> states = ompl.getStatesInWorld();
+        BOOST_REQUIRE(states.size() > 2);
+        unsigned int num_backward = 0;
+        for(unsigned int j=0; j+1<states.size(); ++j) {
+            bool backward = states[j].mMovType == MOV_BACKWARD || 
+                    states[j].mMovType == MOV_BACKWARD_TURN;
+            BOOST_CHECK_EQUAL(backward, states[j].mSpeed < 0);
+            if(backward) {
+                num_backward++;
+            }
+        }
+        if(steerings[i] == STEERING_DUBINS) {
+            BOOST_CHECK_EQUAL(num_backward, 0u);
+        } else {
+            BOOST_CHECK(num_backward > 0);
+        }
+    }
+}
+
+// The simplified path should contain fewer waypoints than the raw one, should 
+// not be longer and must not cross the obstacle.
+BOOST_AUTO_TEST_CASE(ompl_xy_path_simplification)
+{
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_XY;
+    conf.mOmplSimplificationTime = 0.5;
+    addCenterObstacle();
+    
+    MotionPlanningLibraries ompl(conf);
+    setupQuery(ompl);
+    
+    // The improved solutions are reported before the simplification, 
+    // so the last one is the raw path of the planner.
+    SolutionCollector collector;
+    double cost = 0.0;
+    BOOST_REQUIRE(ompl.plan(2.0, cost, boost::bind(&SolutionCollector::callback, &collector, _1, _2)));
+    BOOST_REQUIRE(collector.mCosts.size() > 0);
+    
+    std::vector<base::Waypoint> path = ompl.getPathInWorld();
+    double path_length = 0.0;
+    for(unsigned int j=1; j<path.size(); ++j) {
+        path_length += (path[j].position - path[j-1].position).norm();
+    }
+    std::cout << "Raw path: " << collector.mLastPathSize << " waypoints, length " << 
+            collector.mLastPathLength << " m, simplified path: " << path.size() << 
+            " waypoints, length " << path_length << " m" << std::endl;
+    BOOST_CHECK(path.size() < collector.mLastPathSize);
+    BOOST_CHECK(path_length <= collector.mLastPathLength + 1e-6);
+    BOOST_CHECK(isPathFree(path));
+}
+
+// RRT* should stop before max_time if the solution is close to the lower bound
+// or does not improve anymore.
+BOOST_AUTO_TEST_CASE(ompl_xy_early_termination)
+{
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_XY;
+    conf.mSearchUntilFirstSolution = false;
+    conf.mMobility.mSpeed = 1.0;
+    
+    double tolerances[] = {0.0, 0.2, 0.0};
+    double stagnation_times[] = {0.0, 0.0, 0.5};
+    for(unsigned int i=0; i<3; ++i) {
+        conf.mOmplCostTolerance = tolerances[i];
+        conf.mOmplStagnationTime = stagnation_times[i];
+        
+        MotionPlanningLibraries ompl(conf);
+        ompl.setTravGrid(env, "/trav_map");
+        ompl.setStartState(State(rbs_start));
+        ompl.setGoalState(State(rbs_goal));
+        
+        double cost = 0.0;
+        BOOST_REQUIRE(ompl.plan(5.0, cost));
+        if(tolerances[i] > 0 || stagnation_times[i] > 0) {
+            BOOST_CHECK(ompl.getUnusedPlanningTime() > 0.0);
+        } else {
+            // Without a termination policy RRT* uses the complete time.
+            BOOST_CHECK_SMALL(ompl.getUnusedPlanningTime(), 0.1);
+        }
+        std::cout << "Cost tolerance " << tolerances[i] << ", stagnation time " << 
+                stagnation_times[i] << ": cost " << cost << ", unused time " << 
+                ompl.getUnusedPlanningTime() << " sec" << std::endl;
+    }
+}
+
+// Allocates and frees SHERPA states in tree sized batches with and without
+// the state pool, the pooled states have to behave like the heap allocated ones.
+BOOST_AUTO_TEST_CASE(ompl_sherpa_state_pool_benchmark)
+{
+    conf.mNumFootprintClasses = 10;
+    const unsigned int num_states = 100000;
+    const unsigned int num_rounds = 10;
+    
+    bool pooled[] = {false, true};
+    for(unsigned int i=0; i<2; ++i) {
+        conf.mOmplPooledStates = pooled[i];
+        SherpaStateSpace space(conf);
+        std::vector<ompl::base::State*> states(num_states);
+        
+        base::Time start_time = base::Time::now();
+        for(unsigned int round=0; round<num_rounds; ++round) {
+            for(unsigned int s=0; s<num_states; ++s) {
+                states[s] = space.allocState();
+                SherpaStateSpace::StateType* state = states[s]->as<SherpaStateSpace::StateType>();
+                state->setXY(s, round);
+                state->setFootprintClass(s % conf.mNumFootprintClasses);
+            }
+            for(unsigned int s=0; s<num_states; s+=1000) {
+                BOOST_CHECK_EQUAL(states[s]->as<SherpaStateSpace::StateType>()->getX(), s);
+                BOOST_CHECK_EQUAL(states[s]->as<SherpaStateSpace::StateType>()->getFootprintClass(), 
+                        s % conf.mNumFootprintClasses);
+            }
+            ompl::base::State* copy = space.cloneState(states[num_states-1]);
+            BOOST_CHECK(space.equalStates(copy, states[num_states-1]));
+            space.freeState(copy);
+            for(unsigned int s=0; s<num_states; ++s) {
+                space.freeState(states[s]);
+            }
+        }
+        double duration = (base::Time::now() - start_time).toSeconds();
+        
+        if(pooled[i]) {
+            StatePool& pool = space.getStatePool();
+            BOOST_CHECK_EQUAL(pool.getNumAllocatedBlocks(), 0);
+            BOOST_CHECK(pool.getNumArenas() > 0);
+            pool.releaseUnusedArenas();
+            BOOST_CHECK_EQUAL(pool.getNumArenas(), 0);
+        }
+        std::cout << (pooled[i] ? "Pooled" : "Heap") << " states: " << 
+                num_rounds * num_states << " allocations in " << duration << " sec" << std::endl;
+    }
+}
+
+// Blocks allocated within several threads and freed by the main thread 
+// have to return to their sub-pools, so all arenas can be released.
+BOOST_AUTO_TEST_CASE(ompl_state_pool_threads)
+{
+    StatePool pool(3 * sizeof(double), 64);
+    const size_t num_tasks = 16;
+    std::vector< std::vector<void*> > blocks(num_tasks);
+    ParallelFor parallel_for(4);
+    parallel_for.run(num_tasks, boost::bind(&allocatePoolBlocks, &pool, &blocks, 1000, _1));
+    BOOST_CHECK_EQUAL(pool.getNumAllocatedBlocks(), num_tasks * 1000);
+    
+    for(size_t t=0; t<num_tasks; ++t) {
+        for(size_t i=0; i<blocks[t].size(); ++i) {
+            pool.deallocate(blocks[t][i]);
+        }
+    }
+    BOOST_CHECK_EQUAL(pool.getNumAllocatedBlocks(), 0);
+    BOOST_CHECK(pool.releaseUnusedArenas() > 0);
+    BOOST_CHECK_EQUAL(pool.getNumArenas(), 0);
+}
+
+// The bucket grid has to find the same neighbors as a linear search
+// (see test/benchmark_GridNearestNeighbors.cpp for the runtime comparison).
+BOOST_AUTO_TEST_CASE(ompl_grid_nearest_neighbors)
+{
+    ompl::base::StateSpacePtr space(new ompl::base::RealVectorStateSpace(2));
+    ompl::base::RealVectorBounds bounds(2);
+    bounds.setLow(0);
+    bounds.setHigh(100);
+    space->as<ompl::base::RealVectorStateSpace>()->setBounds(bounds);
+    ompl::base::StateSamplerPtr sampler = space->allocStateSampler();
+    
+    std::vector<NNMotion*> motions(2000);
+    ompl::NearestNeighborsLinear<NNMotion*> linear;
+    linear.setDistanceFunction(boost::bind(&nnMotionDistance, space, _1, _2));
+    XYGridNearestNeighbors<NNMotion*> grid;
+    grid.setDistanceFunction(boost::bind(&nnMotionDistance, space, _1, _2));
+    for(unsigned int m=0; m<motions.size(); ++m) {
+        motions[m] = new NNMotion();
+        motions[m]->state = space->allocState();
+        sampler->sampleUniform(motions[m]->state);
+        linear.add(motions[m]);
+        grid.add(motions[m]);
+    }
+    BOOST_CHECK_EQUAL(grid.size(), motions.size());
+    
+    NNMotion query;
+    query.state = space->allocState();
+    std::vector<NNMotion*> nbh_linear, nbh_grid;
+    for(unsigned int q=0; q<50; ++q) {
+        sampler->sampleUniform(query.state);
+        linear.nearestK(&query, 10, nbh_linear);
+        grid.nearestK(&query, 10, nbh_grid);
+        BOOST_CHECK(nnDistances(space, &query, nbh_linear) == nnDistances(space, &query, nbh_grid));
+        linear.nearestR(&query, 5.0, nbh_linear);
+        grid.nearestR(&query, 5.0, nbh_grid);
+        BOOST_CHECK(nnDistances(space, &query, nbh_linear) == nnDistances(space, &query, nbh_grid));
+        BOOST_CHECK(grid.nearest(&query) == linear.nearest(&query));
+    }
+    
+    // Removed motions must not be found anymore.
+    NNMotion* removed = motions.back();
+    motions.pop_back();
+    BOOST_CHECK(grid.remove(removed));
+    BOOST_CHECK(grid.nearest(removed) != removed);
+    space->freeState(removed->state);
+    delete removed;
+    
+    space->freeState(query.state);
+    for(unsigned int m=0; m<motions.size(); ++m) {
+        space->freeState(motions[m]->state);
+        delete motions[m];
+    }
+}
+
+// Blocks 90% of the map, all free cell samples have to be valid and the
+// better driveable cells have to be sampled more often.
+BOOST_AUTO_TEST_CASE(ompl_xy_free_cell_sampling)
+{
+    conf.mEnvType = ENV_XY;
+    trav->setTraversabilityClass(2, envire::TraversabilityClass(1.0));
+    for(int y=0; y<100; ++y) {
+        for(int x=0; x<100; ++x) {
+            (*trav_data)[y][x] = x < 90 ? 1 : (y < 50 ? 0 : 2);
+        }
+    }
+    
+    ompl::base::StateSpacePtr space(new ompl::base::RealVectorStateSpace(2));
+    ompl::base::RealVectorBounds bounds(2);
+    bounds.setLow(0);
+    bounds.setHigh(100);
+    space->as<ompl::base::RealVectorStateSpace>()->setBounds(bounds);
+    ompl::base::SpaceInformationPtr si(new ompl::base::SpaceInformation(space));
+    si->setStateValidityChecker(ompl::base::StateValidityCheckerPtr(
+            new TravMapValidator(si, trav, trav_data, conf)));
+    
+    boost::shared_ptr<FreeCellTable> free_cells(new FreeCellTable());
+    BOOST_REQUIRE(free_cells->create(si, trav, trav_data, conf));
+    BOOST_CHECK_EQUAL(free_cells->getNumCells(), 1000);
+    
+    FreeCellStateSampler sampler(space.get(), ENV_XY, free_cells);
+    ompl::base::State* state = space->allocState();
+    unsigned int num_invalid = 0, num_good_cells = 0;
+    const unsigned int num_samples = 100000;
+    for(unsigned int i=0; i<num_samples; ++i) {
+        sampler.sampleUniform(state);
+        if(!si->isValid(state)) {
+            num_invalid++;
+        }
+        if(state->as<ompl::base::RealVectorStateSpace::StateType>()->values[1] >= 50) {
+            num_good_cells++;
+        }
+    }
+    space->freeState(state);
+    BOOST_CHECK_EQUAL(num_invalid, 0);
+    // Driveability 1.0 vs 0.5: two thirds of the samples.
+    BOOST_CHECK_CLOSE(num_good_cells / (double)num_samples, 2/3.0, 2.0);
+    
+    // Planning through the free corridor.
+    conf.mPlanningLibType = LIB_OMPL;
+    rbs_start.setPose(base::Pose(base::Position(9.2,1,0), base::Orientation::Identity()));
+    rbs_goal.setPose(base::Pose(base::Position(9.8,9,0), base::Orientation::Identity()));
+    bool free_cell_sampling[] = {false, true};
+    for(unsigned int i=0; i<2; ++i) {
+        conf.mOmplFreeCellSampling = free_cell_sampling[i];
+        MotionPlanningLibraries ompl(conf);
+        ompl.setTravGrid(env, "/trav_map");
+        ompl.setStartState(State(rbs_start));
+        ompl.setGoalState(State(rbs_goal));
+        
+        base::Time start_time = base::Time::now();
+        double cost = 0.0;
+        BOOST_CHECK(ompl.plan(10.0, cost));
+        std::cout << "Free cell sampling " << free_cell_sampling[i] << ": solution after " << 
+                (base::Time::now() - start_time).toSeconds() << " sec, cost " << cost << std::endl;
+    }
+}
+
+// Random obstacles: The footprint classes sampled by the free cell sampler have to
+// fit into the sampled cells, in contrast to the default uniform samples.
+BOOST_AUTO_TEST_CASE(ompl_sherpa_footprint_class_sampling)
+{
+    conf.mEnvType = ENV_SHERPA;
+    conf.mFootprintRadiusMinMax = std::pair<double,double>(0.2, 1.0);
+    conf.mNumFootprintClasses = 10;
+    srand(0);
+    for(int y=0; y<100; ++y) {
+        for(int x=0; x<100; ++x) {
+            (*trav_data)[y][x] = rand() % 100 < 2 ? 1 : 0;
+        }
+    }
+    
+    SherpaStateSpace* sherpa_space = new SherpaStateSpace(conf);
+    ompl::base::RealVectorBounds bounds(2);
+    bounds.setLow(0);
+    bounds.setHigh(100);
+    sherpa_space->setBounds(bounds);
+    ompl::base::StateSpacePtr space(sherpa_space);
+    ompl::base::SpaceInformationPtr si(new ompl::base::SpaceInformation(space));
+    si->setStateValidityChecker(ompl::base::StateValidityCheckerPtr(
+            new TravMapValidator(si, trav, trav_data, conf)));
+    
+    boost::shared_ptr<FreeCellTable> free_cells(new FreeCellTable());
+    BOOST_REQUIRE(free_cells->create(si, trav, trav_data, conf));
+    FreeCellStateSampler free_cell_sampler(space.get(), ENV_SHERPA, free_cells);
+    ompl::base::StateSamplerPtr default_sampler = space->allocDefaultStateSampler();
+    
+    ompl::base::State* state = space->allocState();
+    const unsigned int num_samples = 100000;
+    for(unsigned int s=0; s<2; ++s) {
+        unsigned int num_invalid = 0;
+        double class_sum = 0;
+        for(unsigned int i=0; i<num_samples; ++i) {
+            if(s == 0) {
+                default_sampler->sampleUniform(state);
+            } else {
+                free_cell_sampler.sampleUniform(state);
+            }
+            if(!si->isValid(state)) {
+                num_invalid++;
+            }
+            class_sum += state->as<SherpaStateSpace::StateType>()->getFootprintClass();
+        }
+        if(s == 1) {
+            BOOST_CHECK_EQUAL(num_invalid, 0);
+        }
+        std::cout << (s == 0 ? "Uniform" : "Free cell") << " sampling: " << 
+                num_invalid * 100.0 / num_samples << "% invalid, mean footprint class " << 
+                class_sum / num_samples << std::endl;
+    }
+    space->freeState(state);
+}
+
+// The planning must not block the caller and a canceled planning
+// has to keep the solution which has been found so far.
+BOOST_AUTO_TEST_CASE(ompl_sbpl_xy_plan_async)
+{
+    conf.mSearchUntilFirstSolution = false;
+    conf.mFootprintRadiusMinMax = std::pair<double,double>(0.2, 0.2);
+    enum PlanningLibraryType libs[] = {LIB_OMPL, LIB_SBPL};
+    for(unsigned int i=0; i<2; ++i) {
+        conf.mPlanningLibType = libs[i];
+        conf.mEnvType = ENV_XY;
+        MotionPlanningLibraries mpl(conf);
+        mpl.setTravGrid(env, "/trav_map");
+        mpl.setStartState(State(rbs_start));
+        mpl.setGoalState(State(rbs_goal));
+        
+        base::Time start_time = base::Time::now();
+        boost::shared_ptr<PlanningHandle> handle = mpl.planAsync(30.0);
+        BOOST_REQUIRE(handle);
+        BOOST_CHECK((base::Time::now() - start_time).toSeconds() < 0.1);
+        BOOST_CHECK(!mpl.planAsync(1.0));
+        
+        // Polls like a component loop until the first solution is available.
+        std::vector<State> path;
+        double cost = 0.0;
+        while(!handle->getLatestSolution(path, cost) && !handle->isDone()) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+        }
+        PlanningProgress progress = handle->getProgress();
+        std::cout << "Library " << libs[i] << ": first solution after " << 
+                progress.mElapsedTime << " sec, cost " << progress.mCost << 
+                ", epsilon " << progress.mEpsilon << 
+                ", expansions " << progress.mNumExpansions << std::endl;
+        if(libs[i] == LIB_OMPL) {
+            BOOST_CHECK_EQUAL(progress.mNumExpansions, -1);
+        }
+        
+        // SBPL reports its expansions after each time slice, not only with a new solution.
+        if(libs[i] == LIB_SBPL && progress.mNumExpansions >= 0) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(300));
+            PlanningProgress later_progress = handle->getProgress();
+            BOOST_CHECK(later_progress.mElapsedTime > progress.mElapsedTime);
+            if(later_progress.mRunning) {
+                BOOST_CHECK(later_progress.mNumExpansions > progress.mNumExpansions);
+            }
+        }
+        
+        handle->cancel();
+        base::Time cancel_time = base::Time::now();
+        bool solved = false;
+        enum MplErrors error = MPL_ERR_NONE;
+        while(!handle->tryGetResult(solved, cost, error)) {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        }
+        double cancel_delay = (base::Time::now() - cancel_time).toSeconds();
+        std::cout << "Planning stopped " << cancel_delay << " sec after the cancel request" << std::endl;
+        BOOST_CHECK(cancel_delay < 1.0);
+        BOOST_CHECK(solved);
+        BOOST_CHECK_EQUAL(error, MPL_ERR_NONE);
+        BOOST_CHECK(!mpl.getStatesInWorld().empty());
+        BOOST_CHECK(!handle->getProgress().mRunning);
+    }
+}
+
+// Start poses posted with 100 Hz during an asynchronous planning must not
+// wait for the search, the latest one has to be used by the next plan() call.
+BOOST_AUTO_TEST_CASE(sbpl_xy_posted_inputs)
+{
+    // Mailbox: Fetched values have to be complete and increasing.
+    Mailbox<std::pair<int,int> > mailbox;
+    const int num_values = 1000000;
+    boost::thread producer(boost::bind(&postMailboxValues, &mailbox, num_values));
+    std::pair<int,int> value(0, 0);
+    int last_value = 0;
+    unsigned int num_fetched = 0;
+    while(last_value < num_values) {
+        if(mailbox.fetch(value)) {
+            BOOST_REQUIRE(value.first > last_value);
+            BOOST_REQUIRE_EQUAL(value.first, -value.second);
+            last_value = value.first;
+            num_fetched++;
+        }
+    }
+    producer.join();
+    BOOST_CHECK(!mailbox.fetch(value));
+    std::cout << num_fetched << " of " << num_values << " posted values have been fetched" << std::endl;
+    
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XY;
+    conf.mSearchUntilFirstSolution = false;
+    conf.mReplanning.mReplanOnNewStartPose = true;
+    conf.mFootprintRadiusMinMax = std::pair<double,double>(0.2, 0.2);
+    MotionPlanningLibraries sbpl(conf);
+    sbpl.postTravGrid(env, "/trav_map");
+    sbpl.postGoalState(State(rbs_goal));
+    sbpl.postStartState(State(rbs_start));
+    
+    boost::shared_ptr<PlanningHandle> handle = sbpl.planAsync(1.0);
+    BOOST_REQUIRE(handle);
+    double max_post_time = 0.0;
+    for(int i=1; !handle->isDone(); ++i) {
+        rbs_start.position = base::Position(1 + i * 0.01, 1, 0);
+        base::Time post_time = base::Time::now();
+        sbpl.postStartState(State(rbs_start));
+        max_post_time = std::max(max_post_time, (base::Time::now() - post_time).toSeconds());
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    std::cout << "Max time to post a start state " << max_post_time << " sec" << std::endl;
+    BOOST_CHECK(max_post_time < 0.01);
+    bool solved = false;
+    double cost = 0.0;
+    enum MplErrors error = MPL_ERR_NONE;
+    BOOST_REQUIRE(handle->tryGetResult(solved, cost, error));
+    BOOST_CHECK(solved);
+    
+    // The last posted start pose is used for the replanning.
+    BOOST_CHECK(sbpl.plan(1.0, cost));
+    BOOST_CHECK_SMALL(sbpl.getStatesInWorld().front().getPose().position.x() - 
+            rbs_start.position.x(), 0.15);
+}
+
+// Many goals from one start: Each reachable goal has to be solved by the
+// batch, a goal within an obstacle must not be solved.
+BOOST_AUTO_TEST_CASE(sbpl_xy_plan_batch)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XY;
+    conf.mFootprintRadiusMinMax = std::pair<double,double>(0.2, 0.2);
+    conf.mNumThreads = 4;
+    
+    GridCalculations calc;
+    calc.setTravGrid(trav, trav_data);
+    calc.setFootprintRectangleInGrid(10, 10);
+    calc.setFootprintPoseInGrid(50, 50, 0);
+    calc.setValue(1); // obstacle
+    
+    std::vector<State> goals;
+    for(int i=0; i<40; ++i) {
+        double angle = i * 2.0 * M_PI / 40.0;
+        rbs_goal.position = base::Position(5 + 4 * cos(angle), 5 + 4 * sin(angle), 0);
+        goals.push_back(State(rbs_goal));
+    }
+    rbs_goal.position = base::Position(5, 5, 0);
+    goals.push_back(State(rbs_goal));
+    rbs_start.position = base::Position(2, 5, 0);
+    
+    MotionPlanningLibraries sbpl(conf);
+    sbpl.setTravGrid(env, "/trav_map");
+    std::vector<BatchPlanningResult> results;
+    base::Time start_time = base::Time::now();
+    BOOST_REQUIRE(sbpl.planBatch(State(rbs_start), goals, 10.0, results));
+    double batch_time = (base::Time::now() - start_time).toSeconds();
+    BOOST_REQUIRE_EQUAL(results.size(), goals.size());
+    
+    for(unsigned int i=0; i<goals.size()-1; ++i) {
+        BOOST_CHECK(results[i].mSolved);
+        BOOST_CHECK_EQUAL(results[i].mError, MPL_ERR_NONE);
+        BOOST_REQUIRE(!results[i].mPathInWorld.empty());
+        double dist = (results[i].mPathInWorld.back().getPose().position - 
+                goals[i].getPose().position).head(2).norm();
+        // Contains the discretization error of its own goal.
+        BOOST_CHECK_SMALL(dist, 0.01);
+    }
+    BOOST_CHECK(!results.back().mSolved);
+    // One deadline for the batch including the initialization of the workers.
+    BOOST_CHECK(batch_time < 10.0 + 0.5);
+    BOOST_CHECK(results.back().mError != MPL_ERR_NONE);
+    
+    // Sequential reference using plan().
+    sbpl.setStartState(State(rbs_start));
+    double cost = 0.0;
+    start_time = base::Time::now();
+    for(unsigned int i=0; i<goals.size()-1; ++i) {
+        sbpl.setGoalState(goals[i]);
+        sbpl.plan(1.0, cost);
+    }
+    double sequential_time = (base::Time::now() - start_time).toSeconds();
+    std::cout << goals.size() << " goals: batch " << batch_time << 
+            " sec, sequential plan() " << sequential_time << " sec" << std::endl;
+}
+
+// Robots with different footprints share one preprocessed map: The map data
+// must not be copied per robot and the derived data is only created once.
+BOOST_AUTO_TEST_CASE(sbpl_ompl_shared_preprocessed_map)
+{
+    GridCalculations calc;
+    calc.setTravGrid(trav, trav_data);
+    calc.setFootprintRectangleInGrid(10, 10);
+    calc.setFootprintPoseInGrid(50, 50, 0);
+    calc.setValue(1); // obstacle
+    
+    base::Time start_time = base::Time::now();
+    boost::shared_ptr<const PreprocessedMap> preprocessed_map = PreprocessedMap::create(trav);
+    std::cout << "Map preprocessing " << (base::Time::now() - start_time).toSeconds() << 
+            " sec" << std::endl;
+    long use_count = preprocessed_map->getTravData().use_count();
+    
+    std::vector< boost::shared_ptr<MotionPlanningLibraries> > robots;
+    double radii[] = {0.1, 0.3, 0.5};
+    for(unsigned int i=0; i<3; ++i) {
+        conf.mPlanningLibType = LIB_SBPL;
+        conf.mEnvType = ENV_XY;
+        conf.mFootprintRadiusMinMax = std::pair<double,double>(radii[i], radii[i]);
+        robots.push_back(boost::shared_ptr<MotionPlanningLibraries>(
+                new MotionPlanningLibraries(conf)));
+    }
+    conf.mPlanningLibType = LIB_OMPL;
+    conf.mEnvType = ENV_SHERPA;
+    conf.mFootprintRadiusMinMax = std::pair<double,double>(0.2, 1.0);
+    conf.mNumFootprintClasses = 10;
+    conf.mOmplFreeCellSampling = true;
+    robots.push_back(boost::shared_ptr<MotionPlanningLibraries>(new MotionPlanningLibraries(conf)));
+    
+    for(unsigned int i=0; i<robots.size(); ++i) {
+        start_time = base::Time::now();
+        BOOST_REQUIRE(robots[i]->setPreprocessedMap(preprocessed_map));
+        std::cout << "Robot " << i << " attached within " << 
+                (base::Time::now() - start_time).toSeconds() << " sec" << std::endl;
+        BOOST_CHECK(robots[i]->setStartState(State(rbs_start)));
+        BOOST_CHECK(robots[i]->setGoalState(State(rbs_goal)));
+        double cost = 0.0;
+        BOOST_CHECK(robots[i]->plan(5.0, cost));
+    }
+    
+    // The grid data is referenced, not copied.
+    BOOST_CHECK(preprocessed_map->getTravData().use_count() > use_count);
+    BOOST_CHECK_EQUAL(preprocessed_map->getCostMap(20).get(), preprocessed_map->getCostMap(20).get());
+    BOOST_CHECK_EQUAL(preprocessed_map->getObstacleDistances().get(), 
+            preprocessed_map->getObstacleDistances().get());
+    BOOST_CHECK_EQUAL(preprocessed_map->getMapId(), 
+            PreprocessedMap::createMapId(trav, preprocessed_map->getTravData()));
+}
+
+BOOST_AUTO_TEST_CASE(sbpl_xy_cached_frame_transforms)
+{
+    // Grid frame rotated by 90 degree and shifted, start and goal stay within the grid.
+    Eigen::Affine3d local2world(Eigen::AngleAxisd(M_PI/2.0, Eigen::Vector3d::UnitZ()));
+    local2world.translation() = Eigen::Vector3d(10, 0, 0);
+    trav->getFrameNode()->setTransform(local2world);
+    
+    boost::shared_ptr<const PreprocessedMap> preprocessed_map = PreprocessedMap::create(trav);
+    BOOST_CHECK(preprocessed_map->getLocal2World().isApprox(local2world));
+    BOOST_CHECK(preprocessed_map->getWorld2Local().isApprox(local2world.inverse()));
+    
+    base::samples::RigidBodyState grid_tree, grid_cached;
+    BOOST_REQUIRE(MotionPlanningLibraries::world2grid(trav, rbs_goal, grid_tree));
+    BOOST_REQUIRE(MotionPlanningLibraries::world2grid(trav, preprocessed_map->getWorld2Local(), 
+            rbs_goal, grid_cached));
+    BOOST_CHECK(grid_tree.position.isApprox(grid_cached.position));
+    BOOST_CHECK(grid_tree.orientation.isApprox(grid_cached.orientation));
+    
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XY;
+    MotionPlanningLibraries sbpl(conf);
+    BOOST_REQUIRE(sbpl.setPreprocessedMap(preprocessed_map));
+    BOOST_CHECK(sbpl.setStartState(State(rbs_start)));
+    BOOST_CHECK(sbpl.setGoalState(State(rbs_goal)));
+    double cost = 0.0;
+    BOOST_REQUIRE(sbpl.plan(10.0, cost));
+    
+    // The whole path is converted at once, the end points match the world poses.
+    std::vector<struct State> path = sbpl.getStatesInWorld();
+    BOOST_REQUIRE(path.size() >= 2);
+    BOOST_CHECK((path.front().getPose().position - rbs_start.position).norm() < 0.2);
+    BOOST_CHECK((path.back().getPose().position - rbs_goal.position).norm() < 0.2);
+    
+    base::samples::RigidBodyState grid_start, world_start;
+    BOOST_REQUIRE(MotionPlanningLibraries::world2grid(trav, rbs_start, grid_start));
+    BOOST_REQUIRE(sbpl.grid2world(trav, grid_start, world_start));
+    BOOST_CHECK((world_start.position - path.front().getPose().position).norm() < 0.2);
+}
+
+BOOST_AUTO_TEST_CASE(sbpl_xy_replan_only_if_path_invalid)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XY;
+    conf.mSearchUntilFirstSolution = false;
+    conf.mReplanning.mReplanOnlyIfPathInvalid = true;
+    MotionPlanningLibraries sbpl(conf);
+    BOOST_REQUIRE(sbpl.setTravGrid(env, "/trav_map"));
+    BOOST_CHECK(sbpl.setStartState(State(rbs_start)));
+    BOOST_CHECK(sbpl.setGoalState(State(rbs_goal)));
+    double cost = 0.0;
+    BOOST_REQUIRE(sbpl.plan(10.0, cost));
+    BOOST_REQUIRE(sbpl.foundFinalSolution());
+    
+    // An obstacle far away from the path keeps the path.
+    GridCalculations calc;
+    calc.setTravGrid(trav, trav_data);
+    calc.setFootprintRectangleInGrid(4, 4);
+    calc.setFootprintPoseInGrid(90, 10, 0);
+    calc.setValue(1); // obstacle
+    trav->getGridData(envire::TraversabilityGrid::TRAVERSABILITY) = *trav_data;
+    BOOST_REQUIRE(sbpl.setTravGrid(env, "/trav_map"));
+    BOOST_CHECK(!sbpl.plan(10.0, cost));
+    BOOST_CHECK_EQUAL(sbpl.getError(), MPL_ERR_REPLANNING_NOT_REQUIRED);
+    
+    // An obstacle on the path initiates a replanning.
+    calc.setFootprintRectangleInGrid(10, 10);
+    calc.setFootprintPoseInGrid(50, 50, 0);
+    calc.setValue(1);
+    trav->getGridData(envire::TraversabilityGrid::TRAVERSABILITY) = *trav_data;
+    BOOST_REQUIRE(sbpl.setTravGrid(env, "/trav_map"));
+    BOOST_CHECK(sbpl.plan(10.0, cost));
+}
+
+BOOST_AUTO_TEST_CASE(sbpl_xytheta_receding_horizon)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XYTHETA;
+    conf.mMobility.mSpeed = 1.0;
+    conf.mMobility.mTurningSpeed = 0.5;
+    conf.mMobility.mMinTurningRadius = 0.5;
+    conf.mMobility.mMultiplierForward = 1;
+    conf.mMobility.mMultiplierForwardTurn = 2;
+    conf.mMobility.mMultiplierPointTurn = 4;
+    conf.mFootprintLengthMinMax = std::pair<double,double>(0.3, 0.3);
+    conf.mFootprintWidthMinMax = std::pair<double,double>(0.3, 0.3);
+    conf.mReplanning.mReplanOnNewStartPose = true;
+    
+    GridCalculations calc;
+    calc.setTravGrid(trav, trav_data);
+    calc.setFootprintRectangleInGrid(20, 20);
+    calc.setFootprintPoseInGrid(50, 50, 0);
+    calc.setValue(1); // obstacle
+    trav->getGridData(envire::TraversabilityGrid::TRAVERSABILITY) = *trav_data;
+    
+    double horizons[] = {0.0, 3.0};
+    for(unsigned int i=0; i<2; ++i) {
+        conf.mRecedingHorizon = horizons[i];
+        MotionPlanningLibraries sbpl(conf);
+        BOOST_REQUIRE(sbpl.setTravGrid(env, "/trav_map"));
+        BOOST_CHECK(sbpl.setStartState(State(rbs_start)));
+        BOOST_CHECK(sbpl.setGoalState(State(rbs_goal)));
+        
+        double cost = 0.0;
+        base::Time start_time = base::Time::now();
+        BOOST_REQUIRE(sbpl.plan(10, cost));
+        double planning_time = (base::Time::now() - start_time).toSeconds();
+        
+        // The coarse part reaches the goal.
+        std::vector<struct State> path = sbpl.getStatesInWorld();
+        BOOST_REQUIRE(path.size() > 1);
+        BOOST_CHECK((path.back().getPose().position - rbs_goal.position).head(2).norm() < 0.2);
+        std::cout << "Receding horizon " << horizons[i] << " m: " << planning_time << 
+                " sec, expansions " << sbpl.getNumExpansions() << ", states " << 
+                path.size() << std::endl;
+        
+        // The horizon goal is kept for a start within the first half of the 
+        // horizon, the path still has to reach the goal.
+        base::samples::RigidBodyState rbs_robot = rbs_start;
+        rbs_robot.position += base::Position(0.3, 0.3, 0);
+        BOOST_CHECK(sbpl.setStartState(State(rbs_robot)));
+        BOOST_REQUIRE(sbpl.plan(10, cost));
+        path = sbpl.getStatesInWorld();
+        BOOST_REQUIRE(path.size() > 1);
+        BOOST_CHECK((path.back().getPose().position - rbs_goal.position).head(2).norm() < 0.2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sbpl_xytheta_compact_path)
+{
+    conf.mPlanningLibType = LIB_SBPL;
+    conf.mEnvType = ENV_XYTHETA;
+    conf.mMobility.mSpeed = 1.0;
+    conf.mMobility.mTurningSpeed = 0.5;
+    conf.mMobility.mMinTurningRadius = 0.5;
+    conf.mMobility.mMultiplierForward = 1;
+    conf.mMobility.mMultiplierForwardTurn = 2;
+    conf.mMobility.mMultiplierPointTurn = 4;
+    conf.mFootprintLengthMinMax = std::pair<double,double>(0.3, 0.3);
+    conf.mFootprintWidthMinMax = std::pair<double,double>(0.3, 0.3);
+    MotionPlanningLibraries sbpl(conf);
+    BOOST_REQUIRE(sbpl.setTravGrid(env, "/trav_map"));
+    BOOST_CHECK(sbpl.setStartState(State(rbs_start)));
+    BOOST_CHECK(sbpl.setGoalState(State(rbs_goal)));
+    double cost = 0.0;
+    BOOST_REQUIRE(sbpl.plan(10, cost));
+    
+    // The states and waypoints are created from the compact path.
+    const CompactPath& compact_path = sbpl.getCompactPathInWorld();
+    std::vector<struct State> states = sbpl.getStatesInWorld();
+    std::vector<base::Waypoint> waypoints = sbpl.getPathInWorld();
+    BOOST_REQUIRE(compact_path.size() > 0);
+    BOOST_REQUIRE_EQUAL(compact_path.size(), states.size());
+    BOOST_REQUIRE_EQUAL(compact_path.size(), waypoints.size());
+    for(unsigned int i=0; i<states.size(); ++i) {
+        BOOST_CHECK(states[i].getPose().position.isApprox(compact_path.getPosition(i)));
+        BOOST_CHECK_CLOSE(states[i].getPose().getYaw() + 10.0, compact_path.mTheta[i] + 10.0, 1e-6);
+        BOOST_CHECK_EQUAL(states[i].mSBPLPrimId, compact_path.mSBPLPrimId[i]);
+        BOOST_CHECK_EQUAL(states[i].mMovType, compact_path.mMovType[i]);
+        BOOST_CHECK((waypoints[i].position - compact_path.getPosition(i)).norm() < 1e-9);
+    }
+    
+    // Round trip of a single state.
+    CompactPath path;
+    State state = states.back();
+    path.push_back(state);
+    BOOST_CHECK_EQUAL(path.size(), 1u);
+    BOOST_CHECK(path.getState(0).getPose().position.isApprox(state.getPose().position));
+}
+
 #if 0
 
 BOOST_AUTO_TEST_CASE(helper_rectangle)